@@ -0,0 +1,4 @@
+# vi: fenc=utf8
+# qmake bench/bench.pro && make, then run build/release/bench_* from bench directories
+TEMPLATE = subdirs
+SUBDIRS = walker conf
@@ -0,0 +1,152 @@
+#include "pg_conf_lexer.h"
+
+#include <QCoreApplication>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QHash>
+#include <QRegularExpression>
+#include <QTextStream>
+
+////////////////////////////////////////////////////////////////////////////////
+
+namespace
+{
+	/** postgresql.conf-like file: active and commented out assignments of every kind of
+		value, prose comments and blank lines */
+	bool generate(const QString& path, int lines)
+	{
+		QFile file{ path };
+		if (!file.open(QIODevice::WriteOnly | QIODevice::Text))
+			return false;
+		QTextStream out{ &file };
+		for (int i = 0; i < lines; ++i)
+			switch (i % 8)
+			{
+			case 0:
+				out << "# - Section " << i << " -\n";
+				break;
+			case 1:
+				out << "shared_buffers_" << i << " = 128MB\t\t\t# min 128kB\n";
+				break;
+			case 2:
+				out << "#work_mem_" << i << " = 4MB\t\t\t\t# (change requires restart)\n";
+				break;
+			case 3:
+				out << "log_line_prefix_" << i << " = '%m [%p] %q%u@%d '\t\t# special values:\n";
+				break;
+			case 4:
+				out << "\n";
+				break;
+			case 5:
+				out << "fsync_" << i << " = on\n";
+				break;
+			case 6:
+				out << "#\t%d = database name, value of this line isnt parameter\n";
+				break;
+			case 7:
+				out << "#wal_level_" << i << " = replica\t\t\t# minimal, replica, or logical\n";
+				break;
+			}
+		return true;
+	}
+
+	/** Configuration::load before ConfLexer, two regular expressions per line */
+	QHash<QString, QString> parseRegex(const QString& path)
+	{
+		QHash<QString, QString> result;
+		QFile file{ path };
+		if (!file.open(QIODevice::ReadOnly | QIODevice::Text))
+			return result;
+		static const QRegularExpression lineExpr{
+			"^\\s{0,2}(#?)\\s*([\\w\\d_]+)" // line begin. capture comment, if exists
+			"(?:(?:\\s*(=)\\s*)|(?:\\s+))"  // no capture. Conf's separator can be '=' or space character
+			"("                             // begin values matching
+			"(?:[+-]?[\\d\\.]+[\\w]*)"      // integers and units
+			"|(?:'(?:[^']*'))"              // string
+			"|(?:on|off|true|false|yes|no)" // boolean
+			"|(?:[\\w_]+)"                  // enums
+			")"                             // end values matching
+			"(.*)$"                         // rest of line
+		},
+			restExpr{ "^((?:\\s+$)|(?:\\s*#.+$)|(?:$))" };
+		while (!file.atEnd())
+		{
+			const QString line = file.readLine();
+			if (line.isEmpty())
+				continue;
+			const auto match = lineExpr.match(line);
+			if (!match.hasMatch())
+				continue;
+			if (match.captured(1) == "#" && (match.captured(3) != "=" || !restExpr.match(match.captured(5)).hasMatch()))
+				continue;
+			result[match.captured(2)] = match.captured(4);
+		}
+		result.remove("d");
+		result.remove("value");
+		return result;
+	}
+
+	/** what Configuration::parse does now: file read once, only accepted views are decoded */
+	QHash<QString, QString> parseLexer(const QString& path)
+	{
+		QHash<QString, QString> result;
+		QFile file{ path };
+		if (!file.open(QIODevice::ReadOnly))
+			return result;
+		const QByteArray data = file.readAll();
+		pg::ConfLexer lexer{ data.constData(), static_cast<size_t>(data.size()) };
+		pg::ConfLexer::Entry entry;
+		while (lexer.next(entry))
+			result[QString::fromUtf8(data.constData() + entry.key.offset, static_cast<int>(entry.key.size))] =
+				QString::fromUtf8(data.constData() + entry.value.offset, static_cast<int>(entry.value.size));
+		return result;
+	}
+
+	/** best of runs, ms */
+	template <typename F>
+	double best(int runs, F f, int& size)
+	{
+		double result = -1;
+		for (int i = 0; i < runs; ++i)
+		{
+			QElapsedTimer timer;
+			timer.start();
+			size = f().size();
+			const double ms = timer.nsecsElapsed() / 1e6;
+			if (result < 0 || ms < result)
+				result = ms;
+		}
+		return result;
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+/** bench_conf [lines [runs]]: fails unless lexer is 20 times faster than regular expressions */
+int main(int argc, char* argv[])
+{
+	QCoreApplication app{ argc, argv };
+	const QStringList args = app.arguments();
+	const int lines = args.value(1, "100000").toInt();
+	const int runs = qMax(1, args.value(2, "5").toInt());
+	const QString path = QDir::temp().filePath("qt_chooser_conf_bench.conf");
+	QTextStream out{ stdout };
+	if (lines <= 0 || !generate(path, lines))
+	{
+		out << "cant write " << path << endl;
+		return 1;
+	}
+
+	int regexSize = 0, lexerSize = 0;
+	const double regex = best(runs, [&path]() { return parseRegex(path); }, regexSize);
+	const double lexer = best(runs, [&path]() { return parseLexer(path); }, lexerSize);
+	QFile::remove(path);
+
+	const double speedup = lexer > 0 ? regex / lexer : 0;
+	out << lines << " lines, best of " << runs << endl;
+	out << "regular expressions: " << regex << " ms, " << regexSize << " parameters" << endl;
+	out << "ConfLexer: " << lexer << " ms, " << lexerSize << " parameters" << endl;
+	out << "speedup " << speedup << "x (target 20x)" << endl;
+	return speedup >= 20 ? 0 : 1;
+}
@@ -0,0 +1,22 @@
+# vi: fenc=utf8
+TEMPLATE = app
+QT += core
+QT -= gui
+TARGET = bench_conf
+
+CONFIG -= debug_and_release debug_and_release_target
+CONFIG += release c++17 console
+
+DEFINES += QT_DEPRECATED_WARNINGS
+
+INCLUDEPATH += ../../src
+SOURCES += \
+			../../src/pg_conf_lexer.cpp \
+			bench_conf.cpp
+
+HEADERS += \
+			../../src/pg_conf_lexer.h
+
+DESTDIR = build/release
+OBJECTS_DIR = $$DESTDIR/.obj
+MOC_DIR = $$DESTDIR/.moc
@@ -0,0 +1,115 @@
+#include "directory_walker.h"
+
+#include <QCoreApplication>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QTextStream>
+
+#include <atomic>
+
+////////////////////////////////////////////////////////////////////////////////
+
+namespace
+{
+	/** fan^3 directories below root, every 1000th leaf holds PG_VERSION. tree is kept
+		between runs, building it takes longer than walking it */
+	bool build(const QString& root, int fan)
+	{
+		const QString done = QDir{ root }.filePath(QString{ ".bench_tree_%1" }.arg(fan));
+		if (QFileInfo::exists(done))
+			return true;
+		QTextStream out{ stdout };
+		out << "building tree of " << qint64{ fan } * fan * fan << " directories in " << root << endl;
+		int leaf = 0;
+		for (int a = 0; a < fan; ++a)
+			for (int b = 0; b < fan; ++b)
+			{
+				const QString parent = QString{ "%1/a%2/b%3" }.arg(root).arg(a).arg(b);
+				if (!QDir{}.mkpath(parent))
+					return false;
+				QDir dir{ parent };
+				for (int c = 0; c < fan; ++c, ++leaf)
+				{
+					const QString name = QString{ "c%1" }.arg(c);
+					if (!dir.exists(name) && !dir.mkdir(name))
+						return false;
+					if (leaf % 1000 == 0)
+					{
+						QFile marker{ dir.filePath(name + "/PG_VERSION") };
+						marker.open(QIODevice::WriteOnly);
+					}
+				}
+			}
+		QFile file{ done };
+		return file.open(QIODevice::WriteOnly);
+	}
+
+	/** walk as PGCluster::enumerate did before DirectoryWalker: entryList and QFileInfo of every
+		entry, one thread */
+	void recurse(const QString& path, qint64& directories, qint64& marked)
+	{
+		++directories;
+		QStringList dirs;
+		for (const auto& entry : QDir{ path }.entryList())
+		{
+			const QFileInfo info{ QString{ "%1/%2" }.arg(path).arg(entry) };
+			if (info.isFile() && entry == "PG_VERSION")
+			{
+				++marked;
+				return;
+			}
+			if (info.isDir() && entry != "." && entry != "..")
+				dirs.push_back(entry);
+		}
+		for (const auto& entry : dirs)
+			recurse(QString{ "%1/%2" }.arg(path).arg(entry), directories, marked);
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+/** bench_walker [root [fan]]: fan 100 is about 1M directories */
+int main(int argc, char* argv[])
+{
+	QCoreApplication app{ argc, argv };
+	const QStringList args = app.arguments();
+	const QString root = QDir{ args.value(1, QDir::temp().filePath("qt_chooser_walker_bench")) }.absolutePath();
+	const int fan = args.value(2, "100").toInt();
+	QTextStream out{ stdout };
+	if (fan <= 0 || !build(root, fan))
+	{
+		out << "cant build tree in " << root << endl;
+		return 1;
+	}
+
+	std::atomic<qint64> directories{ 0 }, marked{ 0 };
+	const auto walk = [&]() {
+		directories = marked = 0;
+		tool::DirectoryWalker walker{ tool::DirectoryWalker::Options{ -1, QStringList{}, "PG_VERSION" } };
+		walker.walk(QStringList{ root }, [&](const tool::DirectoryWalker::Directory& d) {
+			++directories;
+			if (d.marked)
+				++marked;
+			return d.marked;
+		});
+	};
+	// first pass only fills dentry cache, both timed walks run warm
+	walk();
+	QElapsedTimer timer;
+	timer.start();
+	walk();
+	const qint64 parallel = timer.restart();
+	out << "DirectoryWalker: " << directories.load() << " directories, " << marked.load() << " marked, "
+		<< parallel << " ms" << endl;
+
+	qint64 serialDirectories = 0, serialMarked = 0;
+	recurse(root, serialDirectories, serialMarked);
+	const qint64 serial = timer.elapsed();
+	out << "entryList recursion: " << serialDirectories << " directories, " << serialMarked << " marked, "
+		<< serial << " ms" << endl;
+	out << "speedup " << (parallel > 0 ? static_cast<double>(serial) / parallel : 0.0) << "x" << endl;
+	// both walks stop at marked directories, so they must agree
+	return (directories == serialDirectories && marked == serialMarked) ? 0 : 1;
+}
@@ -1,13 +1,14 @@
 # vi: fenc=utf8
 TEMPLATE = app
-QT += widgets gui core core-private axcontainer
+QT += widgets gui core
+win32: QT += core-private axcontainer
 TARGET = ../qt_chooser
 
 
 # CONFIG -= qt debug_and_release debug_and_release_target
 CONFIG -= debug_and_release debug_and_release_target
 # CONFIG += console debug
-CONFIG += release
+CONFIG += release c++17
 # CONFIG += console
 
 DEFINES += QT_DEPRECATED_WARNINGS
@@ -38,5 +39,4 @@ win32: QMAKE_CXXFLAGS_RELEASE -= -Zc:strictStrings
 win32: QMAKE_CFLAGS_RELEASE -= -Zc:strictStrings
 win32: QMAKE_CFLAGS -= -Zc:strictStrings
 win32: QMAKE_CXXFLAGS -= -Zc:strictStrings
-QMAKE_CXXFLAGS_RELEASE += /std:c++17
 
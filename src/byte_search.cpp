@@ -0,0 +1,69 @@
+#include "byte_search.h"
+
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#	define TOOL_BYTE_SEARCH_SSE2
+#	include <emmintrin.h>
+#endif
+
+namespace tool
+{
+	////////////////////////////////////////////////////////////////////////////////
+
+	namespace
+	{
+		const char* scalarFind(const char* haystack, size_t size, const char* needle, size_t length)
+		{
+			const char* const last = haystack + size - length;
+			for (const char* p = haystack; p <= last; ++p)
+			{
+				p = static_cast<const char*>(std::memchr(p, needle[0], static_cast<size_t>(last - p) + 1));
+				if (p == nullptr)
+					return nullptr;
+				if (std::memcmp(p + 1, needle + 1, length - 1) == 0)
+					return p;
+			}
+			return nullptr;
+		}
+	} // namespace
+
+	const char* findBytes(const char* haystack, size_t size, const char* needle, size_t length)
+	{
+		if (length == 0)
+			return haystack;
+		if (length > size)
+			return nullptr;
+		if (length == 1)
+			return static_cast<const char*>(std::memchr(haystack, needle[0], size));
+
+#ifdef TOOL_BYTE_SEARCH_SSE2
+		// candidates are positions where both first and last byte of needle match
+		const __m128i first = _mm_set1_epi8(needle[0]);
+		const __m128i last = _mm_set1_epi8(needle[length - 1]);
+		size_t i = 0;
+		for (; i + length - 1 + 16 <= size; i += 16)
+		{
+			const __m128i head = _mm_loadu_si128(reinterpret_cast<const __m128i*>(haystack + i));
+			const __m128i tail = _mm_loadu_si128(reinterpret_cast<const __m128i*>(haystack + i + length - 1));
+			unsigned mask = static_cast<unsigned>(_mm_movemask_epi8(
+				_mm_and_si128(_mm_cmpeq_epi8(head, first), _mm_cmpeq_epi8(tail, last))));
+			while (mask != 0)
+			{
+				unsigned bit = 0;
+				while ((mask & (1u << bit)) == 0)
+					++bit;
+				if (std::memcmp(haystack + i + bit + 1, needle + 1, length - 2) == 0)
+					return haystack + i + bit;
+				mask &= mask - 1;
+			}
+		}
+		return scalarFind(haystack + i, size - i, needle, length);
+#else
+		return scalarFind(haystack, size, needle, length);
+#endif
+	}
+
+	////////////////////////////////////////////////////////////////////////////////
+
+} /* namespace tool */
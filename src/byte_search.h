@@ -0,0 +1,14 @@
+#pragma once
+#include <cstddef>
+
+namespace tool
+{
+	////////////////////////////////////////////////////////////////////////////////
+
+	/** memmem: first occurrence of needle in haystack, nullptr if there is none.
+		with sse2 16 positions are filtered at once by first and last needle bytes */
+	const char* findBytes(const char* haystack, size_t size, const char* needle, size_t length);
+
+	////////////////////////////////////////////////////////////////////////////////
+
+} /* namespace tool */
@@ -0,0 +1,222 @@
+#include "command_line.h"
+
+#include <QRegularExpression>
+
+namespace tool
+{
+	////////////////////////////////////////////////////////////////////////////////
+
+	CommandLine::CommandLine(const QString& line, Syntax syntax)
+		: m_arguments(syntax == Windows ? splitWindows(line) : splitPosix(line))
+	{
+		if (m_arguments.isEmpty())
+			return;
+		static const QRegularExpression binary{ "\\.(exe|dll|sys)$", QRegularExpression::CaseInsensitiveOption };
+		if (syntax == Windows && !line.trimmed().startsWith('"') && !binary.match(m_arguments.front()).hasMatch())
+		{ // SCM accepts unquoted program path with spaces ("c:/program files/x/svc.exe -k")
+			QString program = m_arguments.front();
+			for (int i = 1; i < m_arguments.size(); ++i)
+			{
+				program += ' ' + m_arguments[i];
+				if (binary.match(program).hasMatch())
+				{
+					m_arguments.erase(m_arguments.begin() + 1, m_arguments.begin() + i + 1);
+					m_arguments.front() = program;
+					break;
+				}
+			}
+		}
+
+		m_program = QString{ m_arguments.front() }.replace('\\', '/');
+		const int slash = m_program.lastIndexOf('/');
+		m_programName = m_program.mid(slash + 1);
+		m_programDirectory = m_program.left(slash + 1);
+		for (int i = 1; i < m_arguments.size(); ++i)
+			if (!m_options.contains(m_arguments[i]))
+				m_options.insert(m_arguments[i], i);
+	}
+
+	const QStringList& CommandLine::arguments() const
+	{
+		return m_arguments;
+	}
+
+	const QString& CommandLine::program() const
+	{
+		return m_program;
+	}
+
+	const QString& CommandLine::programName() const
+	{
+		return m_programName;
+	}
+
+	const QString& CommandLine::programDirectory() const
+	{
+		return m_programDirectory;
+	}
+
+	bool CommandLine::contains(const QString& option) const
+	{
+		return m_options.contains(option);
+	}
+
+	QString CommandLine::value(const QString& option) const
+	{
+		const int index = m_options.value(option, -1) + 1;
+		return (index > 0 && index < m_arguments.size()) ? m_arguments[index] : QString{};
+	}
+
+	QStringList CommandLine::splitWindows(const QString& line)
+	{
+		QStringList result;
+		const int n = line.size();
+		const auto space = [&line](int i) { return line[i] == ' ' || line[i] == '\t'; };
+		int i = 0;
+		while (i < n && space(i))
+			++i;
+		if (i == n)
+			return result;
+
+		// program name: quotes only delimit, backslashes are path separators
+		QString program;
+		if (line[i] == '"')
+		{
+			while (++i < n && line[i] != '"')
+				program += line[i];
+			++i;
+		}
+		else
+			while (i < n && !space(i))
+				program += line[i++];
+		result.push_back(program);
+
+		while (true)
+		{
+			while (i < n && space(i))
+				++i;
+			if (i >= n)
+				break;
+			QString arg;
+			bool quoted = false;
+			while (i < n && (quoted || !space(i)))
+			{
+				if (line[i] == '\\')
+				{ // 2n backslashes + quote: n backslashes and quote toggles, 2n+1: n backslashes and literal quote
+					int slashes = 0;
+					for (; i < n && line[i] == '\\'; ++i)
+						++slashes;
+					const bool beforeQuote = (i < n && line[i] == '"');
+					arg += QString(beforeQuote ? slashes / 2 : slashes, '\\');
+					if (beforeQuote && slashes % 2 != 0)
+						arg += line[i++];
+				}
+				else if (line[i] == '"')
+				{
+					if (quoted && i + 1 < n && line[i + 1] == '"')
+					{ // "" inside quotes is literal quote
+						arg += '"';
+						i += 2;
+					}
+					else
+					{
+						quoted = !quoted;
+						++i;
+					}
+				}
+				else
+					arg += line[i++];
+			}
+			result.push_back(arg);
+		}
+		return result;
+	}
+
+	QStringList CommandLine::splitPosix(const QString& line)
+	{
+		QStringList result;
+		QString arg;
+		bool started = false;
+		const int n = line.size();
+		for (int i = 0; i < n; ++i)
+		{
+			const QChar c = line[i];
+			if (c == '\'')
+			{
+				started = true;
+				while (++i < n && line[i] != '\'')
+					arg += line[i];
+			}
+			else if (c == '"')
+			{
+				started = true;
+				while (++i < n && line[i] != '"')
+				{
+					if (line[i] == '\\' && i + 1 < n && QString{ "\\\"$`\n" }.contains(line[i + 1]))
+						++i;
+					arg += line[i];
+				}
+			}
+			else if (c == '\\')
+			{
+				started = true;
+				if (i + 1 < n)
+					arg += line[++i];
+			}
+			else if (c.isSpace())
+			{
+				if (started)
+					result.push_back(arg);
+				arg.clear();
+				started = false;
+			}
+			else
+			{
+				started = true;
+				arg += c;
+			}
+		}
+		if (started)
+			result.push_back(arg);
+		return result;
+	}
+
+	QString CommandLine::join(const QStringList& arguments, Syntax syntax)
+	{
+		QStringList result;
+		for (const auto& arg : arguments)
+		{
+			if (syntax == Posix)
+			{
+				static const QRegularExpression safe{ "^[A-Za-z0-9_@%+=:,./-]+$" };
+				result.push_back(safe.match(arg).hasMatch() ? arg : QString{ "'%1'" }.arg(QString{ arg }.replace("'", "'\\''")));
+				continue;
+			}
+			if (!arg.isEmpty() && !arg.contains(QRegularExpression{ "[ \t\"]" }))
+			{
+				result.push_back(arg);
+				continue;
+			}
+			// backslashes are doubled only in front of quote, including closing one
+			QString quoted{ "\"" };
+			int slashes = 0;
+			for (const QChar c : arg)
+			{
+				if (c == '\\')
+				{
+					++slashes;
+					continue;
+				}
+				quoted += QString(c == '"' ? slashes * 2 + 1 : slashes, '\\');
+				quoted += c;
+				slashes = 0;
+			}
+			quoted += QString(slashes * 2, '\\');
+			result.push_back(quoted + '"');
+		}
+		return result.join(' ');
+	}
+
+	////////////////////////////////////////////////////////////////////////////////
+
+} /* namespace tool */
@@ -0,0 +1,54 @@
+#pragma once
+#include <QHash>
+#include <QStringList>
+
+namespace tool
+{
+	////////////////////////////////////////////////////////////////////////////////
+
+	/** command line parsed once into argv, with precomputed program parts and option lookup */
+	class CommandLine
+	{
+	public:
+		enum Syntax
+		{
+			Windows, // CommandLineToArgvW rules, program name without escapes
+			Posix,   // sh quoting: '...', "..." and backslash escapes
+#ifdef Q_OS_WIN
+			Native = Windows,
+#else
+			Native = Posix,
+#endif
+		};
+
+		CommandLine() = default;
+		explicit CommandLine(const QString&, Syntax = Native);
+
+		/** argv, program is first */
+		const QStringList& arguments() const;
+		/** program with '/' separators */
+		const QString& program() const;
+		const QString& programName() const;
+		/** with trailing '/', empty for bare program name */
+		const QString& programDirectory() const;
+
+		bool contains(const QString& option) const;
+		/** argument following option ("-D dir"), empty if option is absent */
+		QString value(const QString& option) const;
+
+		/** argv back to command line, quoted where needed */
+		static QString join(const QStringList&, Syntax = Native);
+
+	protected:
+		static QStringList splitWindows(const QString&);
+		static QStringList splitPosix(const QString&);
+
+	protected:
+		QStringList m_arguments;
+		QString m_program, m_programName, m_programDirectory;
+		QHash<QString, int> m_options; // first occurrence of option -> its index
+	};
+
+	////////////////////////////////////////////////////////////////////////////////
+
+} /* namespace tool */
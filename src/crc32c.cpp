@@ -0,0 +1,92 @@
+#include "crc32c.h"
+
+#include <array>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#	define TOOL_CRC32C_SSE42
+#	ifdef _MSC_VER
+#		include <intrin.h>
+#	else
+#		include <cpuid.h>
+#	endif
+#	include <nmmintrin.h>
+#endif
+
+namespace tool
+{
+	////////////////////////////////////////////////////////////////////////////////
+
+	namespace
+	{
+		const std::array<quint32, 256>& table()
+		{
+			static const auto result = []() {
+				std::array<quint32, 256> t{};
+				for (quint32 i = 0; i < 256; ++i)
+				{
+					quint32 c = i;
+					for (int k = 0; k < 8; ++k)
+						c = (c & 1) != 0 ? (c >> 1) ^ 0x82F63B78u : c >> 1; // reflected 0x1EDC6F41
+					t[i] = c;
+				}
+				return t;
+			}();
+			return result;
+		}
+
+		quint32 software(quint32 crc, const uchar* p, size_t size)
+		{
+			const auto& t = table();
+			while (size-- != 0)
+				crc = t[(crc ^ *p++) & 0xFF] ^ (crc >> 8);
+			return crc;
+		}
+
+#ifdef TOOL_CRC32C_SSE42
+		bool hasSse42()
+		{
+#	ifdef _MSC_VER
+			int info[4];
+			__cpuid(info, 1);
+			return (info[2] & (1 << 20)) != 0;
+#	else
+			unsigned a, b, c, d;
+			return __get_cpuid(1, &a, &b, &c, &d) != 0 && (c & bit_SSE4_2) != 0;
+#	endif
+		}
+
+#	ifndef _MSC_VER
+		__attribute__((target("sse4.2")))
+#	endif
+		quint32 hardware(quint32 crc, const uchar* p, size_t size)
+		{
+			quint64 c = crc;
+			for (; size >= 8; p += 8, size -= 8)
+			{
+				quint64 word;
+				std::memcpy(&word, p, 8);
+				c = _mm_crc32_u64(c, word);
+			}
+			auto c32 = static_cast<quint32>(c);
+			for (; size != 0; ++p, --size)
+				c32 = _mm_crc32_u8(c32, *p);
+			return c32;
+		}
+#endif
+	} // namespace
+
+	quint32 Crc32c::update(quint32 crc, const void* data, size_t size)
+	{
+		const auto* p = static_cast<const uchar*>(data);
+#ifdef TOOL_CRC32C_SSE42
+		static const bool sse42 = hasSse42();
+		if (sse42)
+			return hardware(crc, p, size);
+#endif
+		return software(crc, p, size);
+	}
+
+	////////////////////////////////////////////////////////////////////////////////
+
+} /* namespace tool */
@@ -0,0 +1,24 @@
+#pragma once
+#include <QtGlobal>
+
+#include <cstddef>
+
+namespace tool
+{
+	////////////////////////////////////////////////////////////////////////////////
+
+	/** CRC-32C (Castagnoli) as used by postgres since 9.5. update() takes and returns raw
+		register: start with 0xFFFFFFFF, result is register ^ 0xFFFFFFFF. uses sse4.2 crc32
+		instruction when cpu has it, byte-wise table otherwise */
+	struct Crc32c
+	{
+		static constexpr quint32 initial = 0xFFFFFFFFu;
+
+		static quint32 update(quint32 crc, const void* data, size_t size);
+		static quint32 finish(quint32 crc) { return crc ^ 0xFFFFFFFFu; }
+		static quint32 compute(const void* data, size_t size) { return finish(update(initial, data, size)); }
+	};
+
+	////////////////////////////////////////////////////////////////////////////////
+
+} /* namespace tool */
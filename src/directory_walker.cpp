@@ -0,0 +1,304 @@
+#include "directory_walker.h"
+
+#include <QDir>
+#include <QFile>
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <thread>
+
+#ifdef Q_OS_WIN
+#	define VC_EXTRALEAN
+#	define WIN32_LEAN_AND_MEAN
+#	include <windows.h>
+#else
+#	include <dirent.h>
+#	include <fcntl.h>
+#	include <sys/stat.h>
+#	include <unistd.h>
+#endif
+#ifdef Q_OS_LINUX
+#	include <sys/syscall.h>
+#endif
+
+namespace tool
+{
+	////////////////////////////////////////////////////////////////////////////////
+
+	namespace
+	{
+#ifdef Q_OS_LINUX
+		/** record of getdents64, there is no glibc declaration */
+		struct LinuxDirent64
+		{
+			quint64 d_ino;
+			qint64 d_off;
+			unsigned short d_reclen;
+			unsigned char d_type;
+			char d_name[1];
+		};
+#endif
+
+		template <typename Char>
+		bool isDots(const Char* name)
+		{
+			return name[0] == '.' && (name[1] == 0 || (name[1] == '.' && name[2] == 0));
+		}
+	} // namespace
+
+	////////////////////////////////////////////////////////////////////////////////
+
+	DirectoryWalker::DirectoryWalker(Options options)
+		: m_options(std::move(options))
+		, m_marker(fromQString(m_options.marker))
+	{
+		QStringList patterns;
+		for (const auto& glob : m_options.excludes)
+		{
+			QString pattern;
+			for (const QChar c : glob)
+				pattern += c == '*' ? QString{ ".*" } : c == '?' ? QString{ "." } : QRegularExpression::escape(QString{ c });
+			patterns.push_back(pattern);
+		}
+		if (patterns.isEmpty())
+			return;
+		m_excludes = QRegularExpression{ QString{ "^(?:%1)$" }.arg(patterns.join('|')),
+#ifdef Q_OS_WIN
+			QRegularExpression::CaseInsensitiveOption
+#else
+			QRegularExpression::NoPatternOption
+#endif
+		};
+		m_excludes.optimize();
+	}
+
+	void DirectoryWalker::walk(const QStringList& roots, const Visitor& visitor)
+	{
+		const size_t threads = static_cast<size_t>(m_options.threads > 0
+				? m_options.threads
+				: std::max(1u, std::thread::hardware_concurrency()));
+		m_queues.clear();
+		for (size_t i = 0; i < threads; ++i)
+			m_queues.push_back(std::make_unique<Queue>());
+		m_pending = roots.size();
+		for (int i = 0; i < roots.size(); ++i)
+			m_queues[static_cast<size_t>(i) % threads]->tasks.push_back(Task{ fromQString(QDir::cleanPath(roots[i])), 0, -1 });
+
+		std::vector<std::thread> workers;
+		for (size_t i = 1; i < threads; ++i)
+			workers.emplace_back(&DirectoryWalker::work, this, i, std::cref(visitor));
+		work(0, visitor);
+		for (auto& worker : workers)
+			worker.join();
+	}
+
+	void DirectoryWalker::cancel()
+	{
+		m_cancel = true;
+	}
+
+	bool DirectoryWalker::cancelled() const
+	{
+		return m_cancel || (m_options.cancel != nullptr && *m_options.cancel);
+	}
+
+	void DirectoryWalker::work(size_t self, const Visitor& visitor)
+	{
+		unsigned idle = 0;
+		while (!cancelled())
+		{
+			Task task;
+			if (take(self, task))
+			{
+				idle = 0;
+				visit(self, task, visitor);
+				// children are counted before parent is released, so zero means walk is over
+				m_pending.fetch_sub(1, std::memory_order_acq_rel);
+				continue;
+			}
+			if (m_pending.load(std::memory_order_acquire) == 0)
+				break;
+			if (++idle < 64)
+				std::this_thread::yield();
+			else
+				std::this_thread::sleep_for(std::chrono::microseconds{ 100 });
+		}
+	}
+
+	bool DirectoryWalker::take(size_t self, Task& task)
+	{
+		{ // own queue is used as stack, deepest directory goes first
+			Queue& own = *m_queues[self];
+			auto lock = std::lock_guard{ own.lock };
+			if (!own.tasks.empty())
+			{
+				task = std::move(own.tasks.back());
+				own.tasks.pop_back();
+				return true;
+			}
+		}
+		for (size_t i = 1; i < m_queues.size(); ++i)
+		{ // thief takes the oldest, likely biggest, subtree
+			Queue& victim = *m_queues[(self + i) % m_queues.size()];
+			auto lock = std::lock_guard{ victim.lock };
+			if (!victim.tasks.empty())
+			{
+				task = std::move(victim.tasks.front());
+				victim.tasks.pop_front();
+				return true;
+			}
+		}
+		return false;
+	}
+
+	void DirectoryWalker::push(size_t self, Task task)
+	{
+		m_pending.fetch_add(1, std::memory_order_acq_rel);
+		Queue& own = *m_queues[self];
+		auto lock = std::lock_guard{ own.lock };
+		own.tasks.push_back(std::move(task));
+	}
+
+	bool DirectoryWalker::excluded(const QString& name) const
+	{
+		return !m_options.excludes.isEmpty() && m_excludes.match(name).hasMatch();
+	}
+
+	void DirectoryWalker::visit(size_t self, const Task& task, const Visitor& visitor)
+	{
+		const bool descend = m_options.maxDepth < 0 || task.depth < m_options.maxDepth;
+		std::vector<std::pair<NativePath, qint64>> children; // name, mtime
+		bool marked = false;
+		qint64 mtime = task.mtime;
+
+#ifdef Q_OS_WIN
+		const auto milliseconds = [](const FILETIME& time) { // since 1601 in 100ns
+			return static_cast<qint64>(((static_cast<quint64>(time.dwHighDateTime) << 32) | time.dwLowDateTime) / 10000) - 11644473600000LL;
+		};
+		WIN32_FILE_ATTRIBUTE_DATA attributes;
+		if (mtime < 0 && ::GetFileAttributesExW(task.path.c_str(), GetFileExInfoStandard, &attributes))
+			mtime = milliseconds(attributes.ftLastWriteTime);
+		WIN32_FIND_DATAW data;
+		const NativePath pattern = task.path + L"\\*";
+		HANDLE find = ::FindFirstFileExW(pattern.c_str(), FindExInfoBasic, &data, FindExSearchNameMatch, nullptr, FIND_FIRST_EX_LARGE_FETCH);
+		if (find == INVALID_HANDLE_VALUE)
+			return;
+		do
+		{
+			if (isDots(data.cFileName))
+				continue;
+			// junctions are entered as QDir did, depth limit is the guard against loops
+			if ((data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) != 0)
+			{
+				if (descend)
+					children.emplace_back(data.cFileName, milliseconds(data.ftLastWriteTime));
+			}
+			else if (!m_marker.empty() && ::_wcsicmp(data.cFileName, m_marker.c_str()) == 0)
+				marked = true;
+		} while (::FindNextFileW(find, &data));
+		::FindClose(find);
+#else
+		const int fd = ::open(task.path.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+		if (fd < 0)
+			return;
+		struct stat own;
+		if (::fstat(fd, &own) == 0)
+#	ifdef Q_OS_LINUX
+			mtime = static_cast<qint64>(own.st_mtim.tv_sec) * 1000 + own.st_mtim.tv_nsec / 1000000;
+#	else
+			mtime = static_cast<qint64>(own.st_mtime) * 1000;
+#	endif
+		const auto entry = [&](const char* name, unsigned char type) {
+			if (isDots(name))
+				return;
+			if (type == DT_UNKNOWN || type == DT_LNK)
+			{ // filesystem doesnt type entries, or link which may lead to directory
+				struct stat st;
+				if (::fstatat(fd, name, &st, type == DT_LNK ? 0 : AT_SYMLINK_NOFOLLOW) != 0)
+					return;
+				if (S_ISDIR(st.st_mode) && type == DT_LNK)
+				{ // link loops are cut by identity of target
+					auto lock = std::lock_guard{ m_linksLock };
+					const std::pair<quint64, quint64> id{ static_cast<quint64>(st.st_dev), static_cast<quint64>(st.st_ino) };
+					if (std::find(m_links.begin(), m_links.end(), id) != m_links.end())
+						return;
+					m_links.push_back(id);
+				}
+				type = S_ISDIR(st.st_mode) ? DT_DIR : DT_REG;
+			}
+			if (type == DT_DIR)
+			{
+				if (descend)
+					children.emplace_back(name, -1);
+			}
+			else if (!m_marker.empty() && m_marker == name)
+				marked = true;
+		};
+#	ifdef Q_OS_LINUX
+		alignas(8) char buffer[32768];
+		while (true)
+		{
+			const long size = ::syscall(SYS_getdents64, fd, buffer, sizeof(buffer));
+			if (size <= 0)
+				break;
+			for (long offset = 0; offset < size;)
+			{
+				const auto* e = reinterpret_cast<const LinuxDirent64*>(buffer + offset);
+				offset += e->d_reclen;
+				entry(e->d_name, e->d_type);
+			}
+		}
+		::close(fd);
+#	else
+		DIR* dir = ::fdopendir(fd);
+		if (dir == nullptr)
+		{
+			::close(fd);
+			return;
+		}
+		while (const dirent* e = ::readdir(dir))
+			entry(e->d_name, e->d_type);
+		::closedir(dir);
+#	endif
+#endif
+
+		if (visitor(Directory{ toQString(task.path), mtime, marked }))
+			return;
+		for (auto& [name, time] : children)
+		{
+			if (excluded(toQString(name)))
+				continue;
+#ifdef Q_OS_WIN
+			const wchar_t separator = L'\\';
+#else
+			const char separator = '/';
+#endif
+			NativePath path = task.path;
+			if (path.empty() || path.back() != separator)
+				path += separator;
+			push(self, Task{ path + name, task.depth + 1, time });
+		}
+	}
+
+	QString DirectoryWalker::toQString(const NativePath& path)
+	{
+#ifdef Q_OS_WIN
+		return QDir::fromNativeSeparators(QString::fromStdWString(path));
+#else
+		return QFile::decodeName(path.c_str());
+#endif
+	}
+
+	DirectoryWalker::NativePath DirectoryWalker::fromQString(const QString& path)
+	{
+#ifdef Q_OS_WIN
+		return QDir::toNativeSeparators(path).toStdWString();
+#else
+		return QFile::encodeName(path).toStdString();
+#endif
+	}
+
+	////////////////////////////////////////////////////////////////////////////////
+
+} /* namespace tool */
@@ -0,0 +1,92 @@
+#pragma once
+#include <QRegularExpression>
+#include <QStringList>
+
+#include <atomic>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace tool
+{
+	////////////////////////////////////////////////////////////////////////////////
+
+	/** parallel directory tree walker. every thread owns queue of directories and steals from
+		others when it runs dry. entries are typed by directory listing itself (getdents64 d_type,
+		FindFirstFileEx with large fetch), so files are never stat'ed */
+	class DirectoryWalker
+	{
+	public:
+		struct Options
+		{
+			int maxDepth = -1;    // levels below root, -1 is unlimited
+			QStringList excludes; // globs of directory names which arent entered
+			QString marker;       // file name, directory holding it is marked
+			int threads = 0;      // 0 is hardware concurrency
+			const std::atomic<bool>* cancel = nullptr; // external cancellation, checked as cancel()
+		};
+		struct Directory
+		{
+			QString path;
+			qint64 mtime; // ms since epoch
+			bool marked;  // holds marker file
+		};
+		/** called concurrently from walker threads for every directory entered.
+			returns true if directory is taken and isnt descended */
+		using Visitor = std::function<bool(const Directory&)>;
+
+		explicit DirectoryWalker(Options);
+
+		/** returns when trees are walked or walk is cancelled */
+		void walk(const QStringList& roots, const Visitor&);
+		/** callable from any thread, walk returns soon after */
+		void cancel();
+		bool cancelled() const;
+
+	protected:
+#ifdef Q_OS_WIN
+		using NativePath = std::wstring;
+#else
+		using NativePath = std::string;
+#endif
+		struct Task
+		{
+			NativePath path;
+			int depth;
+			qint64 mtime; // windows gets it from parent listing, -1 for roots
+		};
+		struct Queue
+		{
+			std::mutex lock;
+			std::deque<Task> tasks;
+		};
+
+		void work(size_t self, const Visitor&);
+		bool take(size_t self, Task&);
+		/** lists directory, queues subdirectories to own queue */
+		void visit(size_t self, const Task&, const Visitor&);
+		void push(size_t self, Task);
+		bool excluded(const QString& name) const;
+
+		static QString toQString(const NativePath&);
+		static NativePath fromQString(const QString&);
+
+	protected:
+		const Options m_options;
+		QRegularExpression m_excludes;
+		NativePath m_marker;
+		std::vector<std::unique_ptr<Queue>> m_queues;
+		std::atomic<long long> m_pending{ 0 }; // queued and being listed
+		std::atomic<bool> m_cancel{ false };
+#ifndef Q_OS_WIN
+		std::mutex m_linksLock;
+		std::vector<std::pair<quint64, quint64>> m_links; // device, inode of entered symlinked directories
+#endif
+	};
+
+	////////////////////////////////////////////////////////////////////////////////
+
+} /* namespace tool */
@@ -0,0 +1,341 @@
+#include "event_log.h"
+#include "service_control.h"
+
+#include <QDateTime>
+#include <QDir>
+#include <QFileInfo>
+#include <QStringList>
+#include <QTextStream>
+
+#include <algorithm>
+#include <cstring>
+
+#include <QDebug>
+
+////////////////////////////////////////////////////////////////////////////////
+
+namespace
+{
+	const char magic[8]{ 'Q', 'T', 'C', 'E', 'V', 'L', 'O', 'G' };
+	const quint32 version = 1;
+	const auto flushInterval = std::chrono::milliseconds{ 250 };
+
+	QString duration(qint64 ms)
+	{
+		const qint64 s = ms / 1000, m = s / 60, h = m / 60, d = h / 24;
+		if (d != 0)
+			return QString{ "%1d %2h" }.arg(d).arg(h % 24);
+		if (h != 0)
+			return QString{ "%1h %2m" }.arg(h).arg(m % 60);
+		if (m != 0)
+			return QString{ "%1m" }.arg(m);
+		return QString{ "%1s" }.arg(s);
+	}
+
+	const char* stateWord(int state)
+	{
+		switch (state)
+		{
+		case ServiceControl::Running:
+			return "up";
+		case ServiceControl::Paused:
+			return "paused";
+		case ServiceControl::StartPending:
+		case ServiceControl::ContinuePending:
+			return "starting";
+		case ServiceControl::StopPending:
+		case ServiceControl::PausePending:
+			return "stopping";
+		default:
+			return "down";
+		}
+	}
+} // namespace
+
+////////////////////////////////////////////////////////////////////////////////
+
+EventLog* EventLog::instance(SingletonPolicy policy)
+{
+	static EventLog* instance{ nullptr };
+	if (policy == Get && instance == nullptr)
+		instance = new EventLog;
+	if (policy == Release && instance != nullptr)
+		delete instance, instance = nullptr;
+	return instance;
+}
+
+EventLog::EventLog()
+	: m_directory{ QFileInfo{ Settings::setup()->configPath() }.absoluteDir().absoluteFilePath("events") }
+	, m_capacity{ static_cast<quint32>(std::max(1024, Settings::setup()->get("event_log_segment_records", 65536).toInt())) }
+	, m_keepSegments{ std::max(2, Settings::setup()->get("event_log_segments", 8).toInt()) }
+	, m_queue{ new Slot[queueSize] }
+{
+	for (quint64 i = 0; i < queueSize; ++i)
+		m_queue[i].sequence.store(i, std::memory_order_relaxed);
+
+	QDir{}.mkpath(m_directory);
+	m_namesFile.setFileName(QDir{ m_directory }.absoluteFilePath("names.txt"));
+	if (m_namesFile.open(QIODevice::ReadOnly))
+	{
+		QTextStream in{ &m_namesFile };
+		in.setCodec("UTF-8");
+		QString line;
+		while (in.readLineInto(&line))
+		{
+			const int tab = line.indexOf('\t');
+			bool ok = false;
+			const quint32 id = line.left(tab).toUInt(&ok);
+			if (tab < 0 || !ok)
+				continue;
+			const QString key = line.mid(tab + 1);
+			if (m_names.size() <= id)
+				m_names.resize(id + 1);
+			m_names[id] = key;
+			m_ids.insert(key, id);
+		}
+		m_namesFile.close();
+	}
+	if (!m_namesFile.open(QIODevice::WriteOnly | QIODevice::Append))
+		qDebug() << "cant open" << m_namesFile.fileName();
+
+	QStringList segments = QDir{ m_directory }.entryList(QStringList{ "*.log" }, QDir::Files, QDir::Name);
+	m_firstSegment = segments.isEmpty() ? 1 : QFileInfo{ segments.front() }.baseName().toULongLong();
+	m_segment = segments.isEmpty() ? 1 : QFileInfo{ segments.back() }.baseName().toULongLong();
+	if (!openSegment(m_segment))
+		qDebug() << "event log disabled, cant map" << segmentPath(m_segment);
+
+	m_thread = std::thread(&EventLog::run, this);
+}
+
+EventLog::~EventLog()
+{
+	{
+		auto lock = std::lock_guard{ m_stopLock };
+		m_stop = true;
+	}
+	m_wake.notify_all();
+	if (m_thread.joinable())
+		m_thread.join();
+	auto lock = std::lock_guard{ m_flushLock };
+	flush();
+	if (m_header != nullptr)
+		m_file.unmap(reinterpret_cast<uchar*>(m_header));
+	if (m_dropped != 0)
+		qDebug() << "event log dropped" << m_dropped.load() << "records";
+}
+
+quint32 EventLog::entity(Kind kind, const QString& name)
+{
+	const QString key = QString{ "%1/%2" }.arg(kind).arg(name);
+	auto lock = std::lock_guard{ m_namesLock };
+	const auto it = m_ids.find(key);
+	if (it != m_ids.end())
+		return it.value();
+	const auto id = static_cast<quint32>(m_names.size());
+	m_names.push_back(key);
+	m_ids.insert(key, id);
+	m_namesFile.write(QString{ "%1\t%2\n" }.arg(id).arg(key).toUtf8());
+	m_namesFile.flush();
+	return id;
+}
+
+QString EventLog::name(quint32 id) const
+{
+	auto lock = std::lock_guard{ m_namesLock };
+	return id < m_names.size() ? m_names[id].mid(m_names[id].indexOf('/') + 1) : QString{};
+}
+
+void EventLog::append(quint32 entity, Kind kind, int from, int to)
+{
+	const Record record{ QDateTime::currentMSecsSinceEpoch(), entity, kind, static_cast<quint8>(from), static_cast<quint8>(to), 0 };
+	quint64 position = m_enqueue.load(std::memory_order_relaxed);
+	while (true)
+	{
+		Slot& slot = m_queue[position % queueSize];
+		const auto turn = static_cast<qint64>(slot.sequence.load(std::memory_order_acquire) - position);
+		if (turn == 0)
+		{
+			if (m_enqueue.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+			{
+				slot.record = record;
+				slot.sequence.store(position + 1, std::memory_order_release);
+				return;
+			}
+		}
+		else if (turn < 0)
+		{ // full, flusher hasnt consumed this slot yet
+			m_dropped.fetch_add(1, std::memory_order_relaxed);
+			return;
+		}
+		else
+			position = m_enqueue.load(std::memory_order_relaxed);
+	}
+}
+
+void EventLog::run()
+{
+	auto lock = std::unique_lock{ m_stopLock };
+	while (!m_wake.wait_for(lock, flushInterval, [this]() { return m_stop; }))
+	{
+		auto flushLock = std::lock_guard{ m_flushLock };
+		flush();
+	}
+}
+
+void EventLog::flush()
+{
+	while (true)
+	{
+		Slot& slot = m_queue[m_dequeue % queueSize];
+		if (slot.sequence.load(std::memory_order_acquire) != m_dequeue + 1)
+			break;
+		const Record record = slot.record;
+		slot.sequence.store(m_dequeue + queueSize, std::memory_order_release);
+		++m_dequeue;
+
+		if (m_header != nullptr && m_header->count >= m_header->capacity)
+			rotate();
+		if (m_header == nullptr)
+			continue;
+		m_records[m_header->count] = record;
+		++m_header->count; // record is written before it is counted
+	}
+}
+
+QString EventLog::segmentPath(quint64 index) const
+{
+	return QDir{ m_directory }.absoluteFilePath(QString{ "%1.log" }.arg(index, 6, 10, QChar{ '0' }));
+}
+
+bool EventLog::openSegment(quint64 index)
+{
+	m_header = nullptr;
+	m_records = nullptr;
+	m_file.close();
+	m_file.setFileName(segmentPath(index));
+	if (!m_file.open(QIODevice::ReadWrite))
+		return false;
+
+	Header header{};
+	const bool existing = m_file.size() >= static_cast<qint64>(sizeof(Header))
+		&& m_file.read(reinterpret_cast<char*>(&header), sizeof(Header)) == sizeof(Header)
+		&& std::memcmp(header.magic, magic, sizeof(magic)) == 0 && header.version == version
+		&& m_file.size() >= static_cast<qint64>(sizeof(Header) + header.capacity * sizeof(Record));
+	if (!existing)
+	{ // new or damaged segment starts empty
+		std::memcpy(header.magic, magic, sizeof(magic));
+		header.version = version;
+		header.capacity = m_capacity;
+		header.count = 0;
+		if (!m_file.resize(0) || !m_file.resize(static_cast<qint64>(sizeof(Header) + header.capacity * sizeof(Record))))
+			return false;
+	}
+	uchar* map = m_file.map(0, static_cast<qint64>(sizeof(Header) + header.capacity * sizeof(Record)));
+	if (map == nullptr)
+		return false;
+	m_header = reinterpret_cast<Header*>(map);
+	if (!existing)
+		*m_header = header;
+	m_header->count = std::min<quint64>(m_header->count, m_header->capacity);
+	m_records = reinterpret_cast<Record*>(map + sizeof(Header));
+	return true;
+}
+
+void EventLog::rotate()
+{
+	m_file.unmap(reinterpret_cast<uchar*>(m_header));
+	if (!openSegment(++m_segment))
+		qDebug() << "event log disabled, cant map" << segmentPath(m_segment);
+	while (m_segment - m_firstSegment >= static_cast<quint64>(m_keepSegments))
+		QFile::remove(segmentPath(m_firstSegment++));
+}
+
+template <typename Visitor>
+void EventLog::visitSegments(Visitor visitor)
+{
+	if (m_header != nullptr && !visitor(m_records, m_header->count))
+		return;
+	for (quint64 index = m_segment; index-- > m_firstSegment;)
+	{
+		QFile file{ segmentPath(index) };
+		if (!file.open(QIODevice::ReadOnly) || file.size() < static_cast<qint64>(sizeof(Header)))
+			continue;
+		uchar* map = file.map(0, file.size());
+		if (map == nullptr)
+			continue;
+		const auto* header = reinterpret_cast<const Header*>(map);
+		const bool valid = std::memcmp(header->magic, magic, sizeof(magic)) == 0
+			&& file.size() >= static_cast<qint64>(sizeof(Header) + header->capacity * sizeof(Record));
+		const bool more = !valid || visitor(reinterpret_cast<const Record*>(map + sizeof(Header)), std::min<quint64>(header->count, header->capacity));
+		file.unmap(map);
+		if (!more)
+			return;
+	}
+}
+
+EventLog::Records EventLog::query(quint32 entity, qint64 from, qint64 to)
+{
+	Records result;
+	auto lock = std::lock_guard{ m_flushLock };
+	flush();
+	visitSegments([&](const Record* records, quint64 count) {
+		for (quint64 i = count; i-- > 0;)
+		{
+			const Record& r = records[i];
+			if (r.time < from)
+				return false; // segments are appended in time order
+			if (r.entity == entity && r.time < to)
+				result.push_back(r);
+		}
+		return true;
+	});
+	std::reverse(result.begin(), result.end());
+	return result;
+}
+
+QString EventLog::summary(quint32 entity)
+{
+	const qint64 now = QDateTime::currentMSecsSinceEpoch();
+	const qint64 midnight = QDateTime{ QDate::currentDate(), QTime{ 0, 0 } }.toMSecsSinceEpoch();
+	const Record* last = nullptr;
+	Record latest{};
+	Records today; // newest first
+
+	auto lock = std::lock_guard{ m_flushLock };
+	flush();
+	visitSegments([&](const Record* records, quint64 count) {
+		for (quint64 i = count; i-- > 0;)
+		{
+			const Record& r = records[i];
+			if (r.time < midnight && last != nullptr)
+				return false;
+			if (r.entity != entity)
+				continue;
+			if (last == nullptr)
+				latest = r, last = &latest; // segment may be unmapped after visit
+			if (r.time >= midnight)
+				today.push_back(r);
+		}
+		return true;
+	});
+	if (last == nullptr)
+		return QString{};
+
+	// start is restart only if service has been running earlier today, first start of day isnt
+	int restarts = 0;
+	bool ran = false;
+	for (auto r = today.rbegin(); r != today.rend(); ++r)
+	{
+		if (r->to == ServiceControl::Running && r->from != ServiceControl::Paused
+			&& r->from != ServiceControl::ContinuePending && ran)
+			++restarts;
+		if (r->from == ServiceControl::Running || r->from == ServiceControl::Paused)
+			ran = true;
+	}
+	QString result = QString{ "%1 for %2" }.arg(stateWord(last->to)).arg(duration(now - last->time));
+	if (restarts != 0)
+		result += QString{ ", %1 %2 today" }.arg(restarts).arg(restarts == 1 ? "restart" : "restarts");
+	return result;
+}
+
+////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,118 @@
+#pragma once
+#include "settings.h"
+
+#include <QFile>
+#include <QHash>
+#include <QString>
+
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+////////////////////////////////////////////////////////////////////////////////
+
+/** append-only history of state transitions of services, clusters and processes.
+	append() only puts fixed record into lock-free queue, flusher thread copies queued
+	records into memory-mapped segment files <configdir>/events/NNNNNN.log, oldest
+	segments are removed on rotation. entity names live in events/names.txt */
+class EventLog
+{
+public:
+	enum Kind : quint8
+	{
+		Service,
+		Cluster,
+		Process,
+	};
+
+#pragma pack(push, 1)
+	struct Record
+	{
+		qint64 time; // ms since epoch
+		quint32 entity;
+		quint8 kind;
+		quint8 from, to; // ServiceControl::State
+		quint8 reserved;
+	};
+#pragma pack(pop)
+	static_assert(sizeof(Record) == 16, "event record must stay 16 bytes");
+	using Records = std::vector<Record>;
+
+	static EventLog* instance(SingletonPolicy = Get);
+	~EventLog();
+
+	/** stable id of entity, kept across runs. takes lock, call it once per entity */
+	quint32 entity(Kind, const QString& name);
+	QString name(quint32) const;
+
+	/** lock-free and allocation-free, callable from any thread.
+		record is dropped if flusher is behind by whole queue */
+	void append(quint32 entity, Kind, int from, int to);
+	/** transitions of entity with time in [from, to), oldest first. queued records are flushed first */
+	Records query(quint32 entity, qint64 from, qint64 to);
+	/** "up for 3h, 2 restarts today", empty if entity has no history. restart is start after
+		entity has been running earlier today */
+	QString summary(quint32 entity);
+
+protected:
+	EventLog();
+
+	struct Header
+	{
+		char magic[8];
+		quint32 version;
+		quint32 capacity; // records
+		quint64 count;
+		qint64 reserved;
+	};
+	static_assert(sizeof(Header) == 32, "segment header must stay 32 bytes");
+
+	void run();
+	/** moves queued records into current segment, caller holds m_flushLock */
+	void flush();
+	bool openSegment(quint64 index);
+	void rotate();
+	QString segmentPath(quint64 index) const;
+	/** calls visitor(records, count) for every segment, newest first, until it returns false */
+	template <typename Visitor>
+	void visitSegments(Visitor);
+
+	// bounded multi-producer queue (Vyukov), sequence tells slot's turn
+	struct Slot
+	{
+		std::atomic<quint64> sequence;
+		Record record;
+	};
+	static constexpr quint64 queueSize = 4096;
+
+protected:
+	const QString m_directory;
+	const quint32 m_capacity;
+	const int m_keepSegments;
+
+	std::unique_ptr<Slot[]> m_queue;
+	std::atomic<quint64> m_enqueue{ 0 };
+	quint64 m_dequeue = 0; // flusher side, under m_flushLock
+	std::atomic<quint64> m_dropped{ 0 };
+
+	std::mutex m_flushLock; // current segment and consumer side of queue
+	QFile m_file;
+	Header* m_header = nullptr;
+	Record* m_records = nullptr;
+	quint64 m_segment = 0, m_firstSegment = 0;
+
+	mutable std::mutex m_namesLock;
+	QHash<QString, quint32> m_ids; // "kind/name" -> id
+	std::vector<QString> m_names;
+	QFile m_namesFile;
+
+	std::mutex m_stopLock;
+	std::condition_variable m_wake;
+	bool m_stop = false;
+	std::thread m_thread;
+};
+
+////////////////////////////////////////////////////////////////////////////////
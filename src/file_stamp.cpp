@@ -0,0 +1,59 @@
+#include "file_stamp.h"
+
+#include <QDateTime>
+#include <QFile>
+#include <QFileInfo>
+
+#ifdef Q_OS_UNIX
+#	include <sys/stat.h>
+#endif
+
+namespace tool
+{
+	////////////////////////////////////////////////////////////////////////////////
+
+	FileStamp::FileStamp(const QString& path)
+	{
+#ifdef Q_OS_UNIX
+		// single stat, QFileInfo would take it too but without inode
+		struct stat st;
+		if (::stat(QFile::encodeName(path).constData(), &st) != 0 || !S_ISREG(st.st_mode))
+			return;
+		size = static_cast<qint64>(st.st_size);
+#	ifdef Q_OS_LINUX
+		mtime = static_cast<qint64>(st.st_mtim.tv_sec) * 1000 + st.st_mtim.tv_nsec / 1000000;
+#	else
+		mtime = static_cast<qint64>(st.st_mtime) * 1000;
+#	endif
+		inode = static_cast<quint64>(st.st_ino);
+#else
+		const QFileInfo info{ path };
+		if (!info.isFile())
+			return;
+		size = info.size();
+		mtime = info.lastModified().toMSecsSinceEpoch();
+#endif
+	}
+
+	bool FileStamp::operator==(const FileStamp& s) const
+	{
+		return size == s.size && mtime == s.mtime && inode == s.inode;
+	}
+
+	bool FileStamp::operator!=(const FileStamp& s) const
+	{
+		return !(*this == s);
+	}
+
+	bool FileStamp::refresh(FileStamp& stamp, const QString& path)
+	{
+		const FileStamp current{ path };
+		if (current == stamp)
+			return false;
+		stamp = current;
+		return true;
+	}
+
+	////////////////////////////////////////////////////////////////////////////////
+
+} /* namespace tool */
@@ -0,0 +1,29 @@
+#pragma once
+#include <QString>
+
+namespace tool
+{
+	////////////////////////////////////////////////////////////////////////////////
+
+	/** identity of file content without reading it: size, mtime and inode (unix). file is
+		re-read only when its stamp changes */
+	struct FileStamp
+	{
+		qint64 size = -1;  // -1 if file doesnt exist
+		qint64 mtime = 0;  // ms since epoch
+		quint64 inode = 0; // 0 on windows
+
+		FileStamp() {}
+		explicit FileStamp(const QString& path);
+
+		bool exists() const { return size >= 0; }
+		bool operator==(const FileStamp&) const;
+		bool operator!=(const FileStamp&) const;
+
+		/** stamps path into stamp, true if it differs from what was there */
+		static bool refresh(FileStamp& stamp, const QString& path);
+	};
+
+	////////////////////////////////////////////////////////////////////////////////
+
+} /* namespace tool */
@@ -0,0 +1,121 @@
+#include "flameview.h"
+
+#include <QMouseEvent>
+#include <QPainter>
+
+#include <algorithm>
+
+////////////////////////////////////////////////////////////////////////////////
+
+FlameView::FlameView(tool::pProfile profile, QWidget* parent)
+	: QWidget(parent)
+	, m_profile(profile)
+{
+	setMouseTracking(true);
+	setWindowTitle(QString{ "profile: %1" }.arg(m_profile->title));
+
+	const auto& frames = m_profile->frames;
+	m_children.resize(frames.size());
+	for (quint32 idx = 1; idx < frames.size(); ++idx)
+		m_children[frames[idx].parent].push_back(idx);
+	for (auto& c : m_children)
+		std::sort(c.begin(), c.end(), [&frames](quint32 l, quint32 r) { return frames[l].name < frames[r].name; });
+	layoutFrames();
+}
+
+QSize FlameView::sizeHint() const
+{
+	int depth = 0;
+	for (const auto& b : m_boxes)
+		depth = std::max(depth, b.depth);
+	return QSize{ 800, std::min(800, (depth + 2) * rowHeight) };
+}
+
+void FlameView::layoutFrames()
+{
+	m_boxes.clear();
+	const auto& frames = m_profile->frames;
+	if (frames.empty() || frames[m_zoom].total == 0)
+		return;
+	const double scale = 1. / frames[m_zoom].total;
+	// iterative walk, children are laid out left to right inside parent's box
+	std::vector<Box> stack{ Box{ m_zoom, 0., 1., 0 } };
+	while (!stack.empty())
+	{
+		const Box box = stack.back();
+		stack.pop_back();
+		m_boxes.push_back(box);
+		double x = box.x;
+		for (const quint32 c : m_children[box.frame])
+		{
+			const double width = frames[c].total * scale;
+			stack.push_back(Box{ c, x, width, box.depth + 1 });
+			x += width;
+		}
+	}
+	update();
+}
+
+int FlameView::frameAt(const QPoint& pt) const
+{
+	const double x = static_cast<double>(pt.x()) / std::max(width(), 1);
+	const int depth = pt.y() / rowHeight;
+	for (const auto& b : m_boxes)
+		if (b.depth == depth && x >= b.x && x < b.x + b.width)
+			return static_cast<int>(b.frame);
+	return -1;
+}
+
+void FlameView::paintEvent(QPaintEvent*)
+{
+	QPainter p{ this };
+	p.fillRect(rect(), QColor{ 34, 34, 34 });
+	const auto& frames = m_profile->frames;
+	const int w = width();
+	for (const auto& b : m_boxes)
+	{
+		const QRect r{ static_cast<int>(b.x * w), b.depth * rowHeight, std::max(1, static_cast<int>(b.width * w) - 1), rowHeight - 1 };
+		// stable warm color per name, as in classic flame graphs
+		const uint h = qHash(frames[b.frame].name);
+		p.fillRect(r, QColor{ 200 + static_cast<int>(h % 55), 80 + static_cast<int>((h >> 8) % 120), 40 + static_cast<int>((h >> 16) % 40) });
+		if (r.width() > 20)
+		{
+			p.setPen(QColor{ 30, 30, 30 });
+			p.drawText(r.adjusted(2, 0, -2, 0), Qt::AlignVCenter | Qt::AlignLeft,
+				p.fontMetrics().elidedText(frames[b.frame].name, Qt::ElideRight, r.width() - 4));
+		}
+	}
+}
+
+void FlameView::mousePressEvent(QMouseEvent* e)
+{
+	if (e->button() == Qt::RightButton)
+	{
+		if (m_zoom == tool::StackTrie::root)
+			return;
+		m_zoom = m_profile->frames[m_zoom].parent;
+		return layoutFrames();
+	}
+	const int frame = frameAt(e->pos());
+	if (e->button() == Qt::LeftButton && frame >= 0)
+	{
+		m_zoom = static_cast<quint32>(frame);
+		layoutFrames();
+	}
+}
+
+void FlameView::mouseMoveEvent(QMouseEvent* e)
+{
+	const int frame = frameAt(e->pos());
+	if (frame < 0)
+		return setToolTip(QString{});
+	const auto& f = m_profile->frames[static_cast<size_t>(frame)];
+	const double total = std::max<quint32>(m_profile->frames.front().total, 1);
+	setToolTip(QString{ "%1\n%2 samples (%3%), self %4" }
+				   .arg(f.name)
+				   .arg(f.total)
+				   .arg(100. * f.total / total, 0, 'f', 1)
+				   .arg(f.self));
+}
+
+////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,41 @@
+#pragma once
+#include "profiler.h"
+
+#include <QWidget>
+
+////////////////////////////////////////////////////////////////////////////////
+
+/** icicle-style flame graph of a profile. click zooms into frame, right click zooms out */
+class FlameView : public QWidget
+{
+	Q_OBJECT
+public:
+	FlameView(tool::pProfile, QWidget* = nullptr);
+
+	QSize sizeHint() const override;
+
+protected:
+	void paintEvent(QPaintEvent*) override;
+	void mousePressEvent(QMouseEvent*) override;
+	void mouseMoveEvent(QMouseEvent*) override;
+
+	/** frame under point, or -1 */
+	int frameAt(const QPoint&) const;
+	void layoutFrames();
+
+protected:
+	struct Box
+	{
+		quint32 frame;
+		double x, width; // fraction of zoomed frame width
+		int depth;
+	};
+
+	tool::pProfile m_profile;
+	std::vector<std::vector<quint32>> m_children;
+	std::vector<Box> m_boxes;
+	quint32 m_zoom = tool::StackTrie::root;
+	static const int rowHeight = 16;
+};
+
+////////////////////////////////////////////////////////////////////////////////
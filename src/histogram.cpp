@@ -0,0 +1,126 @@
+#include "histogram.h"
+
+#include <algorithm>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+namespace tool
+{
+	////////////////////////////////////////////////////////////////////////////////
+
+	namespace
+	{
+		unsigned msb(quint64 v)
+		{
+#ifdef _MSC_VER
+			unsigned long index;
+			_BitScanReverse64(&index, v);
+			return static_cast<unsigned>(index);
+#else
+			return 63u - static_cast<unsigned>(__builtin_clzll(v));
+#endif
+		}
+	} // namespace
+
+	////////////////////////////////////////////////////////////////////////////////
+
+	LatencyHistogram::LatencyHistogram()
+	{
+		for (auto& b : m_buckets)
+			b.store(0, std::memory_order_relaxed);
+	}
+
+	size_t LatencyHistogram::bucketIndex(quint64 v)
+	{
+		constexpr quint64 linear = 1u << subBits;
+		if (v < linear)
+			return static_cast<size_t>(v);
+		const unsigned m = std::min(msb(v), maxExponent);
+		if (m == maxExponent && (v >> maxExponent) > 1)
+			return bucketCount - 1; // saturated
+		// top subBits below leading one select linear sub-bucket
+		const quint64 sub = (v >> (m - subBits)) & (linear - 1);
+		return static_cast<size_t>((m - subBits + 1) << subBits | sub);
+	}
+
+	quint64 LatencyHistogram::bucketUpper(size_t index)
+	{
+		constexpr quint64 linear = 1u << subBits;
+		if (index < linear)
+			return index;
+		const unsigned m = static_cast<unsigned>(index >> subBits) + subBits - 1;
+		const quint64 sub = index & (linear - 1);
+		const unsigned shift = m - subBits;
+		return ((linear | sub) << shift) + ((quint64{ 1 } << shift) - 1);
+	}
+
+	void LatencyHistogram::record(quint64 v)
+	{
+		m_buckets[bucketIndex(v)].fetch_add(1, std::memory_order_relaxed);
+		quint64 current = m_max.load(std::memory_order_relaxed);
+		while (v > current && !m_max.compare_exchange_weak(current, v, std::memory_order_relaxed))
+			;
+	}
+
+	quint64 LatencyHistogram::count() const
+	{
+		quint64 result = 0;
+		for (const auto& b : m_buckets)
+			result += b.load(std::memory_order_relaxed);
+		return result;
+	}
+
+	quint64 LatencyHistogram::max() const
+	{
+		return m_max.load(std::memory_order_relaxed);
+	}
+
+	quint64 LatencyHistogram::percentile(double p) const
+	{
+		const quint64 total = count();
+		if (total == 0)
+			return 0;
+		const quint64 rank = std::max<quint64>(1, static_cast<quint64>(p / 100. * total + 0.5));
+		quint64 seen = 0;
+		for (size_t i = 0; i < bucketCount; ++i)
+		{
+			seen += m_buckets[i].load(std::memory_order_relaxed);
+			if (seen >= rank)
+				return std::min(bucketUpper(i), max());
+		}
+		return max();
+	}
+
+	QJsonObject LatencyHistogram::toJson() const
+	{
+		QJsonObject buckets;
+		for (size_t i = 0; i < bucketCount; ++i)
+			if (const quint32 n = m_buckets[i].load(std::memory_order_relaxed))
+				buckets.insert(QString::number(i), static_cast<qint64>(n));
+		return QJsonObject{
+			{ "max", static_cast<qint64>(max()) },
+			{ "buckets", buckets },
+		};
+	}
+
+	void LatencyHistogram::merge(const QJsonObject& o)
+	{
+		const QJsonObject buckets = o.value("buckets").toObject();
+		for (auto it = buckets.begin(); it != buckets.end(); ++it)
+		{
+			bool ok = false;
+			const size_t index = it.key().toULongLong(&ok);
+			if (ok && index < bucketCount)
+				m_buckets[index].fetch_add(static_cast<quint32>(it.value().toDouble()), std::memory_order_relaxed);
+		}
+		const quint64 loaded = static_cast<quint64>(o.value("max").toDouble());
+		quint64 current = m_max.load(std::memory_order_relaxed);
+		while (loaded > current && !m_max.compare_exchange_weak(current, loaded, std::memory_order_relaxed))
+			;
+	}
+
+	////////////////////////////////////////////////////////////////////////////////
+
+} /* namespace tool */
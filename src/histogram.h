@@ -0,0 +1,43 @@
+#pragma once
+#include <QJsonObject>
+
+#include <array>
+#include <atomic>
+
+namespace tool
+{
+	////////////////////////////////////////////////////////////////////////////////
+
+	/** fixed log-linear histogram: 8 linear buckets per power of two, ~12% resolution
+		from 1 to 2^40. record() is lock-free and allocation-free, readers may run concurrently */
+	class LatencyHistogram
+	{
+	public:
+		static constexpr unsigned subBits = 3;
+		static constexpr unsigned maxExponent = 40;
+		static constexpr size_t bucketCount = (maxExponent - subBits + 2) << subBits;
+
+		LatencyHistogram();
+
+		void record(quint64);
+		quint64 count() const;
+		quint64 max() const;
+		/** upper bound of bucket holding p-th percentile (0..100), clamped to max */
+		quint64 percentile(double p) const;
+
+		/** sparse { "max": n, "buckets": { "index": count } } */
+		QJsonObject toJson() const;
+		/** merges recorded values into current ones */
+		void merge(const QJsonObject&);
+
+		static size_t bucketIndex(quint64);
+		static quint64 bucketUpper(size_t);
+
+	protected:
+		std::array<std::atomic<quint32>, bucketCount> m_buckets;
+		std::atomic<quint64> m_max{ 0 };
+	};
+
+	////////////////////////////////////////////////////////////////////////////////
+
+} /* namespace tool */
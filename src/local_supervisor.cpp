@@ -0,0 +1,692 @@
+#include "local_supervisor.h"
+#include "command_line.h"
+
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonObject>
+#include <QProcess>
+
+#include <stdexcept>
+
+#ifdef Q_OS_WIN
+#include <winsock2.h>
+#include <windows.h>
+#pragma comment(lib, "Ws2_32.lib")
+#else
+#include <arpa/inet.h>
+#include <csignal>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/select.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#ifndef SYS_pidfd_open
+#define SYS_pidfd_open 434
+#endif
+#endif
+
+#include <QDebug>
+
+////////////////////////////////////////////////////////////////////////////////
+
+namespace
+{
+	const int pendingCheckInterval = 100; // ms
+	/** pid file is written after process has started, mtime granularity aside */
+	const qint64 pidFileSlack = 2000; // ms
+
+	/** full path of image of running process, empty if it is gone or inaccessible */
+	QString executable(qint64 pid)
+	{
+#ifdef Q_OS_WIN
+		QString result;
+		if (HANDLE process = ::OpenProcess(PROCESS_QUERY_LIMITED_INFORMATION, FALSE, static_cast<DWORD>(pid)))
+		{
+			wchar_t path[MAX_PATH * 2];
+			DWORD size = sizeof(path) / sizeof(path[0]);
+			if (::QueryFullProcessImageNameW(process, 0, path, &size))
+				result = QDir::fromNativeSeparators(QString::fromWCharArray(path, static_cast<int>(size)));
+			::CloseHandle(process);
+		}
+		return result;
+#elif defined(Q_OS_LINUX)
+		const QString result = QFile::symLinkTarget(QString{ "/proc/%1/exe" }.arg(pid));
+		if (!result.isEmpty())
+			return result;
+		// exe of other user's process isnt readable, comm is (first 15 chars of name)
+		QFile comm{ QString{ "/proc/%1/comm" }.arg(pid) };
+		return comm.open(QIODevice::ReadOnly) ? QString::fromLocal8Bit(comm.readLine(64).trimmed()) : QString{};
+#else
+		Q_UNUSED(pid);
+		return QString{};
+#endif
+	}
+
+	/** ms since epoch, -1 if unknown */
+	qint64 startTime(qint64 pid)
+	{
+#ifdef Q_OS_WIN
+		qint64 result = -1;
+		if (HANDLE process = ::OpenProcess(PROCESS_QUERY_LIMITED_INFORMATION, FALSE, static_cast<DWORD>(pid)))
+		{
+			FILETIME creation, exit, kernel, user;
+			if (::GetProcessTimes(process, &creation, &exit, &kernel, &user))
+				result = static_cast<qint64>(((static_cast<quint64>(creation.dwHighDateTime) << 32) | creation.dwLowDateTime) / 10000)
+					- 11644473600000LL;
+			::CloseHandle(process);
+		}
+		return result;
+#elif defined(Q_OS_LINUX)
+		qint64 boot = -1;
+		QFile stat{ "/proc/stat" };
+		if (stat.open(QIODevice::ReadOnly))
+			for (QByteArray line = stat.readLine(); !line.isEmpty(); line = stat.readLine())
+				if (line.startsWith("btime "))
+				{
+					boot = line.mid(6).trimmed().toLongLong() * 1000;
+					break;
+				}
+		QFile process{ QString{ "/proc/%1/stat" }.arg(pid) };
+		const long ticks = ::sysconf(_SC_CLK_TCK);
+		if (boot < 0 || ticks <= 0 || !process.open(QIODevice::ReadOnly))
+			return -1;
+		// fields follow "(comm)", which may hold spaces. starttime is 22nd field
+		const QByteArray line = process.readAll();
+		const QList<QByteArray> fields = line.mid(line.lastIndexOf(')') + 2).split(' ');
+		return fields.size() < 20 ? -1 : boot + fields[19].toLongLong() * 1000 / ticks;
+#else
+		Q_UNUSED(pid);
+		return -1;
+#endif
+	}
+
+	/** image of process is command of service. relative commands are found by name only */
+	bool sameProgram(const QString& image, const LocalSupervisor::Definition& d)
+	{
+#ifdef Q_OS_WIN
+		const Qt::CaseSensitivity cs = Qt::CaseInsensitive;
+#else
+		const Qt::CaseSensitivity cs = Qt::CaseSensitive;
+#endif
+		const QFileInfo command{ QDir{ d.directory }, d.command };
+		if (!image.contains('/'))
+			return command.fileName().left(image.size()).compare(image, cs) == 0; // truncated comm
+		if (QFileInfo{ d.command }.isAbsolute() || d.command.contains('/'))
+			return QFileInfo{ image }.canonicalFilePath().compare(command.canonicalFilePath(), cs) == 0;
+		const QString name = QFileInfo{ image }.fileName();
+		return name.compare(command.fileName(), cs) == 0
+			|| name.compare(command.fileName() + ".exe", cs) == 0;
+	}
+
+	/** non blocking connect, so refused port on windows doesnt cost seconds of SYN retries */
+	bool portOpen(int port)
+	{
+#ifdef Q_OS_WIN
+		SOCKET s = ::socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+		if (s == INVALID_SOCKET)
+			return false;
+		u_long nonBlocking = 1;
+		::ioctlsocket(s, FIONBIO, &nonBlocking);
+#else
+		int s = ::socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+		if (s < 0)
+			return false;
+#endif
+		sockaddr_in address{};
+		address.sin_family = AF_INET;
+		address.sin_port = htons(static_cast<quint16>(port));
+		address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+		bool result = (::connect(s, reinterpret_cast<sockaddr*>(&address), sizeof(address)) == 0);
+		if (!result)
+		{
+			fd_set writable, failed;
+			FD_ZERO(&writable);
+			FD_ZERO(&failed);
+			FD_SET(s, &writable);
+			FD_SET(s, &failed);
+			timeval timeout{ 0, 50000 };
+			if (::select(static_cast<int>(s + 1), nullptr, &writable, &failed, &timeout) > 0 && !FD_ISSET(s, &failed))
+			{
+				int error = 0;
+#ifdef Q_OS_WIN
+				int size = sizeof(error);
+				::getsockopt(s, SOL_SOCKET, SO_ERROR, reinterpret_cast<char*>(&error), &size);
+#else
+				socklen_t size = sizeof(error);
+				::getsockopt(s, SOL_SOCKET, SO_ERROR, &error, &size);
+#endif
+				result = (error == 0);
+			}
+		}
+#ifdef Q_OS_WIN
+		::closesocket(s);
+#else
+		::close(s);
+#endif
+		return result;
+	}
+} // namespace
+
+////////////////////////////////////////////////////////////////////////////////
+
+LocalSupervisor* LocalSupervisor::instance(SingletonPolicy policy)
+{
+	static LocalSupervisor* instance{ nullptr };
+	if (policy == Get && instance == nullptr)
+		instance = new LocalSupervisor;
+	if (policy == Release && instance != nullptr)
+		delete instance, instance = nullptr;
+	return instance;
+}
+
+LocalSupervisor::LocalSupervisor()
+{
+#ifdef Q_OS_WIN
+	WSADATA data;
+	::WSAStartup(MAKEWORD(2, 2), &data);
+	m_wake = ::CreateEventW(nullptr, FALSE, FALSE, nullptr);
+#else
+	m_epoll = ::epoll_create1(EPOLL_CLOEXEC);
+	m_wake = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+	epoll_event e{};
+	e.events = EPOLLIN;
+	e.data.u64 = 0;
+	if (m_epoll < 0 || m_wake < 0 || ::epoll_ctl(m_epoll, EPOLL_CTL_ADD, m_wake, &e) < 0)
+		throw std::runtime_error("local supervisor: epoll setup failed");
+#endif
+}
+
+LocalSupervisor::~LocalSupervisor()
+{
+	{
+		auto lock = std::lock_guard{ m_lock };
+		m_stop = true;
+	}
+	wake();
+	if (m_thread.joinable())
+		m_thread.join();
+	// services outlive us, next run adopts them by pid file
+	for (auto& s : m_services)
+		unwatch(s);
+#ifdef Q_OS_WIN
+	::CloseHandle(m_wake);
+	::WSACleanup();
+#else
+	::close(m_wake);
+	::close(m_epoll);
+#endif
+}
+
+void LocalSupervisor::configure(const QJsonArray& config)
+{
+	if (m_thread.joinable())
+		throw std::runtime_error("local services are configured once");
+	for (const auto& value : config)
+	{
+		if (!value.isObject())
+			throw std::runtime_error("local service must be object");
+		const QJsonObject o = value.toObject();
+		Service s;
+		Definition& d = s.definition;
+		d.name = o.value("name").toString();
+		d.command = o.value("command").toString();
+		d.directory = o.value("directory").toString();
+		for (const auto& arg : o.value("arguments").toArray())
+			d.arguments.push_back(arg.toString());
+		d.pidFile = o.value("pidFile").toString();
+		d.readyFile = o.value("readyFile").toString();
+		d.readyPort = o.value("readyPort").toInt();
+		d.stopCommand = o.value("stopCommand").toString();
+		for (const auto& arg : o.value("stopArguments").toArray())
+			d.stopArguments.push_back(arg.toString());
+		d.startTimeout = o.value("startTimeout").toInt(d.startTimeout);
+		d.stopTimeout = o.value("stopTimeout").toInt(d.stopTimeout);
+		if (d.name.isEmpty() || d.command.isEmpty())
+			throw std::runtime_error("local service requires name and command");
+		m_services.push_back(s);
+	}
+	for (auto& s : m_services)
+		adopt(s);
+	if (!m_services.empty())
+		m_thread = std::thread(&LocalSupervisor::run, this);
+}
+
+pServiceControl LocalSupervisor::find(const QString& name)
+{
+	const Definition* d = definition(name);
+	return d != nullptr ? std::make_shared<LocalService>(this, *d) : nullptr;
+}
+
+std::deque<pServiceControl> LocalSupervisor::services()
+{
+	std::deque<pServiceControl> result;
+	for (const auto& s : m_services)
+		result.push_back(std::make_shared<LocalService>(this, s.definition));
+	return result;
+}
+
+const LocalSupervisor::Definition* LocalSupervisor::definition(const QString& name) const
+{
+	// definitions are immutable after configure
+	for (const auto& s : m_services)
+		if (s.definition.name == name)
+			return &s.definition;
+	return nullptr;
+}
+
+int LocalSupervisor::listen(Listener listener)
+{
+	auto lock = std::lock_guard{ m_notifyLock };
+	m_listeners[m_nextListener] = std::move(listener);
+	return m_nextListener++;
+}
+
+void LocalSupervisor::unlisten(int id)
+{
+	auto lock = std::lock_guard{ m_notifyLock };
+	m_listeners.erase(id);
+}
+
+ServiceControl::State LocalSupervisor::state(const QString& name)
+{
+	auto lock = std::lock_guard{ m_lock };
+	for (const auto& s : m_services)
+		if (s.definition.name == name)
+			return s.state;
+	return ServiceControl::Unknown;
+}
+
+int LocalSupervisor::start(const QString& name)
+{
+	{
+		auto lock = std::lock_guard{ m_lock };
+		m_commands.emplace_back(name, Start);
+	}
+	wake();
+	return 0;
+}
+
+int LocalSupervisor::stop(const QString& name)
+{
+	{
+		auto lock = std::lock_guard{ m_lock };
+		m_commands.emplace_back(name, Stop);
+	}
+	wake();
+	return 0;
+}
+
+void LocalSupervisor::wake()
+{
+#ifdef Q_OS_WIN
+	::SetEvent(m_wake);
+#else
+	const uint64_t one = 1;
+	if (::write(m_wake, &one, sizeof(one)) < 0)
+		qDebug() << "local supervisor: wake failed";
+#endif
+}
+
+void LocalSupervisor::run()
+{
+	while (true)
+	{
+		std::deque<std::pair<QString, Command>> commands;
+		{
+			auto lock = std::lock_guard{ m_lock };
+			if (m_stop)
+				break;
+			commands.swap(m_commands);
+		}
+		// process fields are changed only by this thread, so spawning, stop commands and
+		// readiness probes run without lock and dont hold up state() or new commands
+		for (const auto& [name, command] : commands)
+			for (size_t i = 0; i < m_services.size(); ++i)
+				if (m_services[i].definition.name == name)
+					execute(i, command);
+		int timeout = -1;
+		for (size_t i = 0; i < m_services.size(); ++i)
+		{
+			check(i);
+			const Service& s = m_services[i];
+			const bool polled =
+#ifdef Q_OS_WIN
+				false;
+#else
+				(s.pid != 0 && s.pidfd < 0);
+#endif
+			if (s.state >= ServiceControl::StartPending || polled)
+				timeout = pendingCheckInterval;
+		}
+		notify();
+		for (const size_t i : wait(timeout))
+			exited(m_services[i]);
+		notify();
+	}
+}
+
+std::vector<size_t> LocalSupervisor::wait(int timeout)
+{
+	std::vector<size_t> result;
+#ifdef Q_OS_WIN
+	std::vector<HANDLE> handles{ m_wake };
+	std::vector<size_t> index{ 0 };
+	for (size_t i = 0; i < m_services.size() && handles.size() < MAXIMUM_WAIT_OBJECTS; ++i)
+		if (m_services[i].handle != nullptr)
+		{
+			handles.push_back(m_services[i].handle);
+			index.push_back(i);
+		}
+	const DWORD r = ::WaitForMultipleObjects(static_cast<DWORD>(handles.size()), handles.data(), FALSE,
+		timeout < 0 ? INFINITE : static_cast<DWORD>(timeout));
+	if (r > WAIT_OBJECT_0 && r < WAIT_OBJECT_0 + handles.size())
+		result.push_back(index[r - WAIT_OBJECT_0]);
+#else
+	epoll_event events[16];
+	const int n = ::epoll_wait(m_epoll, events, 16, timeout);
+	for (int i = 0; i < n; ++i)
+	{
+		if (events[i].data.u64 == 0)
+		{
+			uint64_t value;
+			if (::read(m_wake, &value, sizeof(value)) < 0)
+				continue;
+		}
+		else
+			result.push_back(static_cast<size_t>(events[i].data.u64 - 1));
+	}
+#endif
+	return result;
+}
+
+void LocalSupervisor::execute(size_t i, Command command)
+{
+	Service& s = m_services[i];
+	const auto now = Clock::now();
+	if (command == Start && (s.state == ServiceControl::Stopped || s.state == ServiceControl::Unknown))
+	{
+		if (!spawn(s))
+			return setState(s, ServiceControl::Stopped);
+		s.deadline = now + std::chrono::milliseconds(s.definition.startTimeout);
+		setState(s, ready(s) ? ServiceControl::Running : ServiceControl::StartPending);
+	}
+	if (command == Stop && (s.state == ServiceControl::Running || s.state == ServiceControl::StartPending))
+	{
+		s.deadline = now + std::chrono::milliseconds(s.definition.stopTimeout);
+		if (s.definition.stopCommand.isEmpty())
+			terminate(s, false);
+		else if (!QProcess::startDetached(s.definition.stopCommand, s.definition.stopArguments, s.definition.directory))
+			terminate(s, false);
+		setState(s, ServiceControl::StopPending);
+	}
+}
+
+void LocalSupervisor::check(size_t i)
+{
+	Service& s = m_services[i];
+#ifndef Q_OS_WIN
+	if (s.pid != 0 && s.pidfd < 0)
+	{ // kernel without pidfd, liveness is polled
+		const bool gone = s.child ? ::waitpid(static_cast<pid_t>(s.pid), nullptr, WNOHANG) != 0 : ::kill(static_cast<pid_t>(s.pid), 0) != 0;
+		if (gone)
+			return exited(s);
+	}
+#endif
+	const auto now = Clock::now();
+	if (s.state == ServiceControl::StartPending)
+	{
+		if (ready(s))
+			setState(s, ServiceControl::Running);
+		else if (now > s.deadline)
+		{
+			qWarning() << "local service" << s.definition.name << "not ready in" << s.definition.startTimeout << "ms";
+			terminate(s, true);
+			s.deadline = now + std::chrono::milliseconds(s.definition.stopTimeout);
+			setState(s, ServiceControl::StopPending);
+		}
+	}
+	else if (s.state == ServiceControl::StopPending && now > s.deadline && !s.killed)
+		terminate(s, true);
+}
+
+void LocalSupervisor::adopt(Service& s)
+{
+	if (s.definition.pidFile.isEmpty())
+		return;
+	QFile file{ s.definition.pidFile };
+	if (!file.open(QIODevice::ReadOnly))
+		return;
+	const qint64 pid = file.readLine().trimmed().toLongLong();
+	if (pid <= 0)
+		return;
+	// pid of stale file may belong to anything by now
+	const qint64 written = QFileInfo{ file }.lastModified().toMSecsSinceEpoch();
+	const QString program = executable(pid);
+	const qint64 started = startTime(pid);
+	if (program.isEmpty() || !sameProgram(program, s.definition) || started < 0 || started > written + pidFileSlack)
+	{
+		qInfo() << "local service" << s.definition.name << "pid file is stale, pid" << pid << program;
+		return;
+	}
+#ifdef Q_OS_WIN
+	s.handle = ::OpenProcess(SYNCHRONIZE | PROCESS_TERMINATE, FALSE, static_cast<DWORD>(pid));
+	if (s.handle == nullptr)
+		return;
+#endif
+	s.pid = pid;
+	s.child = false;
+	watch(s);
+	// supervisor thread promotes it once ready, as if it was started by us
+	s.deadline = Clock::now() + std::chrono::milliseconds(s.definition.startTimeout);
+	s.state = ServiceControl::StartPending;
+	qInfo() << "local service" << s.definition.name << "adopted, pid" << pid;
+}
+
+bool LocalSupervisor::spawn(Service& s)
+{
+	const Definition& d = s.definition;
+	s.killed = false;
+#ifdef Q_OS_WIN
+	std::wstring commandLine = tool::CommandLine::join(QStringList{ d.command } + d.arguments, tool::CommandLine::Windows).toStdWString();
+	const std::wstring directory = QDir::toNativeSeparators(d.directory).toStdWString();
+	STARTUPINFOW si{};
+	si.cb = sizeof(si);
+	PROCESS_INFORMATION pi{};
+	if (!::CreateProcessW(nullptr, &commandLine[0], nullptr, nullptr, FALSE,
+			CREATE_NO_WINDOW | CREATE_NEW_PROCESS_GROUP, nullptr,
+			directory.empty() ? nullptr : directory.c_str(), &si, &pi))
+	{
+		qWarning() << "local service" << d.name << "failed to start, error" << ::GetLastError();
+		return false;
+	}
+	::CloseHandle(pi.hThread);
+	s.handle = pi.hProcess;
+	s.pid = pi.dwProcessId;
+#else
+	// everything exec needs is prepared before fork
+	std::vector<QByteArray> args{ QFile::encodeName(d.command) };
+	for (const auto& a : d.arguments)
+		args.push_back(a.toLocal8Bit());
+	std::vector<char*> argv;
+	for (auto& a : args)
+		argv.push_back(a.data());
+	argv.push_back(nullptr);
+	const QByteArray directory = QFile::encodeName(d.directory);
+
+	const pid_t pid = ::fork();
+	if (pid < 0)
+	{
+		qWarning() << "local service" << d.name << "fork failed";
+		return false;
+	}
+	if (pid == 0)
+	{ // own process group, so stop reaches children of service too
+		::setsid();
+		if (!directory.isEmpty() && ::chdir(directory.constData()) != 0)
+			::_exit(126);
+		::execvp(argv[0], argv.data());
+		::_exit(127);
+	}
+	s.pid = pid;
+#endif
+	s.child = true;
+	watch(s);
+	if (!d.pidFile.isEmpty())
+	{
+		QFile file{ d.pidFile };
+		if (file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+			file.write(QByteArray::number(s.pid) + '\n');
+	}
+	qInfo() << "local service" << d.name << "started, pid" << s.pid;
+	return true;
+}
+
+void LocalSupervisor::watch(Service& s)
+{
+#ifndef Q_OS_WIN
+	s.pidfd = static_cast<int>(::syscall(SYS_pidfd_open, static_cast<pid_t>(s.pid), 0));
+	if (s.pidfd < 0)
+		return; // polled by check()
+	epoll_event e{};
+	e.events = EPOLLIN;
+	e.data.u64 = static_cast<uint64_t>(&s - m_services.data()) + 1;
+	if (::epoll_ctl(m_epoll, EPOLL_CTL_ADD, s.pidfd, &e) < 0)
+	{
+		::close(s.pidfd);
+		s.pidfd = -1;
+	}
+#else
+	Q_UNUSED(s);
+#endif
+}
+
+void LocalSupervisor::unwatch(Service& s)
+{
+#ifdef Q_OS_WIN
+	if (s.handle != nullptr)
+		::CloseHandle(s.handle);
+	s.handle = nullptr;
+#else
+	if (s.pidfd >= 0)
+	{
+		::epoll_ctl(m_epoll, EPOLL_CTL_DEL, s.pidfd, nullptr);
+		::close(s.pidfd);
+	}
+	s.pidfd = -1;
+#endif
+}
+
+void LocalSupervisor::terminate(Service& s, bool force)
+{
+	if (s.pid == 0)
+		return;
+	s.killed = s.killed || force;
+#ifdef Q_OS_WIN
+	// no signals on windows, graceful stop needs stopCommand
+	Q_UNUSED(force);
+	if (s.handle != nullptr)
+		::TerminateProcess(s.handle, 1);
+#else
+	const pid_t target = s.child ? -static_cast<pid_t>(s.pid) : static_cast<pid_t>(s.pid);
+	::kill(target, force ? SIGKILL : SIGTERM);
+#endif
+}
+
+void LocalSupervisor::exited(Service& s)
+{
+	if (s.pid == 0)
+		return;
+#ifndef Q_OS_WIN
+	if (s.child)
+		::waitpid(static_cast<pid_t>(s.pid), nullptr, WNOHANG);
+#endif
+	unwatch(s);
+	if (!s.definition.pidFile.isEmpty())
+		QFile::remove(s.definition.pidFile);
+	if (s.state == ServiceControl::Running || s.state == ServiceControl::StartPending)
+		qWarning() << "local service" << s.definition.name << "exited unexpectedly";
+	s.pid = 0;
+	setState(s, ServiceControl::Stopped);
+}
+
+bool LocalSupervisor::ready(const Service& s) const
+{
+	const Definition& d = s.definition;
+	if (!d.readyFile.isEmpty() && !QFileInfo::exists(d.readyFile))
+		return false;
+	if (d.readyPort != 0 && !portOpen(d.readyPort))
+		return false;
+	return true;
+}
+
+void LocalSupervisor::setState(Service& s, ServiceControl::State state)
+{
+	// only supervisor thread writes state, others read it under lock
+	auto lock = std::lock_guard{ m_lock };
+	if (s.state == state)
+		return;
+	s.state = state;
+	m_notifications.emplace_back(s.definition.name, state);
+}
+
+void LocalSupervisor::notify()
+{
+	decltype(m_notifications) notifications;
+	{
+		auto lock = std::lock_guard{ m_lock };
+		notifications.swap(m_notifications);
+	}
+	if (notifications.empty())
+		return;
+	auto lock = std::lock_guard{ m_notifyLock };
+	for (const auto& [name, state] : notifications)
+		for (const auto& [id, listener] : m_listeners)
+			listener(name, state);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+LocalService::LocalService(LocalSupervisor* owner, const LocalSupervisor::Definition& d)
+	: m_owner(owner)
+	, m_name(d.name)
+	, m_path(QFileInfo{ d.command }.absoluteFilePath())
+{}
+
+const QString LocalService::name() const
+{
+	return m_name;
+}
+
+const QString LocalService::path() const
+{
+	return m_path;
+}
+
+ServiceControl::State LocalService::state()
+{
+	return m_owner->state(m_name);
+}
+
+int LocalService::start()
+{
+	return m_owner->start(m_name);
+}
+
+int LocalService::stop()
+{
+	return m_owner->stop(m_name);
+}
+
+int LocalService::resume()
+{
+	return m_owner->start(m_name);
+}
+
+////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,139 @@
+#pragma once
+#include "service_control.h"
+#include "settings.h"
+
+#include <QStringList>
+
+#include <chrono>
+#include <deque>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class QJsonArray;
+
+////////////////////////////////////////////////////////////////////////////////
+
+/** built-in supervisor of commands declared as "local_services" in qt_chooser.json,
+	so services row works without windows SCM. one thread waits on all processes
+	(epoll over pidfd on linux, WaitForMultipleObjects on windows) */
+class LocalSupervisor
+{
+public:
+	using Clock = std::chrono::steady_clock;
+	/** invoked on supervisor thread without its lock held */
+	using Listener = std::function<void(const QString& serviceName, ServiceControl::State)>;
+
+	struct Definition
+	{
+		QString name, command, directory;
+		QStringList arguments;
+		QString pidFile;    // pid of running service, written on start, adopted on launch
+		QString readyFile;  // service is ready once file exists
+		int readyPort = 0;  // or once localhost port accepts connections
+		QString stopCommand; // graceful stop, default is SIGTERM (terminate on windows)
+		QStringList stopArguments;
+		int startTimeout = 30000; // ms, not ready by then - killed
+		int stopTimeout = 10000;  // ms, graceful stop, killed after
+	};
+
+	static LocalSupervisor* instance(SingletonPolicy = Get);
+	~LocalSupervisor();
+
+	/** called once on startup, services left running by previous run are adopted by pid file */
+	void configure(const QJsonArray&);
+	/** null if there is no such local service */
+	pServiceControl find(const QString&);
+	std::deque<pServiceControl> services();
+	const Definition* definition(const QString&) const;
+
+	int listen(Listener);
+	void unlisten(int);
+
+	ServiceControl::State state(const QString&);
+	/** queued to supervisor thread, returns 0 as StartService does */
+	int start(const QString&);
+	int stop(const QString&);
+
+protected:
+	LocalSupervisor();
+
+	struct Service
+	{
+		Definition definition;
+		ServiceControl::State state = ServiceControl::Stopped;
+		qint64 pid = 0;
+		bool child = false, killed = false;
+		Clock::time_point deadline;
+#ifdef Q_OS_WIN
+		void* handle = nullptr;
+#else
+		int pidfd = -1;
+#endif
+	};
+	enum Command
+	{
+		Start,
+		Stop,
+	};
+
+	void run();
+	void wake();
+	/** waits for process exit, command or timeout. returns services whose process has exited */
+	std::vector<size_t> wait(int timeout);
+	void execute(size_t, Command);
+	/** readiness and deadlines of pending services */
+	void check(size_t);
+	/** takes over process of pid file if it runs our command and started before file was written */
+	void adopt(Service&);
+	bool spawn(Service&);
+	void watch(Service&);
+	void unwatch(Service&);
+	void terminate(Service&, bool force);
+	void exited(Service&);
+	bool ready(const Service&) const;
+	/** takes m_lock, state is read by other threads */
+	void setState(Service&, ServiceControl::State);
+	/** delivers queued state changes to listeners, must be called without m_lock */
+	void notify();
+
+protected:
+	mutable std::mutex m_lock;
+	std::vector<Service> m_services;
+	std::deque<std::pair<QString, Command>> m_commands;
+	std::mutex m_notifyLock; // held while listeners run, so unlisten waits for them
+	std::map<int, Listener> m_listeners;
+	int m_nextListener = 0;
+	std::vector<std::pair<QString, ServiceControl::State>> m_notifications;
+	bool m_stop = false;
+#ifdef Q_OS_WIN
+	void* m_wake = nullptr;
+#else
+	int m_epoll = -1, m_wake = -1;
+#endif
+	std::thread m_thread;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+
+/** service of local supervisor */
+class LocalService : public ServiceControl
+{
+public:
+	LocalService(LocalSupervisor*, const LocalSupervisor::Definition&);
+
+	const QString name() const override;
+	const QString path() const override;
+	State state() override;
+	int start() override;
+	int stop() override;
+	int resume() override;
+
+protected:
+	LocalSupervisor* const m_owner;
+	const QString m_name, m_path;
+};
+
+////////////////////////////////////////////////////////////////////////////////
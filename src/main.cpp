@@ -3,6 +3,8 @@
 #include "wmi_process.h"
 #include "wmi_service.h"
 #include "pg_version.h"
+#include "profiler.h"
+#include "thread_sampler.h"
 
 #include <QApplication>
 #include <QMessageBox>
@@ -13,17 +15,22 @@
 #include <exception>
 #include <functional>
 #include <thread>
-#include <windows.h>
+#ifdef Q_OS_WIN
+#	include <windows.h>
+#endif
 
 int main(int argc, char** argv)
 {
 	qRegisterMetaType<tool::WmiObject>();
 	qRegisterMetaType<WmiProcess>();
 	qRegisterMetaType<pWmiService>();
+	qRegisterMetaType<pServiceControl>();
 	qRegisterMetaType<pg::PGVersion>();
 	qRegisterMetaType<pg::PGCluster>();
 	qRegisterMetaType<pg::PGVersion::List>();
 	qRegisterMetaType<pg::PGCluster::List>();
+	qRegisterMetaType<tool::pProfile>();
+	qRegisterMetaType<tool::ThreadSampler::List>();
 	QTextStream out{ stdout };
 	QApplication app(argc, argv);
 	Settings::setup();
@@ -31,8 +38,10 @@ int main(int argc, char** argv)
 	{
 		QTextCodec::setCodecForLocale(QTextCodec::codecForName("UTF8"));
 
+#ifdef Q_OS_WIN
 		// disabling qt-s com initialization
 		::OleUninitialize();
+#endif
 		tool::CoInitialize com;
 
 		qDebug() << "hello world!";
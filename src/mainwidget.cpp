@@ -2,8 +2,15 @@
 #include "settings.h"
 #include "tooling.h"
 #include "service.h"
+#include "service_group.h"
 #include "process.h"
 #include "pg_widget.h"
+#include "service_registry.h"
+#include "local_supervisor.h"
+#include "service_stats.h"
+#include "event_log.h"
+#include "pg_liveness.h"
+#include "pg_version_cache.h"
 
 #include "ui_symlinkframe.h"
 #include "ui_moveframe.h"
@@ -242,12 +249,24 @@ DesktopWidget::DesktopWidget(QWidget* parent)
 DesktopWidget::~DesktopWidget()
 {
 	QObject::disconnect(m_setup, &Settings::configUpdated, this, &DesktopWidget::configUpdated);
+	// last manager stops service poller, it must not be resolving services after registry release
+	qDeleteAll(findChildren<ServiceManager*>());
+	qDeleteAll(findChildren<ServiceGroupManager*>());
+	// discovery is cancelled and awaited, it looks services up in registry
+	qDeleteAll(findChildren<PostgresManager*>());
+	pg::VersionCache::instance(Release);
+	pg::Liveness::instance(Release);
+	ServiceStatistics::instance(Release);
+	LocalSupervisor::instance(Release);
+	EventLog::instance(Release);
 
 	QJsonObject& param = m_setup->params();
 	QRect g = this->geometry();
 	param["geometry"] = QJsonArray{ g.x(), g.y(), g.width(), g.height() };
 	m_setup = nullptr;
 	Settings::setup(Release);
+	// service objects must not outlive COM, subscribers keep their own handles
+	ServiceRegistry::instance(Release);
 }
 
 void DesktopWidget::configUpdated()
@@ -280,6 +299,14 @@ void DesktopWidget::init()
 	if (!param.value("services").isArray())
 		throw std::runtime_error("service parameter must be array");
 
+	// created here, before service and postgres managers query it from their threads
+	LocalSupervisor::instance()->configure(param.value("local_services").toArray());
+	ServiceRegistry::instance();
+	ServiceStatistics::instance();
+	EventLog::instance();
+	pg::VersionCache::instance();
+	pg::Liveness::instance();
+
 	QHBoxLayout* h = new QHBoxLayout;
 	QVBoxLayout* v = new QVBoxLayout;
 
@@ -288,12 +315,23 @@ void DesktopWidget::init()
 	v->setContentsMargins(0, 0, 0, 0);
 	v->setSpacing(0);
 
+	const int pollInterval = m_setup->get("service_poll_interval", 100).toInt();
 	for (const auto& value : param.value("services").toArray())
 	{
-		if (!value.isString())
-			throw std::runtime_error("service must be object");
-		const QString serviceName = value.toString();
-		h->addWidget(new ServiceManager{ serviceName, this });
+		// "name" or { "name": "...", "interval": ms }
+		if (!value.isString() && !value.isObject())
+			throw std::runtime_error("service must be string or object");
+		const QString serviceName = value.isString() ? value.toString() : value.toObject().value("name").toString();
+		const int interval = value.isObject() ? value.toObject().value("interval").toInt(pollInterval) : pollInterval;
+		if (serviceName.isEmpty())
+			throw std::runtime_error("service name is empty");
+		h->addWidget(new ServiceManager{ serviceName, interval, this });
+	}
+	for (const auto& value : param.value("service_groups").toArray())
+	{
+		if (!value.isObject())
+			throw std::runtime_error("service group must be object");
+		h->addWidget(new ServiceGroupManager{ value.toObject(), this });
 	}
 	h->addSpacerItem(new QSpacerItem{ 0, 0, QSizePolicy::Expanding, QSizePolicy::Maximum });
 	h->addWidget(new SymlinkinQtWidget{ m_setup, this });
@@ -1,31 +1,20 @@
 #include "pg_conf.h"
+#include "pg_conf_lexer.h"
+#include "pg_guc_catalog.h"
+#include "suggestion_index.h"
 
+#include <QDir>
 #include <QFileInfo>
-#include <QRegularExpression>
+#include <QSaveFile>
 #include <QDebug>
 #include <QTimeZone>
 
+#include <algorithm>
+
 namespace pg
 {
 	////////////////////////////////////////////////////////////////////////////////
 
-	QStringList findLooksLike(const QStringList& keys, const QString& v)
-	{
-		if (v.isEmpty() || keys.isEmpty())
-			return {};
-		QString pattern{ v };
-		while (!pattern.isEmpty())
-		{
-			QStringList matches = keys.filter(QRegularExpression{ QString{ "%1" }.arg(pattern) });
-			if (!matches.isEmpty())
-				return matches;
-			pattern.chop(1);
-		}
-		return {};
-	}
-
-	////////////////////////////////////////////////////////////////////////////////
-
 	Parameter::Parameter(const Position& pos, const QString& n, bool c)
 		: position(pos)
 		, value(n)
@@ -45,9 +34,18 @@ namespace pg
 	{
 		if (value.startsWith('"') && value.endsWith('"'))
 			return value.mid(1, value.size() - 2);
-		if (value.startsWith('\'') && value.endsWith('\''))
-			return value.mid(1, value.size() - 2);
-		return value;
+		if (value.size() < 2 || !value.startsWith('\'') || !value.endsWith('\''))
+			return value;
+		// '' and backslash escapes of quoted string
+		QString result;
+		result.reserve(value.size() - 2);
+		for (int i = 1; i < value.size() - 1; ++i)
+		{
+			if ((value[i] == '\\' || (value[i] == '\'' && value[i + 1] == '\'')) && i + 1 < value.size() - 1)
+				++i;
+			result.push_back(value[i]);
+		}
+		return result;
 	}
 
 	////////////////////////////////////////////////////////////////////////////////
@@ -73,16 +71,91 @@ namespace pg
 		return result;
 	}
 
+	void Patch::stage(const QString& key, const Parameter& original, const Parameter& replace)
+	{
+		m_edits[original.position.seek] = Edit{ key.toUtf8(), original, replace.value.toUtf8(), replace.commented };
+	}
+
+	bool Patch::empty() const
+	{
+		return m_edits.empty();
+	}
+
+	QString Patch::filename() const
+	{
+		return m_filename;
+	}
+
 	void Patch::commit(QTextStream& stream, const QString& label, bool write)
+	{
+		if (m_edits.empty())
+			return;
+		QFile file{ m_filename };
+		if (!file.open(QIODevice::ReadOnly))
+			throw std::runtime_error{ "cannot open file" };
+		const QByteArray content = file.readAll();
+		file.close();
+		QStringList errors;
+		const QByteArray result = apply(content, errors);
+		if (!errors.isEmpty())
+			throw std::runtime_error{ QString{ "cannot patch file: %1" }.arg(errors.join("; ")).toUtf8() };
+		diff(stream, label);
+		if (write)
+			save(result);
+	}
+
+	QByteArray Patch::apply(const QByteArray& content, QStringList& errors)
+	{
+		m_changes.clear();
+		QByteArray result;
+		result.reserve(content.size() + 64);
+		int copied = 0;
+		const auto text = [](QByteArray line) { // diff line, newline normalized
+			if (line.endsWith('\n'))
+				line.chop(1);
+			if (line.endsWith('\r'))
+				line.chop(1);
+			return QString::fromUtf8(line) + '\n';
+		};
+		for (const auto& [seek, edit] : m_edits)
+		{
+			const Parameter::Position& at = edit.original.position;
+			const QString where = QString{ "%1:%2" }.arg(QFileInfo{ m_filename }.fileName()).arg(at.line);
+			if (seek < copied || seek >= content.size())
+			{
+				errors.push_back(QString{ "%1 is beyond end of file" }.arg(where));
+				continue;
+			}
+			const int begin = static_cast<int>(seek);
+			const int eol = content.indexOf('\n', begin);
+			const int end = eol < 0 ? content.size() : eol + 1;
+			const QByteArray line = content.mid(begin, end - begin);
+			// file must hold what was loaded, otherwise it has changed since
+			if (line.mid(at.key, edit.key.size()) != edit.key || line.mid(at.value, at.length) != edit.original.value.toUtf8())
+			{
+				errors.push_back(QString{ "%1 doesnt hold %2 = %3 anymore" }.arg(where).arg(QString::fromUtf8(edit.key)).arg(edit.original.value));
+				continue;
+			}
+			const bool hashed = at.key > 0 && line[at.key - 1] == '#';
+			const QByteArray replaced = line.left(hashed ? at.key - 1 : at.key)
+				+ (edit.commented ? "#" : "")
+				+ line.mid(at.key, at.value - at.key)
+				+ edit.value
+				+ line.mid(at.value + at.length);
+			result.append(content.constData() + copied, begin - copied);
+			result.append(replaced);
+			copied = end;
+			m_changes[at.line] = { text(line), text(replaced) };
+		}
+		result.append(content.constData() + copied, content.size() - copied);
+		return result;
+	}
+
+	void Patch::diff(QTextStream& stream, const QString& label)
 	{
 		if (m_changes.empty())
 			return;
-		QFile
-			file{ m_filename };
-		QStringList content;
 		QString filename{ QFileInfo{ m_filename }.fileName() };
-		if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) // | QIODevice::Append))
-			throw std::runtime_error{ "cannot open file" };
 		stream
 			<< "--- "
 			<< left << qSetFieldWidth(filename.size() < 28 ? 21 : filename.size() + 3)
@@ -90,34 +163,18 @@ namespace pg
 			<< "+++ "
 			<< left << qSetFieldWidth(filename.size() < 28 ? 21 : filename.size() + 3)
 			<< filename << reset << timestamp() << endl;
-		file.seek(0);
-		long long lineNo = 0;
-		while (!file.atEnd())
-		{
-			++lineNo;
-			const QString line = file.readLine();
-			auto change = m_changes.find(lineNo);
-			if (change != m_changes.end())
-			{
-				if (line != change->second.first)
-					throw std::runtime_error{ "cannot patch file" };
-				content.push_back(change->second.second);
-			}
-			else
-				content.push_back(line);
-		}
-		file.close();
 		Data::iterator it = m_changes.begin();
 		while (it != m_changes.end())
 			stream << chunk(it);
-		if (write)
-		{
-			if (!file.open(QIODevice::WriteOnly | QIODevice::Text | QIODevice::Truncate))
-				throw std::runtime_error{ "cannot open file for writing" };
-			for (const auto& line : content)
-				file.write(line.toUtf8());
-			file.close();
-		}
+	}
+
+	void Patch::save(const QByteArray& content)
+	{
+		// QSaveFile writes temporary file next to target, syncs it and renames over target
+		QSaveFile file{ m_filename };
+		if (!file.open(QIODevice::WriteOnly) || file.write(content) != content.size() || !file.commit())
+			throw std::runtime_error{ QString{ "cannot write %1: %2" }.arg(m_filename).arg(file.errorString()).toUtf8() };
+		m_edits.clear();
 	}
 
 	QString Patch::chunk(Data::iterator& it)
@@ -156,7 +213,7 @@ namespace pg
 	////////////////////////////////////////////////////////////////////////////////
 
 	Configuration::Configuration(const QString& fname)
-		: Patch(fname)
+		: Patch(QFileInfo{ fname }.absoluteFilePath())
 	{
 		if (!QFileInfo{ fname }.exists())
 			throw std::runtime_error{ "configuration file not found" };
@@ -165,120 +222,279 @@ namespace pg
 
 	Parameter Configuration::get(const QString& param) const
 	{
-		if (!m_config.contains(param))
+		const auto o = m_overrides.find(param);
+		if (o != m_overrides.end())
+			return *o;
+		const auto it = m_config.find(param);
+		if (it == m_config.end())
 		{
 			QString errorMessage = QString{ "parameter %1 not found" }.arg(param);
-			auto alt = findLooksLike(m_config.keys(), param);
+			const QStringList alt = suggest(param, 5);
 			if (!alt.isEmpty())
 				errorMessage = QString{ "%1. Alternatives: [%2]" }.arg(errorMessage).arg(alt.join(", "));
 			throw std::runtime_error{ errorMessage.toUtf8() };
 		}
-		return m_config[param];
+		return *it;
+	}
+
+	bool Configuration::contains(const QString& param) const
+	{
+		return m_overrides.contains(param) || m_config.contains(param);
 	}
 
 	QStringList Configuration::parameters() const
 	{
-		return m_config.keys();
+		QStringList result = m_config.keys();
+		for (auto it = m_overrides.begin(); it != m_overrides.end(); ++it)
+			if (!m_config.contains(it.key()))
+				result.push_back(it.key());
+		return result;
+	}
+
+	QStringList Configuration::suggest(const QString& param, int count) const
+	{
+		return index().suggest(param, count);
+	}
+
+	QStringList Configuration::search(const QString& text, int count) const
+	{
+		return index().search(text, count);
+	}
+
+	const tool::SuggestionIndex& Configuration::index() const
+	{
+		// built on first use, spelling of parameters in files wins over catalog
+		if (!m_index)
+			m_index = std::make_shared<tool::SuggestionIndex>(parameters() + knownParameters());
+		return *m_index;
+	}
+
+	QStringList Configuration::files() const
+	{
+		return m_files;
+	}
+
+	void Configuration::override(const QString& param, const QString& value, const QString& source)
+	{
+		Parameter parameter{ value };
+		parameter.file = source;
+		m_overrides[param] = parameter;
+		m_index.reset();
+	}
+
+	void Configuration::clearOverrides()
+	{
+		m_overrides.clear();
+		m_index.reset();
 	}
 
 	void Configuration::set(const QString& param, const Parameter& replace)
 	{
-		static const std::vector<std::pair<QString, QString>> re_screener = {
-			{ "-", "\\-" },
-			{ "+", "\\+" },
-			{ "*", "\\*" },
-			{ ".", "\\." },
-			{ "(", "\\(" },
-			{ ")", "\\)" },
-			{ "$", "\\$" },
-			{ "^", "\\^" },
-		};
-		auto original = get(param);
-		QFile
-			file{ m_filename };
-		if (!file.open(QIODevice::ReadOnly | QIODevice::Text))
-			throw std::runtime_error{ "cannot open file" };
-		if (m_config[param].value == replace.value && m_config[param].commented == replace.commented)
+		const auto found = m_config.find(param);
+		if (found == m_config.end())
+		{
+			get(param); // throws with alternatives, unless value is only given on command line
+			throw std::runtime_error{ QString{ "parameter %1 isnt set in configuration files" }.arg(param).toUtf8() };
+		}
+		const Parameter original = *found;
+		if (original.value == replace.value && original.commented == replace.commented)
 			return;
+		if (original.file != m_filename)
+			throw std::runtime_error{ QString{ "parameter %1 is set in %2" }.arg(param).arg(original.file).toUtf8() };
 
-		file.seek(original.position.seek);
-		QString line = file.readLine(), repl, replValue{ original.value };
-
-		for (const auto& p : re_screener)
-			replValue = replValue.replace(p.first, p.second);
+		// position keeps offsets of value in file as it was loaded, file is read on commit
+		const auto staged = m_edits.find(original.position.seek);
+		stage(param, staged != m_edits.end() ? staged->second.original : original, replace);
+		Parameter changed{ original.position, replace.value, replace.commented };
+		changed.file = m_filename;
+		m_config[param] = changed;
+	}
 
-		const QRegularExpression lineExpr{
-			QString{ "^\\s*(#?)\\s*(%1).*"
-					 "(?:(?:\\s*(=)\\s*)|(?:\\s+))"
-					 "\\s*(%2)([^\n]*)$" }
-				.arg(param)
-				.arg(replValue)
-		};
-		auto m = lineExpr.match(line);
-		if (!m.hasMatch())
-			throw std::runtime_error{ "cannot change value" };
-		QTextStream stream{ &repl };
-		QStringRef
-			comment = m.capturedRef(1),
-			value = m.capturedRef(4),
-			rest = m.capturedRef(5);
-		stream
-			<< line.mid(0, comment.position())
-			<< (replace.commented ? "#" : "")
-			<< line.mid(comment.position() + comment.size(), value.position() - comment.position() - comment.size())
-			<< replace.value
-			<< m.capturedRef(5) << endl;
+	void Configuration::commit(QTextStream& stream, const QString& label, bool write)
+	{
+		Patch::commit(stream, label, write);
+		if (write)
+			reload();
+	}
 
-		file.close();
-		m_config[param] = replace;
-		m_changes[original.position.line] = { line, repl };
+	bool Configuration::reload()
+	{
+		const bool changed = std::any_of(m_stamps.begin(), m_stamps.end(), [](const auto& s) { return tool::FileStamp{ s.first } != s.second; })
+			|| std::any_of(m_directories.begin(), m_directories.end(), [](const auto& d) {
+				   const QFileInfo info{ d.first };
+				   return (info.isDir() ? info.lastModified().toMSecsSinceEpoch() : -1) != d.second;
+			   });
+		if (changed)
+			load();
+		return changed;
 	}
 
 	void Configuration::load()
 	{
-		QFile file{ m_filename };
-		if (!file.open(QIODevice::ReadOnly | QIODevice::Text))
-			throw std::runtime_error{ "cannot open file" };
-		static const QRegularExpression lineExpr{
-			"^\\s{0,2}(#?)\\s*([\\w\\d_]+)" // line begin. capture comment, if exists
-			"(?:(?:\\s*(=)\\s*)|(?:\\s+))"  // no capture. Conf's separator can be '=' or space character
-			"("                             // begin values matching
-			"(?:[+-]?[\\d\\.]+[\\w]*)"      // integers and units
-			"|(?:'(?:[^']*'))"              // string
-			"|(?:on|off|true|false|yes|no)" // boolean
-			"|(?:[\\w_]+)"                  // enums
-			")"                             // end values matching
-			"(.*)$"                         // rest of line
-		},
-			restExpr{ "^((?:\\s+$)|(?:\\s*#.+$)|(?:$))" };
-
-		// QTextStream in(&file);
-		unsigned lineNo = 0;
-		while (!file.atEnd())
+		m_config.clear();
+		m_stamps.clear();
+		m_directories.clear();
+		m_files.clear();
+		m_index.reset();
+		apply(m_filename, 0);
+		// ALTER SYSTEM settings are read after everything else, from data directory
+		apply(QFileInfo{ m_filename }.absoluteDir().absoluteFilePath("postgresql.auto.conf"), 0);
+
+		// fragments of files which arent included anymore are dropped
+		for (auto it = m_fragments.begin(); it != m_fragments.end();)
+			it = m_stamps.count(it->first) != 0 ? std::next(it) : m_fragments.erase(it);
+	}
+
+	void Configuration::apply(const QString& path, int depth)
+	{
+		// CONF_FILE_MAX_DEPTH of guc-file.l
+		if (depth > 10)
 		{
-			++lineNo;
-			auto pos = file.pos();
-			auto line = file.readLine();
-			if (line.isEmpty())
+			qDebug() << "configuration files nested too deeply" << path;
+			return;
+		}
+		const tool::FileStamp stamp{ path };
+		m_stamps[path] = stamp;
+		if (!stamp.exists())
+			return;
+		m_files.push_back(path);
+
+		auto fragment = m_fragments.find(path);
+		if (fragment == m_fragments.end() || fragment->second.stamp != stamp)
+			fragment = m_fragments.insert_or_assign(path, parse(path, stamp)).first;
+
+		const QDir directory = QFileInfo{ path }.absoluteDir();
+		for (const auto& [key, parameter] : fragment->second.entries)
+		{
+			if (parameter.commented || (key != "include" && key != "include_if_exists" && key != "include_dir"))
+			{
+				assign(key, parameter);
 				continue;
-			auto match = lineExpr.match(line);
-			if (match.hasMatch())
+			}
+			const QString target = QDir::cleanPath(directory.absoluteFilePath(parameter.dequoteValue()));
+			if (key != "include_dir")
 			{
-				bool comment = (match.captured(1) == "#");
-				if (comment)
-				{
-					if (match.captured(3) != "=")
-						continue;
-					if (!restExpr.match(match.captured(5)).hasMatch())
-						continue;
-				}
-				m_config[match.captured(2)] = Parameter{ { lineNo, pos }, match.captured(4), comment };
+				if (key == "include" && !QFileInfo::exists(target))
+					qDebug() << "included configuration file not found" << target << "in" << path << parameter.position.line;
+				apply(target, depth + 1);
+				continue;
 			}
+			// files ending with .conf in name order, hidden ones skipped
+			const QFileInfo info{ target };
+			m_directories[target] = info.isDir() ? info.lastModified().toMSecsSinceEpoch() : -1;
+			QStringList names = QDir{ target }.entryList(QStringList{ "*.conf" }, QDir::Files | QDir::Readable);
+			names.sort(Qt::CaseSensitive);
+			for (const auto& name : names)
+				if (!name.startsWith('.'))
+					apply(QDir{ target }.absoluteFilePath(name), depth + 1);
 		}
+	}
+
+	void Configuration::assign(const QString& key, const Parameter& parameter)
+	{
+		auto it = m_config.find(key);
+		if (it == m_config.end())
+			m_config.insert(key, parameter);
+		// last active assignment wins, commented one only shows default of absent parameter
+		else if (!parameter.commented || it->commented)
+			*it = parameter;
+	}
+
+	Configuration::Fragment Configuration::parse(const QString& path, const tool::FileStamp& stamp)
+	{
+		Fragment result;
+		result.stamp = stamp;
+		QFile file{ path };
+		if (!file.open(QIODevice::ReadOnly))
+			return result;
+		const QByteArray data = file.readAll();
 		file.close();
-		// dirty hack. some values from standart header gets through re
-		m_config.remove("d");
-		m_config.remove("value");
+
+		ConfLexer lexer{ data.constData(), static_cast<size_t>(data.size()) };
+		ConfLexer::Entry entry;
+		while (lexer.next(entry))
+		{
+			const Parameter::Position position{
+				entry.line,
+				static_cast<long long>(entry.lineOffset),
+				static_cast<int>(entry.key.offset - entry.lineOffset),
+				static_cast<int>(entry.value.offset - entry.lineOffset),
+				static_cast<int>(entry.value.size),
+			};
+			Parameter parameter{ position, QString::fromUtf8(data.constData() + entry.value.offset, static_cast<int>(entry.value.size)), entry.commented };
+			parameter.file = path;
+			result.entries.emplace_back(QString::fromUtf8(data.constData() + entry.key.offset, static_cast<int>(entry.key.size)), std::move(parameter));
+		}
+		return result;
+	}
+
+	////////////////////////////////////////////////////////////////////////////////
+
+	Configuration::Transaction::Transaction(Configuration& conf)
+		: m_conf(conf)
+	{}
+
+	Configuration::Transaction& Configuration::Transaction::set(const QString& param, const QString& value, bool commented)
+	{
+		const auto found = m_conf.m_config.find(param);
+		if (found == m_conf.m_config.end() || found->file.isEmpty())
+		{
+			m_errors.push_back(QString{ "parameter %1 isnt set in configuration files" }.arg(param));
+			return *this;
+		}
+		// value must stay single token of line, as lexer reads it
+		const QByteArray probe = "x = " + value.toUtf8();
+		ConfLexer lexer{ probe.constData(), static_cast<size_t>(probe.size()) };
+		ConfLexer::Entry entry;
+		if (value.isEmpty() || !lexer.next(entry) || entry.value.offset + entry.value.size != static_cast<size_t>(probe.size()))
+		{
+			m_errors.push_back(QString{ "invalid value of %1: %2" }.arg(param).arg(value));
+			return *this;
+		}
+		const Parameter& original = *found;
+		auto patch = m_patches.find(original.file);
+		if (patch == m_patches.end())
+			patch = m_patches.emplace(original.file, Patch{ original.file }).first;
+		patch->second.stage(param, original, Parameter{ value, commented });
+		return *this;
+	}
+
+	QStringList Configuration::Transaction::validate() const
+	{
+		return m_errors;
+	}
+
+	QString Configuration::Transaction::commit(bool write)
+	{
+		QStringList errors = validate();
+		std::vector<QByteArray> contents;
+		for (auto& [filename, patch] : m_patches)
+		{
+			QFile file{ filename };
+			if (!file.open(QIODevice::ReadOnly))
+			{
+				errors.push_back(QString{ "cannot open %1" }.arg(filename));
+				contents.emplace_back();
+				continue;
+			}
+			contents.push_back(patch.apply(file.readAll(), errors));
+		}
+		if (!errors.isEmpty())
+			throw std::runtime_error{ errors.join('\n').toUtf8() };
+
+		QString result;
+		QTextStream stream{ &result };
+		for (auto& [filename, patch] : m_patches)
+			patch.diff(stream, QString{});
+		stream.flush();
+		if (!write)
+			return result;
+		size_t i = 0;
+		for (auto& [filename, patch] : m_patches)
+			patch.save(contents[i++]);
+		m_patches.clear();
+		m_conf.reload();
+		return result;
 	}
 
 	////////////////////////////////////////////////////////////////////////////////
@@ -1,10 +1,20 @@
 #pragma once
+#include "file_stamp.h"
+
+#include <map>
+#include <memory>
 #include <set>
+#include <vector>
 #include <QString>
 #include <QFile>
 #include <QVariant>
 #include <QTextStream>
 
+namespace tool
+{
+	class SuggestionIndex;
+}
+
 namespace pg
 {
 	////////////////////////////////////////////////////////////////////////////////
@@ -14,10 +24,14 @@ namespace pg
 		struct Position
 		{
 			unsigned line;
-			long long seek;
+			long long seek; // of line start
+			int key = 0;    // byte offsets within line
+			int value = 0;
+			int length = 0; // of value, bytes
 		} position;
 		QString value;
 		bool commented;
+		QString file; // where value comes from, empty if it isnt from configuration files
 		Parameter(const QString& = QString{}, bool = false);
 		Parameter(const Position&, const QString&, bool = false);
 		bool operator<(const Parameter&) const;
@@ -26,6 +40,8 @@ namespace pg
 
 	////////////////////////////////////////////////////////////////////////////////
 
+	/** staged edits of values in one configuration file. commit reads file once, checks every
+		edit against it, writes diff and replaces file in one pass (temporary file, fsync, rename) */
 	class Patch
 	{
 	public:
@@ -33,33 +49,112 @@ namespace pg
 		using Line = std::pair<QString, QString>;
 		using Data = std::map<unsigned, Line>;
 
+		/** edit of value found at position, nothing is read */
+		void stage(const QString& key, const Parameter& original, const Parameter& replace);
+		bool empty() const;
+		QString filename() const;
+
 		void commit(QTextStream& stream, const QString& label, bool write = true);
+		/** content with staged edits applied, problems of edits which dont fit it go to errors */
+		QByteArray apply(const QByteArray& content, QStringList& errors);
+		/** unified diff of last apply */
+		void diff(QTextStream& stream, const QString& label);
+		/** atomic replacement of file, throws on failure. staged edits are dropped */
+		void save(const QByteArray& content);
 
 	protected:
+		struct Edit
+		{
+			QByteArray key;
+			Parameter original;
+			QByteArray value;
+			bool commented;
+		};
+
 		QString timestamp() const;
 		QString chunk(Data::iterator&);
 
 	protected:
 		QString m_filename;
-		Patch::Data m_changes;
+		std::map<long long, Edit> m_edits; // by line offset, one per line
+		Patch::Data m_changes;              // lines changed by last apply
 	};
 
 	////////////////////////////////////////////////////////////////////////////////
 
+	/** effective configuration of cluster: postgresql.conf with include, include_if_exists and
+		include_dir followed in place, then postgresql.auto.conf, then overrides of postmaster
+		command line; last assignment wins as in server. files are parsed once and again only
+		when their stamps change */
 	class Configuration : public Patch
 	{
 	public:
 		Configuration(const QString&);
 
+		/** effective value with file and line it comes from */
 		Parameter get(const QString&) const;
+		bool contains(const QString&) const;
+		/** patches line of parameter, only when it comes from postgresql.conf itself */
 		void set(const QString&, const Parameter&);
+		/** value given to server on command line, isnt written anywhere */
+		void override(const QString&, const QString& value, const QString& source);
+		/** drops command line values, before those of new command line are given */
+		void clearOverrides();
 		QStringList parameters() const;
+		/** parameters of files and known to server which look like misspelled name, closest first */
+		QStringList suggest(const QString&, int count) const;
+		/** parameters holding text, then ones looking like it, for search box */
+		QStringList search(const QString& text, int count) const;
+		/** configuration files in order they were read */
+		QStringList files() const;
+		/** re-reads configuration if any file or included directory has changed, true if it has */
+		bool reload();
+		/** writes changes staged by set() to postgresql.conf and reloads */
+		void commit(QTextStream& stream, const QString& label, bool write = true);
+
+		/** edits of any number of parameters, in whatever files they are set, applied at once */
+		class Transaction
+		{
+		public:
+			explicit Transaction(Configuration&);
+
+			/** stages new value, nothing is read or written */
+			Transaction& set(const QString& param, const QString& value, bool commented = false);
+			/** problems of staged edits found without reading files, empty if there are none */
+			QStringList validate() const;
+			/** validates, reads every file once and checks edits against it; only if all fit files
+				are replaced atomically and configuration is reloaded. returns unified diff */
+			QString commit(bool write = true);
+
+		protected:
+			Configuration& m_conf;
+			std::map<QString, Patch> m_patches;
+			QStringList m_errors;
+		};
 
 	protected:
+		/** parsed file, assignments and include directives in order */
+		struct Fragment
+		{
+			tool::FileStamp stamp;
+			std::vector<std::pair<QString, Parameter>> entries;
+		};
+
 		void load();
+		/** assignments of file in order, includes followed */
+		void apply(const QString& path, int depth);
+		void assign(const QString&, const Parameter&);
+		static Fragment parse(const QString& path, const tool::FileStamp&);
+		const tool::SuggestionIndex& index() const;
 
 	protected:
 		QHash<QString, Parameter> m_config;
+		QHash<QString, Parameter> m_overrides;
+		std::map<QString, Fragment> m_fragments; // by absolute path, kept between loads
+		std::map<QString, tool::FileStamp> m_stamps; // all files looked at, missing ones too
+		std::map<QString, qint64> m_directories;    // include_dir, mtime
+		QStringList m_files;
+		mutable std::shared_ptr<tool::SuggestionIndex> m_index; // dropped on load
 	};
 
 	////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,131 @@
+#include "pg_conf_lexer.h"
+
+#include <cstring>
+
+namespace pg
+{
+	////////////////////////////////////////////////////////////////////////////////
+
+	namespace
+	{
+		// guc-file.l: LETTER [A-Za-z_\200-\377], LETTER_OR_DIGIT adds [0-9$], qualified names have dots
+		bool letter(unsigned char c)
+		{
+			return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_' || c >= 0x80;
+		}
+
+		bool nameChar(unsigned char c)
+		{
+			return letter(c) || (c >= '0' && c <= '9') || c == '$' || c == '.';
+		}
+
+		bool blank(char c)
+		{
+			return c == ' ' || c == '\t' || c == '\r' || c == '\f' || c == '\v';
+		}
+	} // namespace
+
+	////////////////////////////////////////////////////////////////////////////////
+
+	ConfLexer::ConfLexer(const char* data, size_t size)
+		: m_data{ data }
+		, m_size{ size }
+	{}
+
+	bool ConfLexer::next(Entry& entry)
+	{
+		while (m_at < m_size)
+		{
+			if (line(entry))
+				return true;
+		}
+		return false;
+	}
+
+	void ConfLexer::skipLine()
+	{
+		const void* eol = std::memchr(m_data + m_at, '\n', m_size - m_at);
+		m_at = eol != nullptr ? static_cast<size_t>(static_cast<const char*>(eol) - m_data) + 1 : m_size;
+	}
+
+	void ConfLexer::skipBlanks()
+	{
+		while (m_at < m_size && blank(m_data[m_at]))
+			++m_at;
+	}
+
+	bool ConfLexer::line(Entry& entry)
+	{
+		entry = Entry{};
+		entry.line = ++m_line;
+		entry.lineOffset = m_at;
+		skipBlanks();
+		if (m_at < m_size && m_data[m_at] == '#')
+		{
+			if (m_at + 1 >= m_size || !letter(static_cast<unsigned char>(m_data[m_at + 1])))
+				return skipLine(), false;
+			entry.commented = true;
+			++m_at;
+		}
+		if (m_at >= m_size || !letter(static_cast<unsigned char>(m_data[m_at])))
+			return skipLine(), false;
+
+		entry.key.offset = m_at;
+		while (m_at < m_size && nameChar(static_cast<unsigned char>(m_data[m_at])))
+			++m_at;
+		entry.key.size = m_at - entry.key.offset;
+
+		const size_t separator = m_at;
+		skipBlanks();
+		const bool assigned = m_at < m_size && m_data[m_at] == '=';
+		if (assigned)
+		{
+			++m_at;
+			skipBlanks();
+		}
+		if (m_at == separator || (entry.commented && !assigned) || m_at >= m_size)
+			return skipLine(), false;
+
+		entry.value.offset = m_at;
+		if (m_data[m_at] == '\'')
+		{
+			bool closed = false;
+			for (++m_at; m_at < m_size && m_data[m_at] != '\n'; ++m_at)
+			{
+				if (m_data[m_at] == '\\' && m_at + 1 < m_size && m_data[m_at + 1] != '\n')
+					++m_at;
+				else if (m_data[m_at] == '\'')
+				{
+					if (m_at + 1 < m_size && m_data[m_at + 1] == '\'')
+						++m_at; // '' is escaped quote
+					else
+					{
+						closed = true;
+						++m_at;
+						break;
+					}
+				}
+			}
+			if (!closed)
+				return skipLine(), false;
+		}
+		else
+		{ // numbers with units and unquoted words alike
+			while (m_at < m_size && !blank(m_data[m_at]) && m_data[m_at] != '\n' && m_data[m_at] != '#'
+				&& m_data[m_at] != '\'' && m_data[m_at] != '"')
+				++m_at;
+		}
+		entry.value.size = m_at - entry.value.offset;
+		if (entry.value.size == 0)
+			return skipLine(), false;
+
+		// nothing but comment may follow value
+		skipBlanks();
+		const bool valid = m_at >= m_size || m_data[m_at] == '\n' || m_data[m_at] == '#';
+		skipLine();
+		return valid;
+	}
+
+	////////////////////////////////////////////////////////////////////////////////
+
+} /* namespace pg */
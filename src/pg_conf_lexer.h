@@ -0,0 +1,50 @@
+#pragma once
+#include <cstddef>
+
+namespace pg
+{
+	////////////////////////////////////////////////////////////////////////////////
+
+	/** single pass tokenizer of postgresql.conf grammar over raw bytes, nothing is copied.
+		line is [#]name [=] value [# comment]; value is number with unit, unquoted word or
+		'quoted string' with '' and backslash escapes. commented out line is taken only if '#'
+		is followed by name right away and separated by '=', so prose of comments isnt */
+	class ConfLexer
+	{
+	public:
+		/** [offset, offset + size) of buffer */
+		struct View
+		{
+			size_t offset = 0;
+			size_t size = 0;
+		};
+		struct Entry
+		{
+			unsigned line = 0;     // 1 based
+			size_t lineOffset = 0; // of line start
+			View key;
+			View value;            // quotes included
+			bool commented = false;
+		};
+
+		ConfLexer(const char* data, size_t size);
+
+		/** next assignment, false at end of buffer. malformed lines are skipped */
+		bool next(Entry&);
+
+	protected:
+		/** parses line starting at m_at, leaves m_at at next line */
+		bool line(Entry&);
+		void skipLine();
+		void skipBlanks();
+
+	protected:
+		const char* const m_data;
+		const size_t m_size;
+		size_t m_at = 0;
+		unsigned m_line = 0;
+	};
+
+	////////////////////////////////////////////////////////////////////////////////
+
+} /* namespace pg */
@@ -0,0 +1,179 @@
+#include "pg_control.h"
+#include "crc32c.h"
+
+#include <QDateTime>
+#include <QFile>
+
+#include <algorithm>
+#include <cstring>
+
+namespace pg
+{
+	////////////////////////////////////////////////////////////////////////////////
+
+	namespace
+	{
+		const qint64 fileSize = 8192; // PG_CONTROL_FILE_SIZE
+		const size_t crcSearch = 512; // ControlFileData ends well before, crc is its last field
+
+		template <typename T>
+		T read(const char* data, size_t offset)
+		{ // host byte order, pg_control is written by server of same platform
+			T value;
+			std::memcpy(&value, data + offset, sizeof(T));
+			return value;
+		}
+
+		/** offset of checkPointCopy.time by pg_control_version, -1 if layout isnt known */
+		int checkpointTimeOffset(quint32 version)
+		{
+			switch (version)
+			{
+			case 942: // 9.5
+			case 960: // 9.6
+			case 1002: // 10, prevCheckPoint precedes checkPointCopy
+				return 104;
+			case 1100: // 11
+				return 96;
+			case 1201: // 12, nextXid became 64 bit
+			case 1300: // 13 - 16
+			case 1700: // 17
+				return 104;
+			default:
+				return -1;
+			}
+		}
+	} // namespace
+
+	////////////////////////////////////////////////////////////////////////////////
+
+	ControlFile::ControlFile(const QString& dataDirectory)
+	{
+		QFile file{ QString{ "%1/global/pg_control" }.arg(dataDirectory) };
+		if (!file.open(QIODevice::ReadOnly))
+			return;
+		char data[fileSize];
+		const qint64 size = file.read(data, fileSize);
+		if (size < 48)
+			return;
+
+		m_systemIdentifier = read<quint64>(data, 0);
+		m_controlVersion = read<quint32>(data, 8);
+		m_catalogVersion = read<quint32>(data, 12);
+		const auto state = read<qint32>(data, 16);
+		m_time = read<qint64>(data, 24);
+		m_checkpoint = read<quint64>(data, 32);
+		if (state < Startup || state > InProduction || m_controlVersion < 800 || m_controlVersion > 9999)
+			return;
+		m_state = static_cast<State>(state);
+		m_valid = true;
+
+		// crc covers everything before it, so it is where crc of the preceding bytes is stored.
+		// one incremental pass finds it regardless of version specific layout
+		quint32 crc = tool::Crc32c::initial;
+		const size_t limit = std::min(static_cast<size_t>(size), crcSearch);
+		for (size_t offset = 0; offset + sizeof(quint32) <= limit; offset += sizeof(quint32))
+		{
+			if (offset >= 48 && tool::Crc32c::finish(crc) == read<quint32>(data, offset))
+			{
+				m_verified = true;
+				break;
+			}
+			crc = tool::Crc32c::update(crc, data + offset, sizeof(quint32));
+		}
+
+		const int at = checkpointTimeOffset(m_controlVersion);
+		if (at >= 0 && at + static_cast<qint64>(sizeof(qint64)) <= size)
+			m_checkpointTime = read<qint64>(data, static_cast<size_t>(at));
+	}
+
+	bool ControlFile::valid() const
+	{
+		return m_valid;
+	}
+
+	bool ControlFile::verified() const
+	{
+		return m_verified;
+	}
+
+	bool ControlFile::crashed() const
+	{
+		return m_valid && m_verified && m_state != Shutdowned && m_state != ShutdownedInRecovery;
+	}
+
+	ControlFile::State ControlFile::state() const
+	{
+		return m_state;
+	}
+
+	QString ControlFile::stateName() const
+	{
+		switch (m_state)
+		{
+		case Startup:
+			return "starting up";
+		case Shutdowned:
+			return "shut down";
+		case ShutdownedInRecovery:
+			return "shut down in recovery";
+		case Shutdowning:
+			return "shutting down";
+		case InCrashRecovery:
+			return "in crash recovery";
+		case InArchiveRecovery:
+			return "in archive recovery";
+		case InProduction:
+			return "in production";
+		}
+		return "unrecognized status code";
+	}
+
+	quint64 ControlFile::systemIdentifier() const
+	{
+		return m_systemIdentifier;
+	}
+
+	quint32 ControlFile::controlVersion() const
+	{
+		return m_controlVersion;
+	}
+
+	quint32 ControlFile::catalogVersion() const
+	{
+		return m_catalogVersion;
+	}
+
+	quint64 ControlFile::checkpoint() const
+	{
+		return m_checkpoint;
+	}
+
+	QString ControlFile::checkpointText() const
+	{
+		return QString{ "%1/%2" }
+			.arg(static_cast<quint32>(m_checkpoint >> 32), 0, 16)
+			.arg(static_cast<quint32>(m_checkpoint), 0, 16)
+			.toUpper();
+	}
+
+	qint64 ControlFile::checkpointTime() const
+	{
+		return m_checkpointTime >= 0 ? m_checkpointTime : m_time;
+	}
+
+	QString ControlFile::describe() const
+	{
+		if (!m_valid)
+			return QString{};
+		return QString{ "%1, checkpoint %2 at %3, catalog %4%5" }
+			.arg(stateName())
+			.arg(checkpointText())
+			.arg(QDateTime::fromSecsSinceEpoch(checkpointTime()).toString("yyyy-MM-dd hh:mm:ss"))
+			.arg(m_catalogVersion)
+			.arg(m_verified ? QString{} : QString{ ", checksum not verified" });
+	}
+
+	////////////////////////////////////////////////////////////////////////////////
+
+} /* namespace pg */
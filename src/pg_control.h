@@ -0,0 +1,65 @@
+#pragma once
+#include <QString>
+
+namespace pg
+{
+	////////////////////////////////////////////////////////////////////////////////
+
+	/** global/pg_control of cluster, decoded without server or pg_controldata. fields read
+		are those with fixed offsets since 9.x, checksum (crc32c) is verified for 9.5+ */
+	class ControlFile
+	{
+	public:
+		/** DBState of pg_control.h */
+		enum State
+		{
+			Startup = 0,
+			Shutdowned,
+			ShutdownedInRecovery,
+			Shutdowning,
+			InCrashRecovery,
+			InArchiveRecovery,
+			InProduction,
+		};
+
+		ControlFile() {}
+		/** reads <data directory>/global/pg_control, valid() is false if it cant be read */
+		explicit ControlFile(const QString& dataDirectory);
+
+		/** file was read and its fixed header is sane */
+		bool valid() const;
+		/** crc was found and matched, layouts older than 9.5 arent verified */
+		bool verified() const;
+		/** last shutdown wasnt clean, server was killed or is still running */
+		bool crashed() const;
+
+		State state() const;
+		/** "in production", as pg_controldata prints it */
+		QString stateName() const;
+		quint64 systemIdentifier() const;
+		quint32 controlVersion() const;
+		quint32 catalogVersion() const;
+		/** latest checkpoint location, 0 if unknown */
+		quint64 checkpoint() const;
+		/** "0/16B3F28" */
+		QString checkpointText() const;
+		/** seconds since epoch of latest checkpoint, of last pg_control update if layout is unknown */
+		qint64 checkpointTime() const;
+		/** one line summary for tooltips */
+		QString describe() const;
+
+	protected:
+		bool m_valid = false;
+		bool m_verified = false;
+		quint64 m_systemIdentifier = 0;
+		quint32 m_controlVersion = 0;
+		quint32 m_catalogVersion = 0;
+		State m_state = Startup;
+		qint64 m_time = 0;
+		quint64 m_checkpoint = 0;
+		qint64 m_checkpointTime = -1;
+	};
+
+	////////////////////////////////////////////////////////////////////////////////
+
+} /* namespace pg */
@@ -0,0 +1,156 @@
+#include "pg_ctl.h"
+#include "pg_pid_file.h"
+#include "service_stats.h"
+#include "settings.h"
+
+#include <QDir>
+#include <QTimer>
+
+namespace pg
+{
+	////////////////////////////////////////////////////////////////////////////////
+
+	ClusterControl::ClusterControl(const PGVersion& version, const QString& cluster, QObject* parent)
+		: QObject{ parent }
+		, m_cluster{ cluster }
+		, m_program{ QString{ "%1%2" }.arg(version.binaryPath()).arg(PGVersion::executable("pg_ctl")) }
+		, m_process{ new QProcess{ this } }
+		, m_poll{ new QTimer{ this } }
+		, m_timeout{ Settings::setup()->get("pg_ctl_timeout", 60000).toLongLong() }
+	{
+		m_process->setProcessChannelMode(QProcess::MergedChannels);
+		m_process->setWorkingDirectory(m_cluster);
+		m_poll->setInterval(100);
+		QObject::connect(m_poll, &QTimer::timeout,
+			this, &ClusterControl::onPoll);
+		QObject::connect(m_process, QOverload<int, QProcess::ExitStatus>::of(&QProcess::finished),
+			this, &ClusterControl::onProcessFinished);
+		QObject::connect(m_process, &QProcess::errorOccurred,
+			this, &ClusterControl::onProcessError);
+		QObject::connect(m_process, &QProcess::readyReadStandardOutput, this, [this]() {
+			m_output += QString::fromLocal8Bit(m_process->readAllStandardOutput());
+		});
+	}
+
+	ClusterControl::~ClusterControl()
+	{
+		m_process->disconnect(this);
+	}
+
+	void ClusterControl::setProgram(const QString& program)
+	{
+		m_program = program;
+	}
+
+	QString ClusterControl::program() const
+	{
+		return m_program;
+	}
+
+	bool ClusterControl::busy() const
+	{
+		return m_busy;
+	}
+
+	void ClusterControl::start(int port)
+	{
+		QStringList arguments{ "start", "-W", "-D", m_cluster };
+		// server output goes to file, pipe of pg_ctl would be left without reader
+		const QString log = Settings::setup()->get("pg_ctl_log", "pg_ctl.log").toString();
+		if (!log.isEmpty())
+			arguments << "-l" << QDir{ m_cluster }.absoluteFilePath(log);
+#ifdef Q_OS_WIN
+		arguments << "-o" << QString{ "-p %1 --lc_messages=en_us.utf8" }.arg(port);
+#else
+		arguments << "-o" << QString{ "-p %1" }.arg(port);
+#endif
+		launch(Start, arguments);
+	}
+
+	void ClusterControl::stop()
+	{
+		launch(Stop, QStringList{ "stop", "-W", "-D", m_cluster, "-m", "fast" });
+	}
+
+	QString ClusterControl::statisticsKey(const QString& cluster)
+	{
+		return QString{ "postgres:%1" }.arg(cluster);
+	}
+
+	void ClusterControl::launch(Operation operation, const QStringList& arguments)
+	{
+		if (m_busy)
+			return;
+		m_operation = operation;
+		m_busy = true;
+		m_exited = m_pidSeen = false;
+		const QString path = QString{ "%1/postmaster.pid" }.arg(m_cluster);
+		m_stalePid = PidFile{ path }.pid;
+		m_staleStamp = tool::FileStamp{ path };
+		m_output.clear();
+		m_elapsed.start();
+		m_process->start(m_program, arguments);
+		m_poll->start();
+	}
+
+	void ClusterControl::onPoll()
+	{
+		if (!m_busy)
+			return;
+		// pg_ctl is run with -W, readiness is what postmaster writes to its pid file
+		const QString path = QString{ "%1/postmaster.pid" }.arg(m_cluster);
+		const PidFile pid{ path };
+		if (m_operation == Start)
+		{
+			// status of file found at launch is of previous server, not of this one
+			const bool fresh = pid.valid() && (pid.pid != m_stalePid || tool::FileStamp{ path } != m_staleStamp);
+			m_pidSeen |= fresh;
+			if (fresh && (pid.status == PidFile::Ready || pid.status == PidFile::Standby || (pid.status == PidFile::Unknown && m_exited)))
+				return complete(true);
+			if (m_exited && m_pidSeen && !pid.valid())
+				return complete(false, "server exited while starting");
+		}
+		else if (m_exited && !pid.valid())
+			return complete(true);
+		if (m_elapsed.elapsed() > m_timeout)
+			complete(false, QString{ "no result in %1 ms" }.arg(m_timeout));
+	}
+
+	void ClusterControl::onProcessFinished(int code, QProcess::ExitStatus status)
+	{
+		if (!m_busy)
+			return;
+		m_output += QString::fromLocal8Bit(m_process->readAllStandardOutput());
+		if (status != QProcess::NormalExit || code != 0)
+			return complete(false, QString{ "pg_ctl exited with code %1" }.arg(code));
+		m_exited = true;
+		onPoll();
+	}
+
+	void ClusterControl::onProcessError(QProcess::ProcessError error)
+	{
+		// other errors are followed by finished
+		if (m_busy && error == QProcess::FailedToStart)
+			complete(false, m_process->errorString());
+	}
+
+	void ClusterControl::complete(bool ok, const QString& reason)
+	{
+		m_poll->stop();
+		m_busy = false;
+		if (m_process->state() != QProcess::NotRunning)
+			m_process->kill();
+		const qint64 ms = m_elapsed.elapsed();
+		if (ok)
+			ServiceStatistics::instance()->service(statisticsKey(m_cluster))
+				->transitions[m_operation == Start ? ServiceStatistics::Start : ServiceStatistics::Stop]
+				.record(static_cast<quint64>(ms));
+		QString output = m_output.trimmed();
+		if (!reason.isEmpty())
+			output += QString{ output.isEmpty() ? "%1" : "\n%1" }.arg(reason);
+		emit finished(m_operation, ok, ms, output);
+	}
+
+	////////////////////////////////////////////////////////////////////////////////
+
+} /* namespace pg */
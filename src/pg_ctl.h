@@ -0,0 +1,75 @@
+#pragma once
+#include "file_stamp.h"
+#include "pg_version.h"
+
+#include <QElapsedTimer>
+#include <QObject>
+#include <QProcess>
+
+class QTimer;
+
+namespace pg
+{
+	////////////////////////////////////////////////////////////////////////////////
+
+	/** starts and stops cluster by pg_ctl run through QProcess (no console, no shell), follows
+		operation by postmaster.pid until server is ready or gone, pg_ctl fails, or
+		pg_ctl_timeout (ms) passes. latencies of completed operations go to ServiceStatistics */
+	class ClusterControl : public QObject
+	{
+		Q_OBJECT
+	public:
+		enum Operation
+		{
+			Start,
+			Stop,
+		};
+
+		ClusterControl(const PGVersion&, const QString& cluster, QObject* = nullptr);
+		~ClusterControl();
+
+		/** pg_ctl of version by default, stand-in script may be put instead */
+		void setProgram(const QString&);
+		QString program() const;
+		/** operation is in progress, new one isnt accepted */
+		bool busy() const;
+
+		void start(int port);
+		void stop();
+
+		/** ServiceStatistics entry of cluster */
+		static QString statisticsKey(const QString& cluster);
+
+	signals:
+		/** ms from launch to ready server (start) or removed pid file (stop). output of pg_ctl */
+		void finished(int operation, bool ok, qint64 ms, const QString& output);
+
+	protected slots:
+		void onPoll();
+		void onProcessFinished(int, QProcess::ExitStatus);
+		void onProcessError(QProcess::ProcessError);
+
+	protected:
+		void launch(Operation, const QStringList& arguments);
+		void complete(bool ok, const QString& reason = QString{});
+
+	protected:
+		const QString m_cluster;
+		QString m_program;
+		QProcess* m_process{ nullptr };
+		QTimer* m_poll{ nullptr };
+		QElapsedTimer m_elapsed;
+		qint64 m_timeout;
+		Operation m_operation = Start;
+		bool m_busy = false;
+		bool m_exited = false;  // pg_ctl has exited successfully
+		bool m_pidSeen = false; // start: postmaster.pid appeared
+		// postmaster.pid left at launch, crashed server leaves "ready" in it
+		qint64 m_stalePid = 0;
+		tool::FileStamp m_staleStamp;
+		QString m_output;
+	};
+
+	////////////////////////////////////////////////////////////////////////////////
+
+} /* namespace pg */
@@ -0,0 +1,13 @@
+#pragma once
+#include <QStringList>
+
+namespace pg
+{
+	////////////////////////////////////////////////////////////////////////////////
+
+	/** built-in catalog of server parameter names, for suggestions when file doesnt mention them */
+	const QStringList& knownParameters();
+
+	////////////////////////////////////////////////////////////////////////////////
+
+} /* namespace pg */
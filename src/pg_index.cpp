@@ -0,0 +1,175 @@
+#include "pg_index.h"
+#include "settings.h"
+
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QSaveFile>
+
+#include <algorithm>
+
+#include <QDebug>
+
+namespace pg
+{
+	////////////////////////////////////////////////////////////////////////////////
+
+	ClusterIndex::ClusterIndex()
+		: m_path{ QFileInfo{ Settings::setup()->configPath() }.absoluteDir().absoluteFilePath("pg_index.json") }
+	{
+		QFile file{ m_path };
+		if (!file.open(QIODevice::ReadOnly))
+			return;
+		const QJsonObject root = QJsonDocument::fromJson(file.readAll()).object();
+		const QJsonObject roots = root.value("roots").toObject();
+		for (auto it = roots.begin(); it != roots.end(); ++it)
+		{
+			const QJsonObject r = it.value().toObject();
+			Root& entry = m_roots[it.key()];
+			entry.mtime = static_cast<qint64>(r.value("mtime").toDouble(-1));
+			for (const auto& install : r.value("installs").toArray())
+				entry.installs.push_back(install.toString());
+		}
+		const QJsonObject installs = root.value("installs").toObject();
+		for (auto it = installs.begin(); it != installs.end(); ++it)
+		{
+			const QJsonObject i = it.value().toObject();
+			Install& entry = m_installs[it.key()];
+			for (const auto& cluster : i.value("clusters").toArray())
+				entry.clusters.push_back(cluster.toString());
+			const QJsonObject directories = i.value("directories").toObject();
+			for (auto d = directories.begin(); d != directories.end(); ++d)
+				entry.directories[d.key()] = static_cast<qint64>(d.value().toDouble(-1));
+		}
+	}
+
+	void ClusterIndex::save()
+	{
+		QJsonObject roots, installs;
+		{
+			auto lock = std::lock_guard{ m_lock };
+			for (const auto& [path, r] : m_roots)
+				roots.insert(path, QJsonObject{ { "mtime", static_cast<double>(r.mtime) }, { "installs", QJsonArray::fromStringList(r.installs) } });
+			for (const auto& [path, i] : m_installs)
+			{
+				QJsonObject directories;
+				for (const auto& [directory, time] : i.directories)
+					directories.insert(directory, static_cast<double>(time));
+				installs.insert(path, QJsonObject{ { "clusters", QJsonArray::fromStringList(i.clusters) }, { "directories", directories } });
+			}
+		}
+		QSaveFile file{ m_path };
+		if (!file.open(QIODevice::WriteOnly)
+			|| file.write(QJsonDocument{ QJsonObject{ { "roots", roots }, { "installs", installs } } }.toJson(QJsonDocument::Compact)) < 0
+			|| !file.commit())
+			qDebug() << "cant save" << m_path;
+	}
+
+	bool ClusterIndex::installsKnown(const QString& root) const
+	{
+		const QString key = QDir::cleanPath(root);
+		const qint64 current = mtime(key);
+		auto lock = std::lock_guard{ m_lock };
+		const auto it = m_roots.find(key);
+		return it != m_roots.end() && it->second.mtime == current;
+	}
+
+	QStringList ClusterIndex::installs(const QString& root) const
+	{
+		auto lock = std::lock_guard{ m_lock };
+		const auto it = m_roots.find(QDir::cleanPath(root));
+		return it != m_roots.end() ? it->second.installs : QStringList{};
+	}
+
+	void ClusterIndex::setInstalls(const QString& root, const QStringList& installs)
+	{
+		const QString key = QDir::cleanPath(root);
+		const qint64 current = mtime(key);
+		auto lock = std::lock_guard{ m_lock };
+		m_roots[key] = Root{ current, installs };
+	}
+
+	bool ClusterIndex::clustersKnown(const QString& install) const
+	{
+		auto lock = std::lock_guard{ m_lock };
+		return m_installs.count(QDir::cleanPath(install)) != 0;
+	}
+
+	QStringList ClusterIndex::clusters(const QString& install) const
+	{
+		auto lock = std::lock_guard{ m_lock };
+		const auto it = m_installs.find(QDir::cleanPath(install));
+		return it != m_installs.end() ? it->second.clusters : QStringList{};
+	}
+
+	QStringList ClusterIndex::stale(const QString& install) const
+	{
+		Directories recorded;
+		{
+			auto lock = std::lock_guard{ m_lock };
+			const auto it = m_installs.find(QDir::cleanPath(install));
+			if (it != m_installs.end())
+				recorded = it->second.directories;
+		}
+		// parents sort before their children, which are covered by parent's walk
+		QStringList result;
+		for (const auto& [directory, time] : recorded)
+			if (std::none_of(result.begin(), result.end(), [&directory](const QString& s) { return below(directory, s); })
+				&& mtime(directory) != time)
+				result.push_back(directory);
+		return result;
+	}
+
+	void ClusterIndex::update(const QString& install, const QString& directory, const Directories& walked, const QStringList& clusters)
+	{
+		const QString top = QDir::cleanPath(directory);
+		auto lock = std::lock_guard{ m_lock };
+		Install& entry = m_installs[QDir::cleanPath(install)];
+		for (auto it = entry.directories.begin(); it != entry.directories.end();)
+			it = below(it->first, top) ? entry.directories.erase(it) : std::next(it);
+		entry.directories.insert(walked.begin(), walked.end());
+		entry.clusters.erase(std::remove_if(entry.clusters.begin(), entry.clusters.end(), [&top](const QString& c) { return below(c, top); }),
+			entry.clusters.end());
+		entry.clusters.append(clusters);
+		entry.clusters.sort();
+	}
+
+	QStringList ClusterIndex::watched(int limit) const
+	{
+		QStringList result, directories;
+		{
+			auto lock = std::lock_guard{ m_lock };
+			for (const auto& [path, r] : m_roots)
+			{
+				result.push_back(path);
+				result.append(r.installs);
+			}
+			for (const auto& [path, i] : m_installs)
+				for (const auto& d : i.directories)
+					directories.push_back(d.first);
+		}
+		std::stable_sort(directories.begin(), directories.end(), [](const QString& a, const QString& b) { return a.count('/') < b.count('/'); });
+		result.append(directories);
+		result.removeDuplicates();
+		return limit >= 0 ? result.mid(0, limit) : result;
+	}
+
+	bool ClusterIndex::below(const QString& path, const QString& directory)
+	{
+		return path.startsWith(directory)
+			&& (path.size() == directory.size() || path[directory.size()] == '/' || directory.endsWith('/'));
+	}
+
+	qint64 ClusterIndex::mtime(const QString& path)
+	{
+		const QFileInfo info{ path };
+		return info.exists() ? info.lastModified().toMSecsSinceEpoch() : -1;
+	}
+
+	////////////////////////////////////////////////////////////////////////////////
+
+} /* namespace pg */
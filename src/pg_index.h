@@ -0,0 +1,63 @@
+#pragma once
+#include <QStringList>
+
+#include <map>
+#include <mutex>
+
+namespace pg
+{
+	////////////////////////////////////////////////////////////////////////////////
+
+	/** installs and clusters found on previous runs, kept in pg_index.json together with
+		mtimes of directories walked through, so only changed directories are walked again */
+	class ClusterIndex
+	{
+	public:
+		using Directories = std::map<QString, qint64>; // path -> mtime, ms
+
+		ClusterIndex();
+		void save();
+
+		/** false if root was never enumerated or its mtime has changed */
+		bool installsKnown(const QString& root) const;
+		QStringList installs(const QString& root) const;
+		void setInstalls(const QString& root, const QStringList&);
+
+		/** install was walked at least once */
+		bool clustersKnown(const QString& install) const;
+		QStringList clusters(const QString& install) const;
+		/** topmost walked directories of install which were changed or removed since */
+		QStringList stale(const QString& install) const;
+		/** result of walk from directory (install itself on full walk) replaces what was recorded below it */
+		void update(const QString& install, const QString& directory, const Directories&, const QStringList& clusters);
+
+		/** roots, installs and walked directories, shallow ones first */
+		QStringList watched(int limit) const;
+
+		/** path is directory itself or lies below it */
+		static bool below(const QString& path, const QString& directory);
+		/** -1 if path doesnt exist */
+		static qint64 mtime(const QString&);
+
+	protected:
+		struct Root
+		{
+			qint64 mtime = -1;
+			QStringList installs;
+		};
+		struct Install
+		{
+			Directories directories;
+			QStringList clusters;
+		};
+
+	protected:
+		const QString m_path;
+		mutable std::mutex m_lock;
+		std::map<QString, Root> m_roots;
+		std::map<QString, Install> m_installs;
+	};
+
+	////////////////////////////////////////////////////////////////////////////////
+
+} /* namespace pg */
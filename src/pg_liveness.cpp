@@ -0,0 +1,237 @@
+#include "pg_liveness.h"
+#include "settings.h"
+
+#include <QDateTime>
+#include <QFile>
+
+#ifdef Q_OS_WIN
+#	define VC_EXTRALEAN
+#	define WIN32_LEAN_AND_MEAN
+#	include <windows.h>
+#	include <tlhelp32.h>
+#else
+#	include <cerrno>
+#	include <signal.h>
+#	include <unistd.h>
+#endif
+#ifdef Q_OS_LINUX
+#	include <poll.h>
+#	include <sys/syscall.h>
+#endif
+
+namespace pg
+{
+	////////////////////////////////////////////////////////////////////////////////
+
+	namespace
+	{
+		/** pid file is written by postmaster after it has started, mtime granularity aside */
+		const qint64 slack = 2000;
+
+#ifndef Q_OS_WIN
+		bool exists(qint64 pid)
+		{
+			return ::kill(static_cast<pid_t>(pid), 0) == 0 || errno == EPERM;
+		}
+#endif
+#ifdef Q_OS_LINUX
+		int pidfdOpen(qint64 pid)
+		{
+#	ifdef SYS_pidfd_open
+			return static_cast<int>(::syscall(SYS_pidfd_open, static_cast<pid_t>(pid), 0));
+#	else
+			Q_UNUSED(pid);
+			return -1;
+#	endif
+		}
+
+		/** pidfd becomes readable when its process exits */
+		bool exited(int pidfd)
+		{
+			pollfd p{ pidfd, POLLIN, 0 };
+			return ::poll(&p, 1, 0) > 0;
+		}
+#endif
+	} // namespace
+
+	////////////////////////////////////////////////////////////////////////////////
+
+	Liveness* Liveness::instance(SingletonPolicy policy)
+	{
+		static Liveness* instance{ nullptr };
+		if (policy == Get && instance == nullptr)
+			instance = new Liveness;
+		if (policy == Release && instance != nullptr)
+			delete instance, instance = nullptr;
+		return instance;
+	}
+
+	Liveness::Liveness()
+		: m_ttl{ Settings::setup()->get("pg_liveness_ttl", 500).toLongLong() }
+	{
+#ifdef Q_OS_LINUX
+		m_ticks = ::sysconf(_SC_CLK_TCK);
+		QFile stat{ "/proc/stat" };
+		if (stat.open(QIODevice::ReadOnly))
+		{
+			for (QByteArray line = stat.readLine(); !line.isEmpty(); line = stat.readLine())
+				if (line.startsWith("btime "))
+				{
+					m_boot = line.mid(6).trimmed().toLongLong() * 1000;
+					break;
+				}
+		}
+#endif
+	}
+
+	Liveness::~Liveness()
+	{
+#ifdef Q_OS_LINUX
+		for (const auto& [pid, process] : m_processes)
+			if (process.pidfd >= 0)
+				::close(process.pidfd);
+#endif
+	}
+
+	bool Liveness::alive(qint64 pid, qint64 written)
+	{
+		if (pid <= 0)
+			return false;
+		auto lock = std::lock_guard{ m_lock };
+		Process process;
+		if (!lookup(pid, process))
+			return false;
+		return process.started < 0 || process.started <= written + slack;
+	}
+
+#ifdef Q_OS_WIN
+	bool Liveness::lookup(qint64 pid, Process& process)
+	{
+		const qint64 now = QDateTime::currentMSecsSinceEpoch();
+		if (now - m_taken >= m_ttl)
+		{
+			snapshot();
+			m_taken = now;
+		}
+		const auto it = m_processes.find(pid);
+		if (it == m_processes.end())
+			return false;
+		process = it->second;
+		return true;
+	}
+
+	void Liveness::snapshot()
+	{
+		HANDLE snapshot = ::CreateToolhelp32Snapshot(TH32CS_SNAPPROCESS, 0);
+		if (snapshot == INVALID_HANDLE_VALUE)
+			return;
+		std::unordered_map<qint64, Process> current;
+		PROCESSENTRY32W entry;
+		entry.dwSize = sizeof(entry);
+		for (BOOL ok = ::Process32FirstW(snapshot, &entry); ok; ok = ::Process32NextW(snapshot, &entry))
+		{
+			if (::_wcsicmp(entry.szExeFile, L"postgres.exe") != 0)
+				continue;
+			const qint64 pid = entry.th32ProcessID;
+			const auto known = m_processes.find(pid);
+			if (known != m_processes.end() && known->second.started >= 0)
+			{ // process present in both snapshots keeps its start time
+				current.emplace(pid, known->second);
+				continue;
+			}
+			Process process;
+			if (HANDLE handle = ::OpenProcess(PROCESS_QUERY_LIMITED_INFORMATION, FALSE, entry.th32ProcessID))
+			{
+				FILETIME creation, exit, kernel, user;
+				if (::GetProcessTimes(handle, &creation, &exit, &kernel, &user))
+					process.started = static_cast<qint64>(((static_cast<quint64>(creation.dwHighDateTime) << 32) | creation.dwLowDateTime) / 10000)
+						- 11644473600000LL;
+				::CloseHandle(handle);
+			}
+			current.emplace(pid, process);
+		}
+		::CloseHandle(snapshot);
+		m_processes.swap(current);
+	}
+#elif defined(Q_OS_LINUX)
+	bool Liveness::lookup(qint64 pid, Process& process)
+	{
+		const qint64 now = QDateTime::currentMSecsSinceEpoch();
+		if (now - m_taken >= m_ttl)
+		{
+			sweep();
+			m_taken = now;
+		}
+		const auto it = m_processes.find(pid);
+		if (it != m_processes.end())
+		{
+			const Process& known = it->second;
+			const bool same = known.pidfd >= 0
+				? !exited(known.pidfd)
+				: exists(pid) && inspect(pid) == known.started; // no pidfd, start time tells reused pid
+			if (same)
+			{
+				process = known;
+				return true;
+			}
+			if (known.pidfd >= 0)
+				::close(known.pidfd);
+			m_processes.erase(it);
+		}
+		if (!exists(pid))
+			return false;
+		process.started = inspect(pid);
+		if (process.started < 0)
+			return false;
+		process.pidfd = pidfdOpen(pid);
+		if (process.pidfd >= 0 && inspect(pid) != process.started)
+		{ // pid was reused before pidfd was opened
+			::close(process.pidfd);
+			return false;
+		}
+		m_processes.emplace(pid, process);
+		return true;
+	}
+
+	void Liveness::sweep()
+	{
+		for (auto it = m_processes.begin(); it != m_processes.end();)
+		{
+			const Process& known = it->second;
+			if (known.pidfd >= 0 ? !exited(known.pidfd) : exists(it->first))
+			{
+				++it;
+				continue;
+			}
+			if (known.pidfd >= 0)
+				::close(known.pidfd);
+			it = m_processes.erase(it);
+		}
+	}
+
+	qint64 Liveness::inspect(qint64 pid) const
+	{
+		QFile comm{ QString{ "/proc/%1/comm" }.arg(pid) };
+		if (!comm.open(QIODevice::ReadOnly) || comm.readLine(64).trimmed() != "postgres")
+			return -1;
+		QFile stat{ QString{ "/proc/%1/stat" }.arg(pid) };
+		if (!stat.open(QIODevice::ReadOnly))
+			return -1;
+		// fields follow "(comm)", which may hold spaces. starttime is 22nd field
+		const QByteArray line = stat.readAll();
+		const QList<QByteArray> fields = line.mid(line.lastIndexOf(')') + 2).split(' ');
+		if (fields.size() < 20 || m_ticks <= 0)
+			return -1;
+		return m_boot + fields[19].toLongLong() * 1000 / m_ticks;
+	}
+#else
+	bool Liveness::lookup(qint64 pid, Process& process)
+	{
+		process = Process{};
+		return exists(pid);
+	}
+#endif
+
+	////////////////////////////////////////////////////////////////////////////////
+
+} /* namespace pg */
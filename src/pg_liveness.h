@@ -0,0 +1,65 @@
+#pragma once
+#include "settings.h"
+
+#include <QtGlobal>
+
+#include <mutex>
+#include <unordered_map>
+
+namespace pg
+{
+	////////////////////////////////////////////////////////////////////////////////
+
+	/** answers whether pid of postmaster.pid is a live postgres for all clusters at once.
+		windows takes one process snapshot per tick (pg_liveness_ttl, ms) into hash map of
+		postgres processes, linux keeps pidfd of every verified postmaster and polls it,
+		pidfds of exited ones are swept once per tick.
+		pid is only accepted if process is postgres and wasnt started after pid file was
+		written, so reused pids of stale files arent taken for running servers */
+	class Liveness
+	{
+	public:
+		/** clusters are updated from enumerator threads too, released after postgres managers */
+		static Liveness* instance(SingletonPolicy = Get);
+		~Liveness();
+
+		/** written is mtime of pid file, ms since epoch */
+		bool alive(qint64 pid, qint64 written);
+
+	protected:
+		Liveness();
+
+		struct Process
+		{
+			qint64 started = -1; // ms since epoch, -1 if unknown
+#ifdef Q_OS_LINUX
+			int pidfd = -1; // -1 if kernel has no pidfd_open
+#endif
+		};
+
+		/** postgres process with pid, false if there is none */
+		bool lookup(qint64 pid, Process&);
+#ifdef Q_OS_WIN
+		void snapshot();
+#endif
+#ifdef Q_OS_LINUX
+		/** start time of pid from /proc if its comm is postgres, -1 otherwise */
+		qint64 inspect(qint64 pid) const;
+		/** drops processes which have exited, stopped or restarted servers arent looked up again */
+		void sweep();
+#endif
+
+	protected:
+		std::mutex m_lock;
+		std::unordered_map<qint64, Process> m_processes;
+		qint64 m_taken = 0;           // ms since epoch of last snapshot (windows) or sweep (linux)
+		const qint64 m_ttl;
+#ifdef Q_OS_LINUX
+		qint64 m_boot = 0;            // ms since epoch
+		long m_ticks = 100;           // clock ticks per second of /proc/<pid>/stat
+#endif
+	};
+
+	////////////////////////////////////////////////////////////////////////////////
+
+} /* namespace pg */
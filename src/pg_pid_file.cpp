@@ -0,0 +1,64 @@
+#include "pg_pid_file.h"
+
+#include <QFile>
+#include <QList>
+
+namespace pg
+{
+	////////////////////////////////////////////////////////////////////////////////
+
+	PidFile::PidFile(const QString& path)
+	{
+		QFile file{ path };
+		if (file.open(QIODevice::ReadOnly))
+			*this = parse(file.read(4096));
+	}
+
+	PidFile PidFile::parse(const QByteArray& text)
+	{
+		// LOCK_FILE_LINE_*: pid, data dir, start time, port, socket dir, listen addr, shmem key, status
+		PidFile result;
+		const QList<QByteArray> lines = text.split('\n');
+		const auto line = [&lines](int n) { return n < lines.size() ? lines[n].trimmed() : QByteArray{}; };
+		result.pid = qAbs(line(0).toLongLong());
+		result.dataDirectory = QString::fromLocal8Bit(line(1));
+		result.started = line(2).toLongLong();
+		result.port = line(3).toInt();
+		result.socketDirectory = QString::fromLocal8Bit(line(4));
+		result.listenAddress = QString::fromLocal8Bit(line(5));
+		const QList<QByteArray> shmem = line(6).simplified().split(' ');
+		result.shmemKey = shmem.value(0).toUInt();
+		result.shmemId = shmem.value(1).toUInt();
+		const QByteArray status = line(7);
+		if (status == "starting")
+			result.status = Starting;
+		else if (status == "stopping")
+			result.status = Stopping;
+		else if (status == "ready")
+			result.status = Ready;
+		else if (status == "standby")
+			result.status = Standby;
+		return result;
+	}
+
+	QString PidFile::statusName() const
+	{
+		switch (status)
+		{
+		case Starting:
+			return QString::fromUtf8("starting…");
+		case Stopping:
+			return QString::fromUtf8("stopping…");
+		case Ready:
+			return "ready";
+		case Standby:
+			return "standby";
+		case Unknown:
+			break;
+		}
+		return QString{};
+	}
+
+	////////////////////////////////////////////////////////////////////////////////
+
+} /* namespace pg */
@@ -0,0 +1,43 @@
+#pragma once
+#include <QString>
+
+namespace pg
+{
+	////////////////////////////////////////////////////////////////////////////////
+
+	/** postmaster.pid, as written by postmaster (lines of pidfile.h). status line appeared in
+		10, older files leave it Unknown */
+	struct PidFile
+	{
+		enum Status
+		{
+			Unknown,
+			Starting,
+			Stopping,
+			Ready,
+			Standby,
+		};
+
+		qint64 pid = 0;          // postmaster, negative in file for standalone backend
+		QString dataDirectory;
+		qint64 started = 0;      // seconds since epoch
+		int port = 0;
+		QString socketDirectory; // first of unix_socket_directories, empty on windows
+		QString listenAddress;   // first of listen_addresses, empty if tcp is off
+		quint32 shmemKey = 0;
+		quint32 shmemId = 0;
+		Status status = Unknown;
+
+		PidFile() {}
+		/** empty (pid 0) if file cant be read */
+		explicit PidFile(const QString& path);
+		static PidFile parse(const QByteArray&);
+
+		bool valid() const { return pid > 0; }
+		/** "starting…", "ready", empty if unknown */
+		QString statusName() const;
+	};
+
+	////////////////////////////////////////////////////////////////////////////////
+
+} /* namespace pg */
@@ -1,5 +1,9 @@
 #include "pg_version.h"
 #include "pg_conf.h"
+#include "pg_liveness.h"
+#include "pg_version_cache.h"
+#include "directory_walker.h"
+#include "settings.h"
 #include "tooling.h"
 
 #include <QDir>
@@ -7,107 +11,61 @@
 #include <QFile>
 #include <QRegularExpression>
 #include <QCommandLineParser>
-#include <QProcess>
 #include <QSettings>
 #include <QDirIterator>
 
+#include <algorithm>
 #include <exception>
+#include <mutex>
 #include <iostream>
 #include <QDebug>
 #include <stdexcept>
 
-#ifdef Q_OS_WIN
-#	define VC_EXTRALEAN
-#	define WIN32_LEAN_AND_MEAN
-#	include <windows.h>
-#	include <processthreadsapi.h>
-#	include <psapi.h>
-#	include <tlhelp32.h>
-#endif
-
-namespace helper
+namespace pg
 {
-	bool pidValid(const QString& pidFilename)
+	PGCluster::List PGCluster::enumerate(const QString& path, std::map<QString, qint64>* traversed,
+		const std::function<void(const PGCluster&)>& found, const std::atomic<bool>* cancel)
 	{
-		QFile file{ pidFilename };
-		if (!file.open(QIODevice::ReadOnly | QIODevice::Text))
-			return false;
-#ifdef Q_OS_WIN
-		QTextStream in(&file);
-		DWORD pid = static_cast<DWORD>(in.readLine().toLong());
-		file.close();
-
-		HANDLE hProcessSnap = nullptr;
-		PROCESSENTRY32 pe32;
-		pe32.dwSize = sizeof(PROCESSENTRY32);
-		try
-		{
-			hProcessSnap = CreateToolhelp32Snapshot(TH32CS_SNAPPROCESS, 0);
-			if (hProcessSnap == INVALID_HANDLE_VALUE)
-				throw std::runtime_error{ "CreateToolhelp32Snapshot (of processes)" };
-
-			if (!Process32First(hProcessSnap, &pe32))
-				throw std::runtime_error{ "Process32First" };
+		tool::DirectoryWalker::Options options;
+		options.marker = "PG_VERSION";
+		options.maxDepth = Settings::setup()->get("pg_scan_depth", 32).toInt();
+		options.threads = Settings::setup()->get("pg_scan_threads", 0).toInt();
+		options.cancel = cancel;
+		// speedup database searching
+		const QStringList excludes{
+			"bin", "doc", "include", "pgAdmin*", "symbols", "share", "lib", "StackBuilder"
+		};
+		for (const auto& glob : Settings::setup()->get("pg_scan_exclude", excludes).toJsonArray())
+			options.excludes.push_back(glob.toString());
 
-			do
-			{
-				// const ushort* exeFile = (ushort*)pe32.szExeFile;
-				if (pe32.th32ProcessID == pid) // && QString::fromUtf16(exeFile) == "postgres.exe")
+		std::mutex lock;
+		PGCluster::List result;
+		tool::DirectoryWalker walker{ options };
+		walker.walk(QStringList{ path }, [&lock, &result, traversed, &found](const tool::DirectoryWalker::Directory& d) {
+			if (d.marked)
+			{ // stray PG_VERSION is descended, clusters may be below it
+				PGCluster cluster{ d.path };
+				if (cluster.valid())
 				{
-					CloseHandle(hProcessSnap);
+					if (found)
+						found(cluster);
+					auto guard = std::lock_guard{ lock };
+					result.push_back(cluster);
 					return true;
 				}
-			} while (Process32Next(hProcessSnap, &pe32));
-
-			CloseHandle(hProcessSnap);
-			// return true;
-		}
-		catch (const std::exception&)
-		{
-			if (hProcessSnap != nullptr)
-				::CloseHandle(hProcessSnap);
-		}
-#endif
-		return false;
-	}
-} // namespace helper
-
-namespace pg
-{
-	PGCluster::List PGCluster::enumerate(const QString& path)
-	{
-		static const QStringList excludeDirs{
-			".", "..", "bin", "doc", "include",
-			"pgAdmin", "pgAdmin III", "pgAdmin 4",
-			"symbols", "share", "lib", "StackBuilder"
-		}; // speedup database searching
-		PGCluster::List result;
-		QStringList dirs;
-		for (const auto& entry : QDir{ path }.entryList())
-		{
-			QFileInfo info{ QString{ "%1/%2" }.arg(path).arg(entry) };
-			if (info.isFile() && entry == "PG_VERSION")
+			}
+			if (traversed != nullptr)
 			{
-				PGCluster cluster{ path }; // may throw if
-				if (cluster.valid())
-					return PGCluster::List{ cluster };
+				auto guard = std::lock_guard{ lock };
+				(*traversed)[d.path] = d.mtime;
 			}
-			if (info.isDir() && !excludeDirs.contains(entry))
-				dirs.push_back(entry);
-		}
-		for (const auto& entry : dirs)
-		{
-			QFileInfo info{ QString{ "%1/%2" }.arg(path).arg(entry) };
-			if (info.absoluteFilePath() == path)
-				throw std::runtime_error("recursion");
-			PGCluster::List list = enumerate(info.absoluteFilePath());
-			for (const auto& c : list)
-				result.push_back(c);
-		}
+			return false;
+		});
+		std::sort(result.begin(), result.end(), [](const PGCluster& a, const PGCluster& b) { return a.path() < b.path(); });
 		return result;
 	}
 
-	PGVersion::List PGVersion::enumerate(const QString& path)
+	PGVersion::List PGVersion::enumerate(const QString& path, const std::atomic<bool>* cancel)
 	{
 		PGVersion::List result;
 		QDir loc(path);
@@ -117,20 +75,26 @@ namespace pg
 			throw std::runtime_error{ "postgresql location isnt exists" };
 		}
 
-		if (QFileInfo{ QString{ "%1/bin/postgres.exe" }.arg(path) }.exists())
-			return PGVersion::List{ PGVersion{ path } };
+		if (QFileInfo{ QString{ "%1/bin/%2" }.arg(path).arg(executable("postgres")) }.exists())
+			return PGVersion::List{ PGVersion{ path, cancel } };
 
+		QStringList directories;
 		for (const auto& dir : loc.entryList())
 		{
 			QFileInfo current{ QString{ "%1/%2" }.arg(path).arg(dir) };
 			if (dir != QString{ "." }
 				&& dir != QString{ ".." }
 				&& current.isDir())
-			{
-				pg::PGVersion ver{ current.absoluteFilePath() };
-				if (ver.valid())
-					result.emplace_back(ver);
-			}
+				directories.push_back(current.absoluteFilePath());
+		}
+		prefetch(directories, cancel);
+		for (const auto& dir : directories)
+		{
+			if (cancel != nullptr && *cancel)
+				break;
+			pg::PGVersion ver{ dir, cancel };
+			if (ver.valid())
+				result.emplace_back(ver);
 		}
 		return result;
 	}
@@ -148,6 +112,7 @@ namespace pg
 				m_conf = std::make_shared<Configuration>(QString{ "%1/postgresql.conf" }.arg(m_path));
 				readPostmasterOpts();
 				readPostgresPid();
+				readControlFile();
 			}
 		}
 		catch (const std::exception& e)
@@ -165,6 +130,9 @@ namespace pg
 		, m_version{ c.m_version }
 		, m_dbIsRunning{ c.m_dbIsRunning }
 		, m_conf{ c.m_conf }
+		, m_control{ c.m_control }
+		, m_stamps(c.m_stamps)
+		, m_pidFile{ c.m_pidFile }
 	{
 	}
 
@@ -174,6 +142,9 @@ namespace pg
 		m_version = c.m_version;
 		m_dbIsRunning = c.m_dbIsRunning;
 		m_conf = c.m_conf;
+		m_control = c.m_control;
+		m_stamps = c.m_stamps;
+		m_pidFile = c.m_pidFile;
 		return *this;
 	}
 
@@ -187,6 +158,36 @@ namespace pg
 		return m_dbIsRunning;
 	}
 
+	bool PGCluster::crashed() const
+	{
+		return !m_dbIsRunning && m_control.crashed();
+	}
+
+	const ControlFile& PGCluster::controlFile() const
+	{
+		return m_control;
+	}
+
+	const PidFile& PGCluster::pidFile() const
+	{
+		return m_pidFile;
+	}
+
+	bool PGCluster::ready() const
+	{
+		// files before 10 have no status, running server is taken as ready
+		return m_dbIsRunning
+			&& (m_pidFile.status == PidFile::Ready || m_pidFile.status == PidFile::Standby || m_pidFile.status == PidFile::Unknown);
+	}
+
+	int PGCluster::port() const
+	{
+		if (m_dbIsRunning && m_pidFile.port > 0)
+			return m_pidFile.port;
+		const int configured = m_conf != nullptr && m_conf->contains("port") ? m_conf->get("port").value.trimmed().toInt() : 0;
+		return configured > 0 ? configured : 5432;
+	}
+
 	QString PGCluster::version() const
 	{
 		return m_version;
@@ -231,39 +232,54 @@ namespace pg
 		return !(*this == c);
 	}
 
-	void PGCluster::updateDatabaseState()
+	bool PGCluster::updateDatabaseState()
 	{
-		if (m_path.isEmpty())
-			return;
+		if (m_path.isEmpty() || m_conf == nullptr)
+			return false;
 
 		// получаем параметры кластера
-		readPostmasterOpts();
-		getInfo();
-		readPostgresPid();
+		const bool running = m_dbIsRunning;
+		bool changed = m_conf->reload();
+		changed |= readPostmasterOpts();
+		changed |= getInfo();
+		changed |= readPostgresPid();
+		changed |= readControlFile();
+		if (!changed && running == m_dbIsRunning)
+			return false;
 
 		emit databaseStateUpdated();
+		return true;
 	}
 
-	void PGCluster::getInfo()
+	bool PGCluster::getInfo()
 	{
-		QFile file{ QString{ "%1/PG_VERSION" }.arg(m_path) };
+		const QString path = QString{ "%1/PG_VERSION" }.arg(m_path);
+		if (!tool::FileStamp::refresh(m_stamps.version, path))
+			return false;
+		QFile file{ path };
 		// выделяем версию базы данных
 		if (!file.open(QIODevice::ReadOnly | QIODevice::Text))
-			return;
+			return true;
 		QString text = QString::fromUtf8(file.readAll());
 		static const QRegularExpression ver{ "^((\\d+)\\.?(\\d+)?\\.?(\\d*))" };
 		auto m = ver.match(text);
 		if (!m.hasMatch())
-			return;
+			return true;
 		m_version = m.captured(1);
 		file.close();
+		return true;
 	}
 
-	void PGCluster::readPostmasterOpts()
+	bool PGCluster::readPostmasterOpts()
 	{
-		QFile file{ QString{ "%1/postmaster.opts" }.arg(m_path) };
+		const QString path = QString{ "%1/postmaster.opts" }.arg(m_path);
+		if (!tool::FileStamp::refresh(m_stamps.opts, path))
+			return false;
+		// options missing from new command line (or with file gone) are back to configuration
+		m_conf->clearOverrides();
+		QFile file{ path };
 		if (!file.open(QIODevice::ReadOnly | QIODevice::Text))
-			return;
+			return true;
 		QString commandLine(file.readAll());
 		file.close();
 
@@ -293,18 +309,35 @@ namespace pg
 		{
 			const QString optName = opt.names().front();
 			if (parser.isSet(optName) && !opt.description().isEmpty())
-				m_conf->set(opt.description(), parser.value(optName));
+				m_conf->override(opt.description(), parser.value(optName), file.fileName());
 		}
+		return true;
 	}
 
-	void PGCluster::readPostgresPid()
+	bool PGCluster::readPostgresPid()
 	{
 		QString pidFilename = QString{ "%1/postmaster.pid" }.arg(m_path);
-		auto extPid = m_conf->get("external_pid_file");
-		if (!extPid.commented)
-			pidFilename = extPid.dequoteValue();
+		if (m_conf->contains("external_pid_file"))
+		{
+			auto extPid = m_conf->get("external_pid_file");
+			if (!extPid.commented)
+				pidFilename = extPid.dequoteValue();
+		}
 
-		m_dbIsRunning = helper::pidValid(pidFilename);
+		const bool changed = tool::FileStamp::refresh(m_stamps.pid, pidFilename);
+		if (changed)
+			m_pidFile = PidFile{ pidFilename };
+		// pid file stays after crash, so process is checked on every update
+		m_dbIsRunning = m_stamps.pid.exists() && Liveness::instance()->alive(m_pidFile.pid, m_stamps.pid.mtime);
+		return changed;
+	}
+
+	bool PGCluster::readControlFile()
+	{
+		if (!tool::FileStamp::refresh(m_stamps.control, QString{ "%1/global/pg_control" }.arg(m_path)))
+			return false;
+		m_control = ControlFile{ m_path };
+		return true;
 	}
 
 	////////////////////////////////////////////////////////////////////////////////
@@ -312,20 +345,20 @@ namespace pg
 	PGVersion::PGVersion()
 	{}
 
-	PGVersion::PGVersion(const QString& p)
+	PGVersion::PGVersion(const QString& p, const std::atomic<bool>* cancel)
 		: m_path(p)
 	{
 		// if path was pointed directly to bin directory
-		if (QFileInfo{ QString{ "%1/postgres.exe" }.arg(m_path) }.exists())
+		if (QFileInfo{ QString{ "%1/%2" }.arg(m_path).arg(executable("postgres")) }.exists())
 			m_path = QFileInfo{ QString{ "%1/../" }.arg(m_path) }.absoluteFilePath();
 
 		m_binaryPath = QFileInfo{ QString{ "%1/bin/" }.arg(m_path) }.absoluteFilePath();
 		const QFileInfo
 			directory{ m_binaryPath },
-			binary{ QString{ "%1/postgres.exe" }.arg(m_binaryPath) };
+			binary{ QString{ "%1/%2" }.arg(m_binaryPath).arg(executable("postgres")) };
 
 		if (directory.exists() && directory.isDir() && binary.exists())
-			getVersion();
+			getVersion(cancel);
 	}
 
 	PGVersion::PGVersion(const PGVersion& v)
@@ -373,21 +406,33 @@ namespace pg
 		return !(*this == v);
 	}
 
-	void PGVersion::getVersion()
-	{
-		QProcessEnvironment pe = QProcessEnvironment::systemEnvironment();
-		QProcess proc;
-		proc.setProcessEnvironment(pe);
-		QStringList arguments;
-		arguments << "--version";
-		proc.setProgram(QString{ "%1/postgres.exe" }.arg(m_binaryPath));
-		proc.setArguments(arguments);
-		proc.setWorkingDirectory(m_binaryPath);
-		proc.start();
-		proc.waitForFinished();
-		QString version{ proc.readAllStandardOutput() };
-		QRegularExpression extract("((\\d+)\\.?(\\d+)?\\.?(\\d*))");
-		m_binaryVersion = extract.match(version).captured(1);
+	QString PGVersion::executable(const QString& name)
+	{
+#ifdef Q_OS_WIN
+		return name + ".exe";
+#else
+		return name;
+#endif
+	}
+
+	void PGVersion::prefetch(const QStringList& directories, const std::atomic<bool>* cancel)
+	{
+		QStringList binaries;
+		for (const auto& dir : directories)
+		{
+			const QString bin = QFileInfo{ QString{ "%1/%2" }.arg(dir).arg(executable("postgres")) }.exists()
+				? dir
+				: QString{ "%1/bin" }.arg(dir);
+			binaries.push_back(QDir::cleanPath(QFileInfo{ QString{ "%1/%2" }.arg(bin).arg(executable("postgres")) }.absoluteFilePath()));
+		}
+		VersionCache::instance()->probe(binaries, cancel);
+	}
+
+	void PGVersion::getVersion(const std::atomic<bool>* cancel)
+	{
+		// warm cache doesnt start process at all
+		m_binaryVersion = VersionCache::instance()->version(
+			QDir::cleanPath(QFileInfo{ QString{ "%1/%2" }.arg(m_binaryPath).arg(executable("postgres")) }.absoluteFilePath()), cancel);
 	}
 
 	////////////////////////////////////////////////////////////////////////////////
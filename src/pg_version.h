@@ -1,6 +1,13 @@
 #pragma once
+#include "file_stamp.h"
+#include "pg_control.h"
+#include "pg_pid_file.h"
+
 #include <QObject>
+#include <atomic>
 #include <deque>
+#include <functional>
+#include <map>
 #include <memory>
 
 namespace pg
@@ -26,6 +33,16 @@ namespace pg
 		bool valid() const;
 		/** Запущенн ли кластер */
 		bool running() const;
+		/** not running, but pg_control says it wasnt shut down cleanly */
+		bool crashed() const;
+		/** global/pg_control as of last state update */
+		const ControlFile& controlFile() const;
+		/** postmaster.pid as of last state update, stale one if server isnt running */
+		const PidFile& pidFile() const;
+		/** running and accepting connections (ready or standby) */
+		bool ready() const;
+		/** port server listens on while running, configured one otherwise */
+		int port() const;
 		/** версия постгреса, с которым был развернут кластер */
 		QString version() const;
 		/** путь, по которому развернут кластер */
@@ -34,8 +51,10 @@ namespace pg
 		pConfiguration configuration() const;
 		/** check if this cluster is compatible with requested binaries */
 		bool compatible(const PGVersion&) const;
-		/** рекурсивный поиск базы в директории */
-		static PGCluster::List enumerate(const QString&);
+		/** рекурсивный поиск базы в директории, traversed gets mtimes of directories walked through.
+			found is called from walker threads as soon as cluster is validated */
+		static PGCluster::List enumerate(const QString&, std::map<QString, qint64>* traversed = nullptr,
+			const std::function<void(const PGCluster&)>& found = nullptr, const std::atomic<bool>* cancel = nullptr);
 		/** get real directory mountpoint */
 		QString pathJunction() const;
 
@@ -44,15 +63,19 @@ namespace pg
 	signals:
 		void databaseStateUpdated();
 	public slots:
-		void updateDatabaseState();
+		/** files are re-read only if their stamps changed, liveness of pid is checked always.
+			signal is emitted and true returned only if something has changed */
+		bool updateDatabaseState();
 
 	protected:
 		/** выделить версию initdb */
-		void getInfo();
+		bool getInfo();
 		/** прочесть как запускалась БД раньше */
-		void readPostmasterOpts();
+		bool readPostmasterOpts();
 		/** расковырять pid файл (при наличии) */
-		void readPostgresPid();
+		bool readPostgresPid();
+		/** global/pg_control */
+		bool readControlFile();
 
 	protected:
 		QString
@@ -60,6 +83,12 @@ namespace pg
 			m_version;
 		bool m_dbIsRunning = false;
 		pConfiguration m_conf;
+		ControlFile m_control;
+		struct Stamps
+		{
+			tool::FileStamp version, opts, pid, control;
+		} m_stamps;
+		PidFile m_pidFile;
 	};
 
 	////////////////////////////////////////////////////////////////////////////////
@@ -71,7 +100,8 @@ namespace pg
 	public:
 		using List = std::deque<PGVersion>;
 		PGVersion();
-		PGVersion(const QString&);
+		/** probe of version not cached yet is abandoned when cancel is set, version is empty then */
+		PGVersion(const QString&, const std::atomic<bool>* cancel = nullptr);
 		PGVersion(const PGVersion&);
 		PGVersion& operator=(const PGVersion&);
 
@@ -85,11 +115,15 @@ namespace pg
 		bool operator!=(const PGVersion&) const;
 
 		/** try to locate all available pg dirs (non recursive) */
-		static List enumerate(const QString&);
+		static List enumerate(const QString&, const std::atomic<bool>* cancel = nullptr);
+		/** platform file name of postgres program ("postgres" -> "postgres.exe" on windows) */
+		static QString executable(const QString&);
+		/** versions of installs in directories are probed concurrently, when they are not cached yet */
+		static void prefetch(const QStringList& directories, const std::atomic<bool>* cancel = nullptr);
 
 	protected:
-		/** версия найденных бинарников */
-		void getVersion();
+		/** версия найденных бинарников, из кэша */
+		void getVersion(const std::atomic<bool>* cancel);
 
 	protected:
 		QString
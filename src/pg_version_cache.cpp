@@ -0,0 +1,294 @@
+#include "pg_version_cache.h"
+#include "byte_search.h"
+#include "settings.h"
+
+#include <QDataStream>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QProcess>
+#include <QRegularExpression>
+#include <QSaveFile>
+
+#include <algorithm>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+#include <QDebug>
+
+namespace pg
+{
+	////////////////////////////////////////////////////////////////////////////////
+
+	namespace
+	{
+		const quint32 cacheMagic = 0x50475643; // PGVC
+		const quint32 cacheFormat = 1;
+		const int probeTimeout = 30000; // ms, of single "--version"
+		const int probeSlice = 100;     // ms, cancellation latency
+
+		template <typename T>
+		T read(const uchar* data, size_t size, size_t offset)
+		{ // little endian, unaligned
+			T value{};
+			if (offset <= size && sizeof(T) <= size - offset)
+				std::memcpy(&value, data + offset, sizeof(T));
+			return value;
+		}
+
+		/** [offset, offset + size) of .rodata (elf64) or .rdata (pe), whole file if it isnt found */
+		std::pair<size_t, size_t> readOnlyData(const uchar* data, size_t size)
+		{
+			if (size > 0x40 && std::memcmp(data, "\x7f" "ELF", 4) == 0 && data[4] == 2)
+			{
+				const auto shoff = read<quint64>(data, size, 0x28);
+				const auto shentsize = read<quint16>(data, size, 0x3A);
+				const auto shnum = read<quint16>(data, size, 0x3C);
+				const auto shstrndx = read<quint16>(data, size, 0x3E);
+				const auto strtab = read<quint64>(data, size, shoff + size_t{ shstrndx } * shentsize + 24);
+				for (quint16 i = 0; i < shnum; ++i)
+				{
+					const size_t header = shoff + size_t{ i } * shentsize;
+					const size_t name = strtab + read<quint32>(data, size, header);
+					const auto offset = read<quint64>(data, size, header + 24);
+					const auto length = read<quint64>(data, size, header + 32);
+					if (name + 8 <= size && std::memcmp(data + name, ".rodata", 8) == 0 && offset <= size && length <= size - offset)
+						return { offset, length };
+				}
+			}
+			else if (size > 0x40 && data[0] == 'M' && data[1] == 'Z')
+			{
+				const auto pe = read<quint32>(data, size, 0x3C);
+				if (pe + 24 <= size && std::memcmp(data + pe, "PE\0\0", 4) == 0)
+				{
+					const auto sections = read<quint16>(data, size, pe + 6);
+					const size_t table = pe + 24 + read<quint16>(data, size, pe + 20);
+					for (quint16 i = 0; i < sections; ++i)
+					{
+						const size_t header = table + size_t{ i } * 40;
+						const auto length = read<quint32>(data, size, header + 16);
+						const auto offset = read<quint32>(data, size, header + 20);
+						if (header + 8 <= size && std::memcmp(data + header, ".rdata\0", 7) == 0 && offset <= size && length <= size - offset)
+							return { offset, length };
+					}
+				}
+			}
+			return { 0, size };
+		}
+
+		/** leading "16.2" of text */
+		QString versionPrefix(const char* text, size_t size)
+		{
+			size_t n = 0;
+			while (n < size && n < 32 && ((text[n] >= '0' && text[n] <= '9') || (n != 0 && text[n] == '.')))
+				++n;
+			while (n != 0 && text[n - 1] == '.')
+				--n;
+			return QString::fromLatin1(text, static_cast<int>(n));
+		}
+	} // namespace
+
+	////////////////////////////////////////////////////////////////////////////////
+
+	VersionCache* VersionCache::instance(SingletonPolicy policy)
+	{
+		static VersionCache* instance{ nullptr };
+		if (policy == Get && instance == nullptr)
+			instance = new VersionCache;
+		if (policy == Release && instance != nullptr)
+			delete instance, instance = nullptr;
+		return instance;
+	}
+
+	VersionCache::VersionCache()
+		: m_path{ QFileInfo{ Settings::setup()->configPath() }.absoluteDir().absoluteFilePath("pg_versions.cache") }
+	{
+		QFile file{ m_path };
+		if (!file.open(QIODevice::ReadOnly))
+			return;
+		QDataStream in{ &file };
+		in.setVersion(QDataStream::Qt_5_9);
+		quint32 magic = 0, format = 0, count = 0;
+		in >> magic >> format >> count;
+		if (magic != cacheMagic || format != cacheFormat)
+			return;
+		for (quint32 i = 0; i < count && in.status() == QDataStream::Ok; ++i)
+		{
+			QString binary;
+			Entry entry;
+			in >> binary >> entry.stamp.size >> entry.stamp.mtime >> entry.stamp.inode >> entry.version;
+			if (in.status() == QDataStream::Ok)
+				m_entries.insert(binary, entry);
+		}
+	}
+
+	QString VersionCache::find(const QString& binary)
+	{
+		const Stamp current{ binary };
+		auto lock = std::lock_guard{ m_lock };
+		const auto it = m_entries.find(binary);
+		return (it != m_entries.end() && it->stamp == current) ? it->version : QString{};
+	}
+
+	QString VersionCache::version(const QString& binary, const std::atomic<bool>* cancel)
+	{
+		QString result = find(binary);
+		if (result.isEmpty())
+		{
+			probe(QStringList{ binary }, cancel);
+			result = find(binary);
+		}
+		return result;
+	}
+
+	void VersionCache::probe(const QStringList& binaries, const std::atomic<bool>* cancel)
+	{
+		const auto cancelled = [cancel]() { return cancel != nullptr && *cancel; };
+		std::vector<std::pair<QString, Stamp>> missing;
+		{
+			auto lock = std::lock_guard{ m_lock };
+			for (const auto& binary : binaries)
+			{
+				const Stamp current{ binary };
+				const auto it = m_entries.find(binary);
+				if (current.size >= 0 && (it == m_entries.end() || it->stamp != current)
+					&& std::none_of(missing.begin(), missing.end(), [&binary](const auto& m) { return m.first == binary; }))
+					missing.emplace_back(binary, current);
+			}
+		}
+		bool found = false;
+		for (auto it = missing.begin(); it != missing.end();)
+		{
+			if (cancelled())
+				break;
+			const QString version = inspect(it->first);
+			if (version.isEmpty())
+			{
+				++it;
+				continue;
+			}
+			auto lock = std::lock_guard{ m_lock };
+			m_entries.insert(it->first, Entry{ it->second, version });
+			found = true;
+			it = missing.erase(it);
+		}
+
+		// binary is executed as last resort, all probes are started before waiting
+		std::vector<std::unique_ptr<QProcess>> processes;
+		for (const auto& [binary, s] : missing)
+		{
+			if (cancelled())
+				break;
+			auto& proc = *processes.emplace_back(std::make_unique<QProcess>());
+			proc.setProcessEnvironment(QProcessEnvironment::systemEnvironment());
+			proc.setProgram(binary);
+			proc.setArguments(QStringList{ "--version" });
+			proc.setWorkingDirectory(QFileInfo{ binary }.absolutePath());
+			proc.start();
+		}
+
+		static const QRegularExpression extract{ "((\\d+)\\.?(\\d+)?\\.?(\\d*))" };
+		for (size_t i = 0; i < processes.size(); ++i)
+		{
+			// waited in slices, cancelled discovery mustnt sit out 30 s of hung binary
+			for (int waited = 0; !cancelled() && waited < probeTimeout; waited += probeSlice)
+				if (processes[i]->waitForFinished(probeSlice) || processes[i]->state() == QProcess::NotRunning)
+					break;
+			if (cancelled())
+			{
+				for (auto& process : processes)
+					if (process->state() != QProcess::NotRunning)
+						process->kill(), process->waitForFinished(probeSlice);
+				break;
+			}
+			const QString version = extract.match(QString{ processes[i]->readAllStandardOutput() }).captured(1);
+			if (version.isEmpty())
+			{
+				qDebug() << "cant get version of" << missing[i].first;
+				continue;
+			}
+			auto lock = std::lock_guard{ m_lock };
+			m_entries.insert(missing[i].first, Entry{ missing[i].second, version });
+			found = true;
+		}
+		if (found)
+			save();
+	}
+
+	QString VersionCache::inspect(const QString& binary)
+	{
+		const QDir root{ QFileInfo{ binary }.absolutePath() + "/.." };
+
+		// PG_VERSION of headers installed with binaries, full version
+		static const QByteArray define{ "#define PG_VERSION \"" };
+		for (const char* header : { "include/pg_config.h", "include/server/pg_config.h", "include/postgresql/server/pg_config.h" })
+		{
+			QFile file{ root.filePath(header) };
+			if (!file.open(QIODevice::ReadOnly))
+				continue;
+			const QByteArray text = file.readAll();
+			const int at = text.indexOf(define);
+			if (at < 0)
+				continue;
+			const QString version = versionPrefix(text.constData() + at + define.size(), static_cast<size_t>(text.size() - at - define.size()));
+			if (!version.isEmpty())
+				return version;
+		}
+
+		// PG_BACKEND_VERSIONSTR, what --version prints: "postgres (PostgreSQL) 16.2"
+		QFile file{ binary };
+		if (file.open(QIODevice::ReadOnly) && file.size() > 0)
+		{
+			if (const uchar* map = file.map(0, file.size()))
+			{
+				static const char needle[] = "(PostgreSQL) ";
+				const auto [offset, length] = readOnlyData(map, static_cast<size_t>(file.size()));
+				const char* data = reinterpret_cast<const char*>(map) + offset;
+				const char* at = tool::findBytes(data, length, needle, sizeof(needle) - 1);
+				const QString version = at != nullptr
+					? versionPrefix(at + sizeof(needle) - 1, length - static_cast<size_t>(at - data) - (sizeof(needle) - 1))
+					: QString{};
+				file.unmap(const_cast<uchar*>(map));
+				if (!version.isEmpty())
+					return version;
+			}
+		}
+
+		// catalog bootstrap file starts with "# PostgreSQL 16", major version only
+		for (const char* bki : { "share/postgres.bki", "share/postgresql/postgres.bki" })
+		{
+			QFile file{ root.filePath(bki) };
+			if (!file.open(QIODevice::ReadOnly))
+				continue;
+			static const QByteArray prefix{ "# PostgreSQL " };
+			const QByteArray line = file.readLine(64);
+			if (line.startsWith(prefix))
+			{
+				const QString version = versionPrefix(line.constData() + prefix.size(), static_cast<size_t>(line.size() - prefix.size()));
+				if (!version.isEmpty())
+					return version;
+			}
+		}
+		return QString{};
+	}
+
+	void VersionCache::save()
+	{
+		QByteArray data;
+		{
+			QDataStream out{ &data, QIODevice::WriteOnly };
+			out.setVersion(QDataStream::Qt_5_9);
+			auto lock = std::lock_guard{ m_lock };
+			out << cacheMagic << cacheFormat << static_cast<quint32>(m_entries.size());
+			for (auto it = m_entries.begin(); it != m_entries.end(); ++it)
+				out << it.key() << it->stamp.size << it->stamp.mtime << it->stamp.inode << it->version;
+		}
+		QSaveFile file{ m_path };
+		if (!file.open(QIODevice::WriteOnly) || file.write(data) < 0 || !file.commit())
+			qDebug() << "cant save" << m_path;
+	}
+
+	////////////////////////////////////////////////////////////////////////////////
+
+} /* namespace pg */
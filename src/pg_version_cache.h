@@ -0,0 +1,55 @@
+#pragma once
+#include "file_stamp.h"
+#include "settings.h"
+
+#include <QHash>
+#include <QStringList>
+
+#include <atomic>
+#include <mutex>
+
+namespace pg
+{
+	////////////////////////////////////////////////////////////////////////////////
+
+	/** versions of postgres binaries kept across runs in pg_versions.cache, keyed by binary
+		path and its stamp (size, mtime, inode), so unchanged installs are never executed */
+	class VersionCache
+	{
+	public:
+		/** released after postgres managers, whose destructors await enumerator threads */
+		static VersionCache* instance(SingletonPolicy = Get);
+
+		/** empty if binary was never probed or has changed since */
+		QString find(const QString& binary);
+		/** detects versions of binaries missing in cache from installation files, for the rest
+			runs "--version" all at once and returns after last one exits, or kills them once
+			cancel is set */
+		void probe(const QStringList& binaries, const std::atomic<bool>* cancel = nullptr);
+		/** version without executing binary: include/pg_config.h, version string in binary's
+			read-only data, share/postgres.bki header (major only). empty if nothing is found */
+		static QString inspect(const QString& binary);
+		/** cached or probed version. blocks on miss, it is called from enumerator threads only,
+			after prefetch of all installs, so miss is rare */
+		QString version(const QString& binary, const std::atomic<bool>* cancel = nullptr);
+
+	protected:
+		VersionCache();
+		void save();
+
+		using Stamp = tool::FileStamp;
+		struct Entry
+		{
+			Stamp stamp;
+			QString version;
+		};
+
+	protected:
+		const QString m_path;
+		std::mutex m_lock;
+		QHash<QString, Entry> m_entries;
+	};
+
+	////////////////////////////////////////////////////////////////////////////////
+
+} /* namespace pg */
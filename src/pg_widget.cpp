@@ -3,7 +3,11 @@
 #include "pg_conf.h"
 #include "pg_version.h"
 #include "src/tooling.h"
-#include "wmi_process.h"
+#include "service_registry.h"
+#include "local_supervisor.h"
+#include "event_log.h"
+#include "pg_ctl.h"
+#include "service_stats.h"
 
 #include "ui_postgresframe.h"
 #include "ui_postgreswidget.h"
@@ -11,15 +15,22 @@
 #include "ui_clusterwidget.h"
 
 #include <QDir>
+#include <QFileInfo>
 #include <QVBoxLayout>
 #include <QJsonArray>
 #include <QTimer>
 #include <QRegularExpression>
 #include <QValidator>
 #include <QThreadPool>
+#include <QFileSystemWatcher>
+#include <QCompleter>
+#include <QStringListModel>
 
+#include <algorithm>
 #include <chrono>
 #include <mutex>
+#include <tuple>
+#include <vector>
 #include <stdexcept>
 
 #include <QDebug>
@@ -27,55 +38,197 @@
 
 ////////////////////////////////////////////////////////////////////////////////
 
-DirectoriesEnumerator::DirectoriesEnumerator()
+DirectoriesEnumerator::DirectoriesEnumerator(std::shared_ptr<pg::ClusterIndex> index, std::shared_ptr<Discovery> discovery, bool refresh)
+	: m_index{ std::move(index) }
+	, m_discovery{ std::move(discovery) }
+	, m_refresh{ refresh }
 {
+	auto lock = std::lock_guard{ m_discovery->lock };
+	++m_discovery->running;
 }
 
-void DirectoriesEnumerator::awake()
+DirectoriesEnumerator::~DirectoriesEnumerator()
 {
-	std::unique_lock<std::mutex> lk(m_ux);
-	m_continue = true;
-	m_waiter.notify_one();
+	auto lock = std::lock_guard{ m_discovery->lock };
+	--m_discovery->running;
+	m_discovery->finished.notify_all();
+}
+
+bool DirectoriesEnumerator::cancelled() const
+{
+	return m_discovery->cancel;
 }
 
 void DirectoriesEnumerator::run()
 {
+	// services are matched meanwhile, manager keeps them for clusters shown later
+	std::thread services{ [this]() {
+		if (!cancelled())
+			findPostgresServices();
+	} };
+
+	// versions flow from probing (this thread) to walking
+	std::mutex lock;
+	std::condition_variable ready;
+	std::deque<pg::PGVersion> queue;
+	bool probed = false;
+	std::thread walker{ [&]() {
+		std::vector<std::pair<pg::PGVersion, QString>> walks; // after clusters known from index are shown
+		while (true)
+		{
+			auto guard = std::unique_lock{ lock };
+			ready.wait(guard, [&]() { return probed || !queue.empty(); });
+			if (queue.empty())
+				break;
+			const pg::PGVersion ver = queue.front();
+			queue.pop_front();
+			guard.unlock();
+
+			if (!m_index->clustersKnown(ver.path()))
+			{
+				walks.emplace_back(ver, ver.path());
+				continue;
+			}
+			if (!m_refresh)
+				for (const auto& path : m_index->clusters(ver.path()))
+				{
+					if (cancelled())
+						return;
+					pg::PGCluster cluster{ path };
+					if (cluster.valid())
+						emit directoriesEnumerated(ver, pg::PGCluster::List{ cluster });
+				}
+			for (const auto& directory : m_index->stale(ver.path()))
+				walks.emplace_back(ver, directory);
+		}
+		for (const auto& [ver, directory] : walks)
+			if (!cancelled())
+				rescan(ver, directory);
+	} };
+
+	const auto offer = [&](const pg::PGVersion& version) {
+		emit versionsEnumerated(pg::PGVersion::List{ version });
+		auto guard = std::lock_guard{ lock };
+		queue.push_back(version);
+		ready.notify_one();
+	};
 	const auto pathList = Settings::setup()->get("pg_dir").toJsonArray();
+	QStringList paths;
 	for (const auto& pathObj : pathList)
+		paths.push_back(pathObj.toString().replace("\\", "/"));
+	// pg_dir entries pointing to single install are probed together too
+	pg::PGVersion::prefetch(paths, &m_discovery->cancel);
+	for (const auto& path : paths)
 	{
-		const QString path = pathObj.toString().replace("\\", "/");
-		const auto versions = pg::PGVersion::enumerate(path);
+		if (cancelled())
+			break;
+		if (m_index->installsKnown(path))
+		{
+			const QStringList installs = m_index->installs(path);
+			pg::PGVersion::prefetch(installs, &m_discovery->cancel);
+			for (const auto& install : installs)
+			{
+				if (cancelled())
+					break;
+				pg::PGVersion version{ install, &m_discovery->cancel };
+				if (version.valid())
+					offer(version);
+			}
+			continue;
+		}
+		const auto versions = pg::PGVersion::enumerate(path, &m_discovery->cancel);
+		if (cancelled())
+			break;
+		QStringList installs;
 		for (const auto& version : versions)
-			m_versions.push_back(version);
+		{
+			offer(version);
+			installs.push_back(version.path());
+		}
+		m_index->setInstalls(path, installs);
 	}
-	emit versionsEnumerated(m_versions);
-
-	std::unique_lock<std::mutex> lk(m_ux);
-	while (!m_continue)
-		m_waiter.wait_for(lk, std::chrono::milliseconds(1000));
-
-	for (const auto& ver : m_versions)
 	{
-		auto lst = pg::PGCluster::enumerate(ver.path());
-		if (!lst.empty())
-			emit directoriesEnumerated(ver, lst);
+		auto guard = std::lock_guard{ lock };
+		probed = true;
+		ready.notify_one();
 	}
-	// now, here, we can enumerate system services to find pg services
-	findPostgresServices();
+	walker.join();
+	services.join();
+
+	// partial walk would hide clusters on next start
+	if (cancelled())
+		return;
+	m_index->save();
+	emit indexUpdated();
+}
+
+void DirectoriesEnumerator::rescan(const pg::PGVersion& ver, const QString& directory)
+{
+	QStringList before;
+	for (const auto& path : m_index->clusters(ver.path()))
+		if (pg::ClusterIndex::below(path, QDir::cleanPath(directory)))
+			before.push_back(path);
+	pg::ClusterIndex::Directories walked;
+	const auto found = pg::PGCluster::enumerate(directory, &walked, [this, &ver, &before](const pg::PGCluster& cluster) {
+		// new ones are shown while walk goes on
+		if (!before.contains(cluster.path()))
+			emit directoriesEnumerated(ver, pg::PGCluster::List{ cluster });
+	}, &m_discovery->cancel);
+	if (cancelled())
+		return;
+
+	QStringList paths;
+	for (const auto& cluster : found)
+		paths.push_back(cluster.path());
+	m_index->update(ver.path(), directory, walked, paths);
+
+	QStringList removed;
+	for (const auto& path : before)
+		if (!paths.contains(path))
+			removed.push_back(path);
+	if (!removed.isEmpty())
+		emit clustersRemoved(removed);
 }
 
 void DirectoriesEnumerator::findPostgresServices()
 {
-	QTextStream out{ stdout };
-	auto services = tool::WmiObject::objects("service");
-	for (const auto& wmiservice : services)
+	auto entries = ServiceRegistry::instance()->byExecutable(pg::PGVersion::executable("pg_ctl"));
+	// local supervisor runs postmaster itself, in foreground
+	for (const QString exe : { "postgres", "postgres.exe" })
+		for (const auto& entry : ServiceRegistry::instance()->byExecutable(exe))
+			if (entry->local)
+				entries.push_back(entry);
+
+	std::vector<std::tuple<pServiceControl, QString, QString>> found; // service, binaries, data
+	QStringList unknown;
+	for (const auto& entry : entries)
 	{
-		auto service = std::make_shared<WmiService>(wmiservice);
-		if (service->executable() != "pg_ctl.exe")
-			continue;
+		auto service = entry->service();
+		QString binaries, data;
+		if (const auto wmi = std::dynamic_pointer_cast<WmiService>(service))
+		{
+			binaries = wmi->executableDirectory();
+			data = wmi->executableKeyData("-D");
+		}
+		else if (const auto* d = LocalSupervisor::instance()->definition(entry->name))
+		{
+			binaries = QFileInfo{ d->command }.absolutePath() + '/';
+			const int key = d->arguments.indexOf("-D");
+			if (key >= 0 && key + 1 < d->arguments.size())
+				data = d->arguments[key + 1];
+		}
+		found.emplace_back(service, binaries, data);
+		unknown.push_back(binaries);
+	}
+	// services of not yet seen installs are probed together, not one by one
+	pg::PGVersion::prefetch(unknown, &m_discovery->cancel);
 
-		pg::PGVersion ver{ service->executableDirectory() };
-		pg::PGCluster cluster{ service->executableKeyData("-D") };
+	for (const auto& [service, binaries, data] : found)
+	{
+		if (cancelled())
+			return;
+		pg::PGVersion ver{ binaries, &m_discovery->cancel };
+		pg::PGCluster cluster{ data };
 		if (!ver.valid() || !cluster.valid())
 			continue;
 		emit serviceDiscovered(ver, cluster, service);
@@ -98,6 +251,9 @@ ClusterWidget::ClusterWidget(const pg::PGVersion& v, const pg::PGCluster& c, QWi
 	, m_ui{ new Ui::ClusterWidget }
 	, m_version{ v }
 	, m_cluster{ c }
+	, m_watcher{ new QFileSystemWatcher{ this } }
+	, m_control{ new pg::ClusterControl{ v, c.path(), this } }
+	, m_entity{ EventLog::instance()->entity(EventLog::Cluster, c.path()) }
 {
 	m_ui->setupUi(this);
 	m_ui->port->setValidator(new QRegularExpressionValidator{
@@ -105,6 +261,19 @@ ClusterWidget::ClusterWidget(const pg::PGVersion& v, const pg::PGCluster& c, QWi
 
 	QObject::connect(m_ui->ctl, &QPushButton::clicked,
 		this, &ClusterWidget::clusterCtlPressed);
+	QObject::connect(m_control, &pg::ClusterControl::finished,
+		this, &ClusterWidget::controlFinished);
+	QObject::connect(m_watcher, &QFileSystemWatcher::fileChanged,
+		this, &ClusterWidget::updateState);
+	QObject::connect(m_watcher, &QFileSystemWatcher::directoryChanged,
+		this, &ClusterWidget::updateState);
+
+	// popup shows what index found, completer itself doesnt filter
+	auto completer = new QCompleter{ new QStringListModel{ this }, this };
+	completer->setCompletionMode(QCompleter::UnfilteredPopupCompletion);
+	m_ui->search->setCompleter(completer);
+	QObject::connect(m_ui->search, &QLineEdit::textEdited,
+		this, &ClusterWidget::searchParameters);
 	updateState();
 	QStringList pathStack{ m_cluster.pathJunction() };
 	if (pathStack.front() != m_cluster.path())
@@ -126,8 +295,12 @@ ClusterWidget::ClusterWidget(const pg::PGVersion& v, const pg::PGCluster& c, QWi
 	pathStack.push_front(m_cluster.path());
 	m_ui->path->setToolTip(pathStack.join(" -> "));
 
-	// todo: known issue, sometimes values comes with spaces on beginning of value
-	m_ui->port->setText(m_cluster.configuration()->get("port").value.trimmed());
+	m_ui->port->setText(QString::number(m_cluster.port()));
+}
+
+const pg::PGCluster& ClusterWidget::cluster() const
+{
+	return m_cluster;
 }
 
 int ClusterWidget::getState() const
@@ -136,33 +309,94 @@ int ClusterWidget::getState() const
 	{
 		switch (m_service->state())
 		{
-		case WmiService::Running:
+		case ServiceControl::Running:
 			return 3;
-		case WmiService::Unknown:
-		case WmiService::Stopped:
-		case WmiService::Paused:
-		case WmiService::StartPending:
-		case WmiService::StopPending:
-		case WmiService::ContinuePending:
-		case WmiService::PausePending:
+		case ServiceControl::Unknown:
+		case ServiceControl::Stopped:
+		case ServiceControl::Paused:
+		case ServiceControl::StartPending:
+		case ServiceControl::StopPending:
+		case ServiceControl::ContinuePending:
+		case ServiceControl::PausePending:
 			return 2;
 		};
 	}
-	return (m_cluster.running() ? 1 : 0);
+	return (m_cluster.running() ? 1 : m_cluster.crashed() ? 4 : 0);
 }
 
 void ClusterWidget::updateState()
 {
-	m_cluster.updateDatabaseState();
+	// cluster files are re-read only when changed, so idle tick costs liveness check and stats
+	if (m_cluster.updateDatabaseState() || m_styledState < 0)
+	{
+		const int state = m_cluster.running() ? ServiceControl::Running : ServiceControl::Stopped;
+		if (m_loggedState >= 0 && state != m_loggedState)
+			EventLog::instance()->append(m_entity, EventLog::Cluster, m_loggedState, state);
+		m_loggedState = state;
+		QStringList tip{ m_cluster.controlFile().describe() };
+		if (m_cluster.crashed())
+			tip.push_front("crashed / needs recovery");
+		tip.push_back(ServiceStatistics::summary(*ServiceStatistics::instance()->service(pg::ClusterControl::statisticsKey(m_cluster.path()))));
+		tip.push_back(m_lastControl);
+		tip.removeAll(QString{});
+		m_ui->ctlFrame->setToolTip(tip.join('\n'));
+		// readiness and real port come from postmaster.pid, edited port is kept while stopped
+		m_ui->status->setText(m_cluster.running() ? m_cluster.pidFile().statusName() : QString{});
+		if (m_cluster.running())
+			m_ui->port->setText(QString::number(m_cluster.port()));
+		const pg::pConfiguration conf = m_cluster.configuration();
+		if (conf->contains("port"))
+		{
+			const pg::Parameter port = conf->get("port");
+			m_ui->port->setToolTip(port.position.line != 0 ? QString{ "%1:%2" }.arg(port.file).arg(port.position.line) : port.file);
+		}
+		watch();
+	}
+	// service state comes from poller, so it is compared too
+	const int styled = getState();
+	if (styled == m_styledState)
+		return;
+	m_styledState = styled;
 	this->setStyleSheet(QString{});
 }
 
-void ClusterWidget::serviceDiscovered(const pg::PGVersion& v, const pg::PGCluster& c, pWmiService s)
+void ClusterWidget::searchParameters(const QString& text)
+{
+	QStringList entries;
+	const pg::pConfiguration conf = m_cluster.configuration();
+	if (conf != nullptr && !text.trimmed().isEmpty())
+	{
+		for (const auto& name : conf->search(text.trimmed(), 20))
+			entries.push_back(conf->contains(name) ? QString{ "%1 = %2" }.arg(name).arg(conf->get(name).value) : name);
+	}
+	QCompleter* completer = m_ui->search->completer();
+	static_cast<QStringListModel*>(completer->model())->setStringList(entries);
+	// completer reacted to same edit before model was refilled
+	if (!entries.isEmpty())
+		completer->complete();
+}
+
+void ClusterWidget::watch()
+{
+	const QString path = m_cluster.path();
+	QStringList paths{ path };
+	for (const char* file : { "global", "postmaster.pid", "postmaster.opts", "PG_VERSION", "global/pg_control" })
+		paths.push_back(QString{ "%1/%2" }.arg(path).arg(file));
+	paths.append(m_cluster.configuration()->files());
+	const QStringList watched = m_watcher->files() + m_watcher->directories();
+	paths.erase(std::remove_if(paths.begin(), paths.end(), [&watched](const QString& p) { return watched.contains(p) || !QFileInfo::exists(p); }),
+		paths.end());
+	if (!paths.isEmpty())
+		m_watcher->addPaths(paths);
+}
+
+void ClusterWidget::serviceDiscovered(const pg::PGVersion& v, const pg::PGCluster& c, pServiceControl s)
 {
 	if (v != m_version || c != m_cluster)
 		return;
 	m_service = s;
 	m_ui->serviceName->setText(m_service->name());
+	m_styledState = getState();
 	this->setStyleSheet(QString{});
 }
 
@@ -170,29 +404,22 @@ void ClusterWidget::clusterCtlPressed()
 {
 	if (m_service)
 		return toggleService();
-	WmiProcessStartupInfo si;
-	si.showWindow = WmiProcessStartupInfo::SW_NORMAL;
-	if (Settings::setup()->get("pg_hide_ctl_cmd", QVariant{ true }).toBool())
-		si.showWindow = WmiProcessStartupInfo::SW_HIDE;
-	QStringList args;
-	args
-		<< QString{ "%1%2" }.arg(m_version.binaryPath()).arg("pg_ctl.exe")
-		// << QString{ "-l e:\\pg_ctl.%1.log" }.arg(m_version.version())
-		<< "-D" << QString{ "\"%1\"" }.arg(m_cluster.path());
+	if (m_control->busy())
+		return;
+	m_ui->status->setText(QString::fromUtf8(m_cluster.running() ? "stopping…" : "starting…"));
 	if (m_cluster.running())
-		args << "-m fast stop";
+		m_control->stop();
 	else
-		args
-			<< "-o" << QString{ "\"-p %1 --lc_messages=en_us.utf8\"" }.arg(m_ui->port->text().toInt())
-			<< "start";
-	si.title = QString{ "PosgreSQL v%1 %2" }.arg(m_version.version()).arg(args.join(" "));
-	const QString bin =
-		// QString{ "cmd.exe @cmd /k \"chcp 1251 & %1\" & exit" }
-		QString{ "cmd.exe @cmd /k \"%1\" & exit" }
-			.arg(args.join(" ").replace("/", "\\"));
-	const QString path = m_version.binaryPath().replace("/", "\\");
-	if (WmiProcess::create(bin, path, &si) <= 0)
-		throw std::runtime_error{ "cannot execute pg_ctl command" };
+		m_control->start(m_ui->port->text().toInt());
+}
+
+void ClusterWidget::controlFinished(int operation, bool ok, qint64 ms, const QString& output)
+{
+	if (!ok)
+		qDebug() << "pg_ctl" << (operation == pg::ClusterControl::Start ? "start" : "stop") << m_cluster.path() << "failed in" << ms << "ms:" << output;
+	m_lastControl = ok ? QString{} : output;
+	m_styledState = -1; // forces tooltip and status refresh
+	updateState();
 }
 
 void ClusterWidget::toggleService()
@@ -201,20 +428,20 @@ void ClusterWidget::toggleService()
 	{
 		switch (m_service->state())
 		{
-		case WmiService::Stopped:
+		case ServiceControl::Stopped:
 			m_service->start();
 			break;
-		case WmiService::Running:
+		case ServiceControl::Running:
 			m_service->stop();
 			break;
-		case WmiService::Paused:
+		case ServiceControl::Paused:
 			m_service->resume();
 			break;
-		case WmiService::Unknown:
-		case WmiService::StartPending:
-		case WmiService::StopPending:
-		case WmiService::ContinuePending:
-		case WmiService::PausePending:
+		case ServiceControl::Unknown:
+		case ServiceControl::StartPending:
+		case ServiceControl::StopPending:
+		case ServiceControl::ContinuePending:
+		case ServiceControl::PausePending:
 			throw std::runtime_error("invalid service toggling state");
 		}
 	}
@@ -259,10 +486,13 @@ void PostgresWidget::addClusters(const pg::PGVersion& ver, const pg::PGCluster::
 	auto layout = m_ui->dbControl->layout();
 	for (const auto& cluster : clusters)
 	{
+		if (std::any_of(m_clusters.begin(), m_clusters.end(), [&cluster](const ClusterWidget* cw) { return cw->cluster() == cluster; }))
+			continue;
 		auto cw = new ClusterWidget{ ver, cluster, this };
 		QObject::connect(
-			m_parent->directoriesEnumerator(), &DirectoriesEnumerator::serviceDiscovered,
+			m_parent, &PostgresManager::serviceDiscovered,
 			cw, &ClusterWidget::serviceDiscovered);
+		m_parent->applyServices(cw);
 		QObject::connect(
 			m_parent, &PostgresManager::updateStates,
 			cw, &ClusterWidget::updateState);
@@ -271,13 +501,30 @@ void PostgresWidget::addClusters(const pg::PGVersion& ver, const pg::PGCluster::
 	}
 }
 
+void PostgresWidget::removeClusters(const QStringList& paths)
+{
+	for (auto it = m_clusters.begin(); it != m_clusters.end();)
+	{
+		if (!paths.contains((*it)->cluster().path()))
+		{
+			++it;
+			continue;
+		}
+		delete *it;
+		it = m_clusters.erase(it);
+	}
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 
 PostgresManager::PostgresManager(QWidget* parent)
 	: QFrame{ parent }
 	, m_ui{ new Ui::PostgresFrame }
 	, m_updateTimer{ new QTimer{ this } }
-	, m_enumerator{ new DirectoriesEnumerator }
+	, m_index{ std::make_shared<pg::ClusterIndex>() }
+	, m_discovery{ std::make_shared<DirectoriesEnumerator::Discovery>() }
+	, m_watcher{ new QFileSystemWatcher{ this } }
+	, m_refreshTimer{ new QTimer{ this } }
 {
 	m_ui->setupUi(this);
 
@@ -289,10 +536,13 @@ PostgresManager::PostgresManager(QWidget* parent)
 	if (!Settings::setup()->get("pg_dir").isValid())
 		throw std::runtime_error{ "no postgresql directory specified" };
 
-	m_enumerator->setAutoDelete(true);
-	QObject::connect(m_enumerator, &DirectoriesEnumerator::versionsEnumerated,
-		this, &PostgresManager::versionsEnumerated);
-	QThreadPool::globalInstance()->start(m_enumerator);
+	m_refreshing = true; // until first enumerator updates index
+	m_refreshTimer->setSingleShot(true);
+	m_refreshTimer->setInterval(1000);
+	QObject::connect(m_refreshTimer, &QTimer::timeout, this, &PostgresManager::refresh);
+	QObject::connect(m_watcher, &QFileSystemWatcher::directoryChanged,
+		m_refreshTimer, static_cast<void (QTimer::*)()>(&QTimer::start));
+	startEnumerator(false);
 
 	m_updateTimer->setInterval(1000);
 	QObject::connect(
@@ -306,11 +556,28 @@ PostgresManager::PostgresManager(QWidget* parent)
 PostgresManager::~PostgresManager()
 {
 	m_updateTimer->stop();
+	m_refreshTimer->stop();
+	// enumerators use registry and settings, they must be gone before those are released
+	m_discovery->cancel = true;
+	auto lock = std::unique_lock{ m_discovery->lock };
+	m_discovery->finished.wait(lock, [this]() { return m_discovery->running == 0; });
 }
 
-DirectoriesEnumerator* PostgresManager::directoriesEnumerator() const
+void PostgresManager::startEnumerator(bool refresh)
 {
-	return m_enumerator;
+	auto* enumerator = new DirectoriesEnumerator{ m_index, m_discovery, refresh };
+	enumerator->setAutoDelete(true);
+	QObject::connect(enumerator, &DirectoriesEnumerator::versionsEnumerated,
+		this, &PostgresManager::versionsEnumerated);
+	QObject::connect(enumerator, &DirectoriesEnumerator::directoriesEnumerated,
+		this, &PostgresManager::clustersFound);
+	QObject::connect(enumerator, &DirectoriesEnumerator::clustersRemoved,
+		this, &PostgresManager::clustersRemoved);
+	QObject::connect(enumerator, &DirectoriesEnumerator::serviceDiscovered,
+		this, &PostgresManager::onServiceDiscovered);
+	QObject::connect(enumerator, &DirectoriesEnumerator::indexUpdated,
+		this, &PostgresManager::indexUpdated);
+	QThreadPool::globalInstance()->start(enumerator);
 }
 
 void PostgresManager::versionsEnumerated(const pg::PGVersion::List& versions)
@@ -320,15 +587,62 @@ void PostgresManager::versionsEnumerated(const pg::PGVersion::List& versions)
 		throw std::runtime_error{ "must be existing layout" };
 	for (const auto& version : versions)
 	{
+		if (std::any_of(m_versions.begin(), m_versions.end(), [&version](PostgresWidget* pw) { return pw->version() == version; }))
+			continue;
 		auto pw = new PostgresWidget{ version, this };
-		QObject::connect(m_enumerator, &DirectoriesEnumerator::directoriesEnumerated,
+		QObject::connect(this, &PostgresManager::clustersFound,
 			pw, &PostgresWidget::addClusters);
+		QObject::connect(this, &PostgresManager::clustersRemoved,
+			pw, &PostgresWidget::removeClusters);
 		m_versions.emplace_back(pw);
 		layout->addWidget(pw);
 	}
-	if (m_versions.empty())
-		layout->addWidget(new PostgresNotFound{ this });
-	m_enumerator->awake();
+	if (m_notFound != nullptr && !m_versions.empty())
+		delete m_notFound, m_notFound = nullptr;
+}
+
+void PostgresManager::onServiceDiscovered(const pg::PGVersion& v, const pg::PGCluster& c, pServiceControl s)
+{
+	m_services.emplace_back(v, c, s);
+	emit serviceDiscovered(v, c, s);
+}
+
+void PostgresManager::applyServices(ClusterWidget* cw) const
+{
+	for (const auto& [v, c, s] : m_services)
+		cw->serviceDiscovered(v, c, s);
+}
+
+void PostgresManager::indexUpdated()
+{
+	m_refreshing = false;
+	if (m_versions.empty() && m_notFound == nullptr)
+	{ // whole discovery is over by now
+		m_notFound = new PostgresNotFound{ this };
+		m_ui->list->layout()->addWidget(m_notFound);
+	}
+	const QStringList paths = m_index->watched(Settings::setup()->get("pg_watch_limit", 1024).toInt());
+	const QStringList current = m_watcher->directories();
+	if (!current.isEmpty())
+		m_watcher->removePaths(current);
+	if (!paths.isEmpty())
+		m_watcher->addPaths(paths);
+	if (m_refreshAgain)
+	{
+		m_refreshAgain = false;
+		refresh();
+	}
+}
+
+void PostgresManager::refresh()
+{
+	if (m_refreshing)
+	{ // changes during walk are picked by next one
+		m_refreshAgain = true;
+		return;
+	}
+	m_refreshing = true;
+	startEnumerator(true);
 }
 
 ////////////////////////////////////////////////////////////////////////////////
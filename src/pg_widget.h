@@ -1,16 +1,27 @@
 #pragma once
+#include "pg_index.h"
 #include "pg_version.h"
 #include "wmi_service.h"
 
 #include <QFrame>
 #include <QRunnable>
 
+#include <atomic>
+#include <condition_variable>
 #include <mutex>
 #include <deque>
+#include <memory>
+#include <tuple>
+#include <vector>
 
 class Settings;
 class QTimer;
+class QFileSystemWatcher;
 class PostgresManager;
+namespace pg
+{
+	class ClusterControl;
+} /* namespace pg */
 namespace Ui
 {
 	class PostgresWidget;
@@ -25,21 +36,40 @@ class DirectoriesEnumerator : public QObject, public QRunnable
 {
 	Q_OBJECT
 public:
-	DirectoriesEnumerator();
-	void awake();
+	/** enumerators of one manager, cancelled and awaited by its destructor */
+	struct Discovery
+	{
+		std::atomic<bool> cancel{ false };
+		std::mutex lock;
+		std::condition_variable finished;
+		int running = 0;
+	};
+
+	/** pipeline: versions are probed on calling thread, their trees are walked by another one
+		and services are matched by third one, everything is emitted as soon as it is known.
+		clusters known from index go first, then only changed directories are walked.
+		refresh doesnt emit what is already known */
+	DirectoriesEnumerator(std::shared_ptr<pg::ClusterIndex>, std::shared_ptr<Discovery>, bool refresh = false);
+	~DirectoriesEnumerator();
 	void run() override;
 	void findPostgresServices();
 
 signals:
 	void versionsEnumerated(const pg::PGVersion::List&);
 	void directoriesEnumerated(const pg::PGVersion&, const pg::PGCluster::List&);
-	void serviceDiscovered(const pg::PGVersion&, const pg::PGCluster&, pWmiService);
+	void clustersRemoved(const QStringList& paths);
+	void serviceDiscovered(const pg::PGVersion&, const pg::PGCluster&, pServiceControl);
+	/** index is saved, walked directories may be watched */
+	void indexUpdated();
 
 private:
-	std::mutex m_ux;
-	bool m_continue{ false };
-	std::condition_variable m_waiter;
-	pg::PGVersion::List m_versions;
+	/** walks directory of install again, emits found clusters right away and vanished ones after walk */
+	void rescan(const pg::PGVersion&, const QString& directory);
+	bool cancelled() const;
+
+	const std::shared_ptr<pg::ClusterIndex> m_index;
+	const std::shared_ptr<Discovery> m_discovery;
+	const bool m_refresh;
 };
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -64,19 +94,31 @@ public:
 	ClusterWidget(const pg::PGVersion&, const pg::PGCluster&, QWidget* = nullptr);
 
 	int getState() const;
+	const pg::PGCluster& cluster() const;
 public slots:
 	void updateState();
-	void serviceDiscovered(const pg::PGVersion&, const pg::PGCluster&, pWmiService);
+	void serviceDiscovered(const pg::PGVersion&, const pg::PGCluster&, pServiceControl);
 	void clusterCtlPressed();
+	void controlFinished(int operation, bool ok, qint64 ms, const QString& output);
 
 protected:
 	void toggleService();
+	/** cluster files which exist now and directories where missing ones appear */
+	void watch();
+	/** fills completer of search box from configuration's parameter index */
+	void searchParameters(const QString&);
 
 protected:
 	Ui::ClusterWidget* m_ui{ nullptr };
 	pg::PGVersion m_version;
 	pg::PGCluster m_cluster;
-	pWmiService m_service;
+	pServiceControl m_service;
+	QFileSystemWatcher* m_watcher{ nullptr }; // changes are picked up before next tick
+	pg::ClusterControl* m_control{ nullptr };
+	QString m_lastControl; // output of failed pg_ctl
+	quint32 m_entity = 0; // EventLog id of cluster directory
+	int m_loggedState = -1;
+	int m_styledState = -1; // getState() stylesheet was applied for
 };
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -89,7 +131,9 @@ public:
 	pg::PGVersion& version();
 
 public slots:
+	/** clusters already shown are skipped */
 	void addClusters(const pg::PGVersion&, const pg::PGCluster::List&);
+	void removeClusters(const QStringList& paths);
 
 protected:
 	PostgresManager* m_parent{ nullptr };
@@ -105,20 +149,39 @@ class PostgresManager : public QFrame
 	Q_OBJECT
 public:
 	PostgresManager(QWidget* = nullptr);
+	/** cancels discovery and waits for it */
 	~PostgresManager();
 
-	DirectoriesEnumerator* directoriesEnumerator() const;
+	/** services discovered so far are given to new cluster widget */
+	void applyServices(ClusterWidget*) const;
 
 signals:
 	void updateStates();
+	// relayed from enumerators
+	void clustersFound(const pg::PGVersion&, const pg::PGCluster::List&);
+	void clustersRemoved(const QStringList& paths);
+	void serviceDiscovered(const pg::PGVersion&, const pg::PGCluster&, pServiceControl);
 protected slots:
 	void versionsEnumerated(const pg::PGVersion::List&);
+	void onServiceDiscovered(const pg::PGVersion&, const pg::PGCluster&, pServiceControl);
+	/** watches directories of index, changes are walked after short quiet period */
+	void indexUpdated();
+	void refresh();
+
+protected:
+	void startEnumerator(bool refresh);
 
 protected:
 	Ui::PostgresFrame* m_ui{ nullptr };
 	QTimer* m_updateTimer{ nullptr };
 	std::deque<PostgresWidget*> m_versions;
-	DirectoriesEnumerator* m_enumerator{ nullptr };
+	PostgresNotFound* m_notFound{ nullptr };
+	std::vector<std::tuple<pg::PGVersion, pg::PGCluster, pServiceControl>> m_services;
+	std::shared_ptr<pg::ClusterIndex> m_index;
+	std::shared_ptr<DirectoriesEnumerator::Discovery> m_discovery;
+	QFileSystemWatcher* m_watcher{ nullptr };
+	QTimer* m_refreshTimer{ nullptr };
+	bool m_refreshing{ false }, m_refreshAgain{ false };
 };
 
 ////////////////////////////////////////////////////////////////////////////////
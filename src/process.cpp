@@ -2,17 +2,121 @@
 #include "settings.h"
 #include "ui_processframe.h"
 #include "ui_processwidget.h"
+#include "ui_threadsframe.h"
 #include "statelabel.h"
+#include "flameview.h"
+#include "supervisor.h"
+#include "event_log.h"
+#include "service_control.h"
 
 #include <QJsonArray>
 #include <QPixmap>
 #include <QFileIconProvider>
 #include <QMetaMethod>
+#include <QTimer>
+#include <QGridLayout>
+#include <QThreadPool>
+#include <QStandardPaths>
+#include <QDateTime>
+#include <QDir>
+#include <QFileInfo>
+#include <QTextStream>
 
 #include <QDebug>
 
 ////////////////////////////////////////////////////////////////////////////////
 
+ThreadsView::ThreadsView(int pid, QWidget* parent)
+	: QFrame(parent)
+	, m_ui(new Ui::ThreadsFrame)
+	, m_timer(new QTimer{ this })
+	, m_sampler(std::make_shared<tool::ThreadSampler>(pid))
+{
+	m_ui->setupUi(this);
+	m_ui->threads->sortByColumn(2, Qt::DescendingOrder);
+	m_timer->setInterval(Settings::setup()->get("thread_sample_interval", 1000).toInt());
+	QObject::connect(m_timer, &QTimer::timeout, this, &ThreadsView::onSample);
+}
+
+ThreadsView::~ThreadsView()
+{
+	m_timer->stop();
+	delete m_ui, m_ui = nullptr;
+}
+
+void ThreadsView::showEvent(QShowEvent* e)
+{
+	QFrame::showEvent(e);
+	m_reset = true;
+	onSample();
+	m_timer->start();
+}
+
+void ThreadsView::hideEvent(QHideEvent* e)
+{
+	m_timer->stop();
+	QFrame::hideEvent(e);
+}
+
+void ThreadsView::onSample()
+{
+	if (m_sampling)
+		return;
+	m_sampling = true;
+	auto task = new tool::ThreadSampleTask{ m_sampler, m_reset };
+	m_reset = false;
+	task->setAutoDelete(true);
+	// queued, so results of view deleted meanwhile are dropped
+	QObject::connect(task, &tool::ThreadSampleTask::sampled,
+		this, &ThreadsView::onSampled, Qt::QueuedConnection);
+	QObject::connect(task, &tool::ThreadSampleTask::failed,
+		this, &ThreadsView::onSampleFailed, Qt::QueuedConnection);
+	QThreadPool::globalInstance()->start(task);
+}
+
+void ThreadsView::onSampleFailed(const QString& error)
+{
+	m_sampling = false;
+	qDebug() << "thread sampling failed: " << error;
+	m_timer->stop();
+}
+
+void ThreadsView::onSampled(const tool::ThreadSampler::List& threads)
+{
+	m_sampling = false;
+	std::map<quint64, QTreeWidgetItem*> items;
+	m_ui->threads->setSortingEnabled(false);
+	for (const auto& t : threads)
+	{
+		QTreeWidgetItem* item = nullptr;
+		auto it = m_items.find(t.tid);
+		if (it != m_items.end())
+		{
+			item = it->second;
+			m_items.erase(it);
+		}
+		else
+		{
+			item = new QTreeWidgetItem{ m_ui->threads };
+			item->setData(0, Qt::DisplayRole, t.tid);
+		}
+		item->setText(1, t.state);
+		item->setData(2, Qt::DisplayRole, qRound(t.cpu * 10.) / 10.);
+		if (t.switchRate < 0)
+			item->setText(3, QString{ "n/a" });
+		else
+			item->setData(3, Qt::DisplayRole, qRound(t.switchRate));
+		items.insert({ t.tid, item });
+	}
+	// threads left in previous map are gone
+	for (auto& gone : m_items)
+		delete gone.second;
+	m_items.swap(items);
+	m_ui->threads->setSortingEnabled(true);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
 ProcessWidget::ProcessWidget(QWidget* parent)
 	: QWidget(parent)
 	, m_ui(new Ui::ProcessWidget)
@@ -20,16 +124,21 @@ ProcessWidget::ProcessWidget(QWidget* parent)
 	m_ui->setupUi(this);
 
 	m_ui->closeProcess->setToolTip("Destroy Process");
-	m_ui->attachDebugger->setToolTip("Attach Debugger");
+	m_ui->profile->setToolTip(QString{ "Profile %1s" }
+								  .arg(Settings::setup()->get("profile_duration", 10000).toInt() / 1000));
+	m_ui->threads->setToolTip("Threads");
 	m_ui->mem->setToolTip("WorkingSetSize");
 	m_ui->mem->setVisible(false); // disabled for time
 
 	QObject::connect(m_ui->closeProcess,
 		SIGNAL(clicked()),
 		SLOT(onKillProcess()));
-	QObject::connect(m_ui->attachDebugger,
+	QObject::connect(m_ui->profile,
 		SIGNAL(clicked()),
-		SLOT(onAttachDebugger()));
+		SLOT(onProfile()));
+	QObject::connect(m_ui->threads,
+		SIGNAL(toggled(bool)),
+		SLOT(onThreadsToggled(bool)));
 }
 
 ProcessWidget::~ProcessWidget()
@@ -49,6 +158,12 @@ void ProcessWidget::setExecutablePath(const QString& e)
 	m_ui->ico->setPixmap(ico.pixmap(QSize{ 16, 16 }));
 }
 
+void ProcessWidget::setSupervision(const QString& status)
+{
+	m_ui->supervision->setText(status);
+	m_ui->supervision->setVisible(!status.isEmpty());
+}
+
 void ProcessWidget::setProcessID(int id)
 {
 	m_pid = id;
@@ -59,9 +174,33 @@ void ProcessWidget::onKillProcess()
 	emit killProcess(m_pid);
 }
 
-void ProcessWidget::onAttachDebugger()
+void ProcessWidget::onProfile()
+{
+	m_ui->profile->setEnabled(false);
+	emit profileProcess(m_pid);
+}
+
+void ProcessWidget::onProfileFinished(int pid)
 {
-	emit attachDebugger(m_pid);
+	if (m_pid != pid)
+		return;
+	m_ui->profile->setEnabled(true);
+}
+
+void ProcessWidget::onThreadsToggled(bool checked)
+{
+	if (checked && m_threads == nullptr)
+	{
+		m_threads = new ThreadsView{ m_pid, this };
+		static_cast<QGridLayout*>(layout())->addWidget(m_threads, 1, 0);
+	}
+	if (!checked && m_threads != nullptr)
+	{
+		// drop sampler with its history, drill-down is rarely reopened
+		delete m_threads, m_threads = nullptr;
+	}
+	adjustSize();
+	emit expanded(checked);
 }
 
 void ProcessWidget::onMemoryChanged(int pid, int workset)
@@ -76,6 +215,7 @@ void ProcessWidget::onMemoryChanged(int pid, int workset)
 ProcessManager::ProcessManager(Settings* s, QWidget* parent)
 	: QFrame(parent)
 	, m_ui(new Ui::ProcessMainFrame)
+	, m_cancelProfiling(std::make_shared<std::atomic_bool>(false))
 {
 	m_ui->setupUi(this);
 	QJsonObject& params = s->params();
@@ -85,14 +225,22 @@ ProcessManager::ProcessManager(Settings* s, QWidget* parent)
 	for (const auto& v : params.value("process").toArray())
 		m_watchableProcess.push_back(v.toString());
 
+	if (!params.contains("supervise") || !params.value("supervise").isArray())
+		params.insert("supervise", QJsonArray{});
+	m_supervisor = new ProcessSupervisor{ params.value("supervise").toArray(), this };
+	for (const auto& pattern : m_supervisor->patterns())
+		if (!m_watchableProcess.contains(pattern))
+			m_watchableProcess.push_back(pattern);
+
 	QObject::connect(this,
 		SIGNAL(watchableProcess(const WmiProcess&)),
 		SLOT(onWatchableProcess(const WmiProcess&)),
 		Qt::QueuedConnection);
 
 	QObject::connect(this,
-		SIGNAL(diedProcess(int)),
-		SLOT(onProcessDied(int)));
+		SIGNAL(diedProcess(int, const QString&)),
+		SLOT(onProcessDied(int, const QString&)),
+		Qt::QueuedConnection);
 
 	m_ui->proclist->setSelectionMode(QAbstractItemView::NoSelection);
 	m_thread = std::thread(&ProcessManager::notifierThread, this);
@@ -100,6 +248,7 @@ ProcessManager::ProcessManager(Settings* s, QWidget* parent)
 
 ProcessManager::~ProcessManager()
 {
+	*m_cancelProfiling = true;
 	m_lock.lock();
 	m_stopThread = true;
 	m_lock.unlock();
@@ -107,18 +256,42 @@ ProcessManager::~ProcessManager()
 		m_thread.join();
 }
 
+quint32 ProcessManager::entity(const QString& processName)
+{
+	auto it = m_entities.find(processName);
+	if (it == m_entities.end())
+		it = m_entities.emplace(processName, EventLog::instance()->entity(EventLog::Process, processName)).first;
+	return it->second;
+}
+
 void ProcessManager::onWatchableProcess(const WmiProcess& p)
 {
+	m_supervisor->processAppeared(p.processID(), p.processName());
+	EventLog::instance()->append(entity(p.processName()),
+		EventLog::Process, ServiceControl::Stopped, ServiceControl::Running);
+	// rows left from crash loop are replaced by the new instance
+	for (int row = m_ui->proclist->count() - 1; row >= 0; --row)
+	{
+		QListWidgetItem* stale = m_ui->proclist->item(row);
+		if (stale->data(Qt::UserRole).toInt() < 0 && stale->data(Qt::UserRole + 1).toString() == p.processName())
+			delete m_ui->proclist->takeItem(row);
+	}
+
 	auto* item = new QListWidgetItem(m_ui->proclist);
 	auto* widget = new ProcessWidget(this);
 	item->setData(Qt::UserRole, p.processID());
+	item->setData(Qt::UserRole + 1, p.processName());
 	widget->setProcessName(p.processName());
 	widget->setExecutablePath(p.executablePath());
 	widget->setProcessID(p.processID());
+	widget->setSupervision(m_supervisor->status(p.processName()));
 	QObject::connect(widget, SIGNAL(killProcess(int)), this, SLOT(onKillProcess(int)));
-	QObject::connect(widget, SIGNAL(attachDebugger(int)), this, SLOT(onAttachDebugger(int)));
+	QObject::connect(widget, SIGNAL(profileProcess(int)), this, SLOT(onProfileProcess(int)));
+	QObject::connect(this, SIGNAL(profileFinished(int)), widget, SLOT(onProfileFinished(int)));
 	QObject::connect(this, SIGNAL(memoryChanged(int, int)),
 		widget, SLOT(onMemoryChanged(int, int)));
+	QObject::connect(widget, &ProcessWidget::expanded,
+		this, [item, widget](bool) { item->setSizeHint(widget->sizeHint()); });
 
 	widget->setToolTip(
 		QString{ "%1\n%2" }
@@ -128,13 +301,29 @@ void ProcessManager::onWatchableProcess(const WmiProcess& p)
 	m_ui->proclist->setItemWidget(item, widget);
 }
 
-void ProcessManager::onProcessDied(int procID)
+void ProcessManager::onProcessDied(int procID, const QString& name)
 {
+	// restart goes first, row bookkeeping can wait
+	m_supervisor->processDied(procID, name);
+	EventLog::instance()->append(entity(name),
+		EventLog::Process, ServiceControl::Running, ServiceControl::Stopped);
+	const bool crashLoop = (m_supervisor->status(name) == QString{ "crash loop" });
 	for (int row = 0; row != m_ui->proclist->count(); ++row)
 	{
 		QListWidgetItem* item = m_ui->proclist->item(row);
 		if (item->data(Qt::UserRole).toInt() == procID)
 		{
+			if (crashLoop)
+			{ // keep row to show what happened
+				auto* widget = qobject_cast<ProcessWidget*>(m_ui->proclist->itemWidget(item));
+				item->setData(Qt::UserRole, -1);
+				if (widget != nullptr)
+				{
+					widget->setSupervision(QString{ "crash loop" });
+					widget->setEnabled(false);
+				}
+				return;
+			}
 			item = m_ui->proclist->takeItem(row);
 			delete item;
 			return;
@@ -148,16 +337,67 @@ void ProcessManager::onKillProcess(int id)
 	auto it = m_watchable.find(id);
 	if (it == m_watchable.end())
 		return;
+	m_supervisor->ignoreDeath(id);
 	it->second.terminate();
 }
 
-void ProcessManager::onAttachDebugger(int id)
+void ProcessManager::onProfileProcess(int id)
 {
-	auto lock = std::lock_guard{ m_lock };
-	auto it = m_watchable.find(id);
-	if (it == m_watchable.end())
-		return;
-	it->second.attachDebugger();
+	QString name;
+	{
+		auto lock = std::lock_guard{ m_lock };
+		auto it = m_watchable.find(id);
+		if (it == m_watchable.end())
+			return;
+		name = it->second.processName();
+	}
+	Settings* setup = Settings::setup();
+	tool::StackSampler::Options options;
+	options.duration = setup->get("profile_duration", 10000).toInt();
+	options.rate = setup->get("profile_rate", 49).toInt();
+	options.maxDepth = setup->get("profile_depth", 128).toInt();
+	options.maxNodes = static_cast<size_t>(setup->get("profile_nodes", 65536).toInt());
+
+	auto task = new tool::ProfileTask{ id, options, name, m_cancelProfiling };
+	task->setAutoDelete(true);
+	QObject::connect(task, &tool::ProfileTask::finished,
+		this, &ProcessManager::onProfileReady, Qt::QueuedConnection);
+	QObject::connect(task, &tool::ProfileTask::failed,
+		this, &ProcessManager::onProfileFailed, Qt::QueuedConnection);
+	QThreadPool::globalInstance()->start(task);
+}
+
+void ProcessManager::onProfileReady(int id, tool::pProfile profile)
+{
+	emit profileFinished(id);
+	QDir dir{ QFileInfo{ Settings::setup()->configPath() }.absolutePath() };
+	dir.mkpath("profiles");
+	QFile folded{ dir.absoluteFilePath(QString{ "profiles/%1.%2.%3.folded" }
+											.arg(profile->frames.front().name)
+											.arg(id)
+											.arg(QDateTime::currentDateTime().toString("yyyyMMdd-hhmmss"))) };
+	if (folded.open(QIODevice::WriteOnly | QIODevice::Text | QIODevice::Truncate))
+	{
+		QTextStream out{ &folded };
+		profile->writeFolded(out);
+		folded.close();
+		qInfo() << "profile written" << folded.fileName();
+	}
+	else
+		qWarning() << "cannot write profile" << folded.fileName();
+	if (profile->overhead > 0.05)
+		qWarning() << "profiling stopped threads for" << profile->overhead * 100. << "% of time, lower profile_rate";
+
+	auto* view = new FlameView{ profile };
+	view->setAttribute(Qt::WA_DeleteOnClose);
+	view->setWindowFlags(Qt::Tool | Qt::WindowStaysOnTopHint);
+	view->show();
+}
+
+void ProcessManager::onProfileFailed(int id, const QString& error)
+{
+	emit profileFinished(id);
+	qWarning() << "profiling of" << id << "failed:" << error;
 }
 
 void ProcessManager::monitorWatchableCreate()
@@ -185,16 +425,19 @@ void ProcessManager::monitorWatchableCreate()
 				m_watchable.insert({ procID, proc });
 				repeatedIds.insert(procID);
 				emit watchableProcess(proc);
+				break;
 			}
 		}
 	}
-	for (auto it = m_watchable.begin(); it != m_watchable.end(); ++it)
+	for (auto it = m_watchable.begin(); it != m_watchable.end();)
 	{
 		if (repeatedIds.find(it->first) == repeatedIds.end())
 		{
-			emit diedProcess(it->first);
+			emit diedProcess(it->first, it->second.processName());
 			it = m_watchable.erase(it);
+			continue;
 		}
+		++it;
 		// else
 		// {
 		// it->second.updateObject();
@@ -1,20 +1,58 @@
 #pragma once
 #include "wmi_process.h"
+#include "thread_sampler.h"
+#include "profiler.h"
+#include <map>
+#include <memory>
 #include <mutex>
 #include <thread>
 
 #include <QFrame>
 
 class Settings;
+class ProcessSupervisor;
+class QTimer;
+class QTreeWidgetItem;
 namespace Ui
 {
 	class ProcessMainFrame;
 	class ProcessWidget;
+	class ThreadsFrame;
 
 } /* namespace Ui */
 
 ////////////////////////////////////////////////////////////////////////////////
 
+/** per-thread drill-down of a watched process, samples only while visible */
+class ThreadsView
+	: public QFrame
+{
+	Q_OBJECT
+public:
+	ThreadsView(int pid, QWidget* = nullptr);
+	~ThreadsView();
+
+protected slots:
+	/** queues sample to thread pool, unless previous one is still running */
+	void onSample();
+	void onSampled(const tool::ThreadSampler::List&);
+	void onSampleFailed(const QString&);
+
+protected:
+	void showEvent(QShowEvent*) override;
+	void hideEvent(QHideEvent*) override;
+
+protected:
+	Ui::ThreadsFrame* m_ui = nullptr;
+	QTimer* m_timer = nullptr;
+	std::shared_ptr<tool::ThreadSampler> m_sampler; // shared with running task, view may go first
+	bool m_sampling = false;
+	bool m_reset = false; // next sample starts over, as after hide
+	std::map<quint64, QTreeWidgetItem*> m_items;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+
 class ProcessWidget
 	: public QWidget
 {
@@ -26,19 +64,24 @@ public:
 	void setProcessID(int);
 	void setProcessName(const QString&);
 	void setExecutablePath(const QString&);
+	void setSupervision(const QString&);
 
 public slots:
 	void onMemoryChanged(int, int);
+	void onProfileFinished(int);
 
 signals:
 	void killProcess(int);
-	void attachDebugger(int);
+	void profileProcess(int);
+	void expanded(bool);
 protected slots:
 	void onKillProcess();
-	void onAttachDebugger();
+	void onProfile();
+	void onThreadsToggled(bool);
 
 protected:
 	Ui::ProcessWidget* m_ui = nullptr;
+	ThreadsView* m_threads = nullptr;
 	int m_pid = 0;
 };
 
@@ -54,18 +97,23 @@ public:
 
 signals:
 	void watchableProcess(const WmiProcess&);
-	void diedProcess(int);
+	void diedProcess(int, const QString&);
 	void memoryChanged(int, int);
+	void profileFinished(int);
 
 protected slots:
 	void onWatchableProcess(const WmiProcess&);
-	void onProcessDied(int);
+	void onProcessDied(int, const QString&);
 	void onKillProcess(int);
-	void onAttachDebugger(int);
+	void onProfileProcess(int);
+	void onProfileReady(int, tool::pProfile);
+	void onProfileFailed(int, const QString&);
 
 protected:
 	void notifierThread();
 	void monitorWatchableCreate();
+	/** EventLog id of process name, looked up once per name */
+	quint32 entity(const QString& processName);
 
 protected:
 	Ui::ProcessMainFrame* m_ui = nullptr;
@@ -73,8 +121,11 @@ protected:
 	std::thread m_thread;
 	bool m_stopThread = false;
 	QStringList m_watchableProcess;
+	std::shared_ptr<std::atomic_bool> m_cancelProfiling;
+	ProcessSupervisor* m_supervisor = nullptr;
 
 	std::map<int, WmiProcess> m_watchable;
+	std::map<QString, quint32> m_entities; // gui thread only
 };
 
 ////////////////////////////////////////////////////////////////////////////////
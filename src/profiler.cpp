@@ -0,0 +1,426 @@
+#include "profiler.h"
+
+#include <QFile>
+#include <QFileInfo>
+#include <QStringList>
+#include <QTextStream>
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <stdexcept>
+#include <thread>
+#include <unordered_map>
+
+#ifdef Q_OS_WIN
+#	define VC_EXTRALEAN
+#	define WIN32_LEAN_AND_MEAN
+#	include <windows.h>
+#	include <tlhelp32.h>
+#	include <dbghelp.h>
+#	pragma comment(lib, "dbghelp.lib")
+#else
+#	include <cerrno>
+#	include <dirent.h>
+#	include <elf.h>
+#	include <sys/ptrace.h>
+#	include <sys/uio.h>
+#	include <sys/user.h>
+#	include <sys/wait.h>
+#	include <unistd.h>
+#endif
+
+namespace tool
+{
+	////////////////////////////////////////////////////////////////////////////////
+
+	StackTrie::StackTrie(size_t maxNodes)
+		: m_maxNodes(std::max<size_t>(maxNodes, 2))
+	{
+		size_t capacity = 16;
+		while (capacity < m_maxNodes * 2) // keep load factor under 0.5
+			capacity <<= 1;
+		m_table.assign(capacity, root); // root is never a child, so it marks empty slot
+		m_nodes.reserve(m_maxNodes);
+		m_nodes.push_back(Node{ 0, root, 0, 0 });
+	}
+
+	quint32 StackTrie::child(quint32 parent, quint64 frame)
+	{
+		quint64 h = (frame * 0x9E3779B97F4A7C15ull) ^ (parent * 0xC2B2AE3D27D4EB4Full);
+		h ^= (h >> 29);
+		const size_t mask = m_table.size() - 1;
+		size_t idx = static_cast<size_t>(h) & mask;
+		while (m_table[idx] != root)
+		{
+			const Node& n = m_nodes[m_table[idx]];
+			if (n.parent == parent && n.frame == frame)
+				return m_table[idx];
+			idx = (idx + 1) & mask;
+		}
+		if (m_nodes.size() >= m_maxNodes)
+			return root;
+		const quint32 node = static_cast<quint32>(m_nodes.size());
+		m_nodes.push_back(Node{ frame, parent, 0, 0 });
+		m_table[idx] = node;
+		return node;
+	}
+
+	void StackTrie::add(const quint64* frames, size_t count)
+	{
+		quint32 node = root;
+		++m_nodes[root].total;
+		for (size_t i = 0; i != count; ++i)
+		{
+			const quint32 next = child(node, frames[i]);
+			if (next == root)
+			{ // sample is accounted to the deepest known frame
+				++m_truncated;
+				break;
+			}
+			node = next;
+			++m_nodes[node].total;
+		}
+		++m_nodes[node].self;
+	}
+
+	const std::vector<StackTrie::Node>& StackTrie::nodes() const
+	{
+		return m_nodes;
+	}
+
+	quint32 StackTrie::samples() const
+	{
+		return m_nodes[root].total;
+	}
+
+	quint32 StackTrie::truncated() const
+	{
+		return m_truncated;
+	}
+
+	////////////////////////////////////////////////////////////////////////////////
+
+	void Profile::writeFolded(QTextStream& stream) const
+	{
+		QStringList path;
+		for (size_t idx = 1; idx < frames.size(); ++idx)
+		{
+			if (frames[idx].self == 0)
+				continue;
+			path.clear();
+			for (quint32 n = static_cast<quint32>(idx); n != StackTrie::root; n = frames[n].parent)
+				path.push_front(frames[n].name);
+			stream << path.join(';') << ' ' << frames[idx].self << endl;
+		}
+	}
+
+	////////////////////////////////////////////////////////////////////////////////
+
+#ifdef Q_OS_WIN
+	struct StackSampler::impl
+	{
+		HANDLE process = nullptr;
+		bool symbols = false;
+		std::vector<quint64> stack;
+	};
+#else
+	struct StackSampler::impl
+	{
+		struct Mapping
+		{
+			quint64 begin, end, offset;
+			QString path;
+		};
+		std::vector<Mapping> maps;
+		std::vector<quint64> stack;
+		bool attached = false;
+
+		void readMaps(int pid)
+		{
+			QFile file{ QString{ "/proc/%1/maps" }.arg(pid) };
+			if (!file.open(QIODevice::ReadOnly | QIODevice::Text))
+				return;
+			maps.clear();
+			while (!file.atEnd())
+			{
+				// 7f1c2a000000-7f1c2a021000 r-xp 00000000 08:01 1234 /usr/lib/libc.so.6
+				const QList<QByteArray> fields = file.readLine().simplified().split(' ');
+				if (fields.size() < 6 || !fields[1].contains('x'))
+					continue;
+				const QList<QByteArray> range = fields[0].split('-');
+				if (range.size() != 2)
+					continue;
+				maps.push_back(Mapping{ range[0].toULongLong(nullptr, 16), range[1].toULongLong(nullptr, 16),
+					fields[2].toULongLong(nullptr, 16), QFileInfo{ QString::fromLocal8Bit(fields[5]) }.fileName() });
+			}
+			file.close();
+		}
+	};
+#endif
+
+	StackSampler::StackSampler(int pid, const Options& o)
+		: m_pid(pid)
+		, m_options(o)
+		, m_trie(o.maxNodes)
+		, m_impl(new impl)
+	{
+		m_impl->stack.reserve(static_cast<size_t>(std::max(o.maxDepth, 1)));
+#ifdef Q_OS_WIN
+		m_impl->process = ::OpenProcess(PROCESS_QUERY_INFORMATION | PROCESS_VM_READ, FALSE, static_cast<DWORD>(pid));
+		if (m_impl->process == nullptr)
+			throw std::runtime_error{ "cannot open process for profiling" };
+		::SymSetOptions(SYMOPT_UNDNAME | SYMOPT_DEFERRED_LOADS);
+		m_impl->symbols = (::SymInitialize(m_impl->process, nullptr, TRUE) != FALSE);
+#else
+		m_impl->readMaps(pid);
+#endif
+	}
+
+	StackSampler::~StackSampler()
+	{
+#ifdef Q_OS_WIN
+		if (m_impl->symbols)
+			::SymCleanup(m_impl->process);
+		::CloseHandle(m_impl->process);
+#endif
+	}
+
+	Profile StackSampler::run(const std::atomic_bool& cancel)
+	{
+		using clock = std::chrono::steady_clock;
+		const auto period = std::chrono::microseconds(1000000 / std::max(m_options.rate, 1)),
+				   duration = std::chrono::microseconds(m_options.duration * 1000ll);
+		const auto start = clock::now();
+		auto next = start;
+		while (!cancel && clock::now() - start < duration)
+		{
+			sample();
+			++m_ticks;
+			next += period;
+			std::this_thread::sleep_until(next);
+		}
+#ifndef Q_OS_WIN
+		if (!m_impl->attached)
+			throw std::runtime_error{ "cannot attach to process (check ptrace permissions)" };
+		m_impl->readMaps(m_pid); // libraries may be loaded while sampling
+#endif
+
+		Profile result;
+		result.elapsed = std::chrono::duration<double>(clock::now() - start).count();
+		result.truncated = m_trie.truncated();
+		// every thread runs elapsed seconds, of which it was stopped m_stopped / threads
+		if (m_stops != 0 && result.elapsed > 0.)
+			result.overhead = std::chrono::duration<double>(m_stopped).count() * m_ticks / m_stops / result.elapsed;
+		const auto& nodes = m_trie.nodes();
+		result.frames.reserve(nodes.size());
+		std::unordered_map<quint64, QString> names;
+		for (const auto& node : nodes)
+		{
+			auto it = names.find(node.frame);
+			if (it == names.end())
+				it = names.insert({ node.frame, symbol(node.frame) }).first;
+			result.frames.push_back(Profile::Frame{ it->second, node.parent, node.total, node.self });
+		}
+		result.frames.front().name = QString{ "all" };
+		return result;
+	}
+
+#ifdef Q_OS_WIN
+	void StackSampler::sample()
+	{
+		HANDLE snapshot = ::CreateToolhelp32Snapshot(TH32CS_SNAPTHREAD, 0);
+		if (snapshot == INVALID_HANDLE_VALUE)
+			return;
+		THREADENTRY32 te;
+		te.dwSize = sizeof(THREADENTRY32);
+		auto& stack = m_impl->stack;
+		for (BOOL more = ::Thread32First(snapshot, &te); more; more = ::Thread32Next(snapshot, &te))
+		{
+			if (te.th32OwnerProcessID != static_cast<DWORD>(m_pid))
+				continue;
+			HANDLE thread = ::OpenThread(THREAD_SUSPEND_RESUME | THREAD_GET_CONTEXT | THREAD_QUERY_INFORMATION, FALSE, te.th32ThreadID);
+			if (thread == nullptr)
+				continue;
+			const auto suspended = std::chrono::steady_clock::now();
+			if (::SuspendThread(thread) == static_cast<DWORD>(-1))
+			{
+				::CloseHandle(thread);
+				continue;
+			}
+			stack.clear();
+			CONTEXT context;
+			std::memset(&context, 0, sizeof(context));
+			context.ContextFlags = CONTEXT_FULL;
+			if (::GetThreadContext(thread, &context))
+			{
+				STACKFRAME64 frame;
+				std::memset(&frame, 0, sizeof(frame));
+#	ifdef _M_X64
+				const DWORD machine = IMAGE_FILE_MACHINE_AMD64;
+				frame.AddrPC.Offset = context.Rip;
+				frame.AddrFrame.Offset = context.Rbp;
+				frame.AddrStack.Offset = context.Rsp;
+#	else
+				const DWORD machine = IMAGE_FILE_MACHINE_I386;
+				frame.AddrPC.Offset = context.Eip;
+				frame.AddrFrame.Offset = context.Ebp;
+				frame.AddrStack.Offset = context.Esp;
+#	endif
+				frame.AddrPC.Mode = frame.AddrFrame.Mode = frame.AddrStack.Mode = AddrModeFlat;
+				// unwind tables are used where frame pointers are omitted
+				while (stack.size() < static_cast<size_t>(m_options.maxDepth)
+					&& ::StackWalk64(machine, m_impl->process, thread, &frame, &context,
+						nullptr, ::SymFunctionTableAccess64, ::SymGetModuleBase64, nullptr))
+				{
+					if (frame.AddrPC.Offset == 0)
+						break;
+					stack.push_back(frame.AddrPC.Offset);
+				}
+			}
+			::ResumeThread(thread);
+			m_stopped += std::chrono::steady_clock::now() - suspended;
+			++m_stops;
+			::CloseHandle(thread);
+			std::reverse(stack.begin(), stack.end());
+			m_trie.add(stack.data(), stack.size());
+		}
+		::CloseHandle(snapshot);
+	}
+
+	QString StackSampler::symbol(quint64 address)
+	{
+		if (address == 0)
+			return QString{};
+		QString module{ "?" };
+		IMAGEHLP_MODULE64 mi;
+		std::memset(&mi, 0, sizeof(mi));
+		mi.SizeOfStruct = sizeof(mi);
+		if (m_impl->symbols && ::SymGetModuleInfo64(m_impl->process, address, &mi))
+			module = QString::fromLocal8Bit(mi.ModuleName);
+
+		char buffer[sizeof(SYMBOL_INFO) + MAX_SYM_NAME];
+		SYMBOL_INFO* info = reinterpret_cast<SYMBOL_INFO*>(buffer);
+		std::memset(info, 0, sizeof(SYMBOL_INFO));
+		info->SizeOfStruct = sizeof(SYMBOL_INFO);
+		info->MaxNameLen = MAX_SYM_NAME;
+		DWORD64 displacement = 0;
+		if (m_impl->symbols && ::SymFromAddr(m_impl->process, address, &displacement, info))
+			return QString{ "%1!%2" }.arg(module).arg(QString::fromLocal8Bit(info->Name)).replace(';', ':');
+		if (mi.BaseOfImage != 0)
+			return QString{ "%1+0x%2" }.arg(module).arg(address - mi.BaseOfImage, 0, 16);
+		return QString{ "0x%1" }.arg(address, 0, 16);
+	}
+#else
+	void StackSampler::sample()
+	{
+		DIR* dir = ::opendir(QString{ "/proc/%1/task" }.arg(m_pid).toLocal8Bit().constData());
+		if (dir == nullptr)
+			return;
+		std::vector<pid_t> tids;
+		while (dirent* entry = ::readdir(dir))
+			if (entry->d_name[0] >= '0' && entry->d_name[0] <= '9')
+				tids.push_back(static_cast<pid_t>(std::atol(entry->d_name)));
+		::closedir(dir);
+
+		auto& stack = m_impl->stack;
+		for (const pid_t tid : tids)
+		{
+			// seize + interrupt stops only this thread, others keep running
+			if (::ptrace(PTRACE_SEIZE, tid, nullptr, nullptr) != 0)
+				continue;
+			m_impl->attached = true;
+			const auto interrupted = std::chrono::steady_clock::now();
+			if (::ptrace(PTRACE_INTERRUPT, tid, nullptr, nullptr) != 0)
+			{
+				::ptrace(PTRACE_DETACH, tid, nullptr, nullptr);
+				continue;
+			}
+			int status = 0;
+			pid_t waited = 0;
+			do
+				waited = ::waitpid(tid, &status, __WALL);
+			while (waited < 0 && errno == EINTR);
+			if (waited != tid || !WIFSTOPPED(status))
+			{ // thread exited meanwhile, or wait failed and it mustnt stay traced
+				::ptrace(PTRACE_DETACH, tid, nullptr, nullptr);
+				continue;
+			}
+			// signal-delivery stop instead of interrupt: signal is reinjected on detach
+			const long signal = ((status >> 16) == PTRACE_EVENT_STOP ? 0 : WSTOPSIG(status));
+
+			stack.clear();
+			user_regs_struct regs;
+			iovec io{ &regs, sizeof(regs) };
+			if (::ptrace(PTRACE_GETREGSET, tid, reinterpret_cast<void*>(NT_PRSTATUS), &io) == 0)
+			{
+#	if defined(__x86_64__)
+				quint64 pc = regs.rip, fp = regs.rbp;
+#	elif defined(__aarch64__)
+				quint64 pc = regs.pc, fp = regs.regs[29];
+#	else
+				quint64 pc = 0, fp = 0;
+#	endif
+				if (pc != 0)
+					stack.push_back(pc);
+				// frame record: [fp] = caller's fp, [fp + 8] = return address
+				while (fp != 0 && (fp & 7) == 0 && stack.size() < static_cast<size_t>(m_options.maxDepth))
+				{
+					quint64 record[2] = { 0, 0 };
+					iovec local{ record, sizeof(record) }, remote{ reinterpret_cast<void*>(fp), sizeof(record) };
+					if (::process_vm_readv(m_pid, &local, 1, &remote, 1, 0) != static_cast<ssize_t>(sizeof(record)))
+						break;
+					if (record[1] == 0)
+						break;
+					stack.push_back(record[1]);
+					if (record[0] <= fp) // stack grows down, callers are above
+						break;
+					fp = record[0];
+				}
+			}
+			::ptrace(PTRACE_DETACH, tid, nullptr, reinterpret_cast<void*>(signal));
+			m_stopped += std::chrono::steady_clock::now() - interrupted;
+			++m_stops;
+			std::reverse(stack.begin(), stack.end());
+			m_trie.add(stack.data(), stack.size());
+		}
+	}
+
+	QString StackSampler::symbol(quint64 address)
+	{
+		if (address == 0)
+			return QString{};
+		for (const auto& m : m_impl->maps)
+			if (address >= m.begin && address < m.end)
+				return QString{ "%1+0x%2" }.arg(m.path).arg(address - m.begin + m.offset, 0, 16).replace(';', ':');
+		return QString{ "0x%1" }.arg(address, 0, 16);
+	}
+#endif
+
+	////////////////////////////////////////////////////////////////////////////////
+
+	ProfileTask::ProfileTask(int pid, const StackSampler::Options& o, const QString& name, std::shared_ptr<std::atomic_bool> cancel)
+		: m_pid(pid)
+		, m_options(o)
+		, m_name(name)
+		, m_cancel(cancel)
+	{}
+
+	void ProfileTask::run()
+	{
+		try
+		{
+			StackSampler sampler{ m_pid, m_options };
+			auto profile = std::make_shared<Profile>(sampler.run(*m_cancel));
+			profile->title = QString{ "%1 (%2), threads stopped %3%" }.arg(m_name).arg(m_pid).arg(profile->overhead * 100., 0, 'f', 2);
+			profile->frames.front().name = m_name;
+			emit finished(m_pid, profile);
+		}
+		catch (const std::exception& e)
+		{
+			emit failed(m_pid, QString{ e.what() });
+		}
+	}
+
+	////////////////////////////////////////////////////////////////////////////////
+} /* namespace tool */
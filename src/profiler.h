@@ -0,0 +1,134 @@
+#pragma once
+#include <QObject>
+#include <QRunnable>
+#include <QString>
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <vector>
+
+class QTextStream;
+
+namespace tool
+{
+	////////////////////////////////////////////////////////////////////////////////
+
+	/** deduplicated call stacks: prefix trie over frame addresses with bounded node count */
+	class StackTrie
+	{
+	public:
+		struct Node
+		{
+			quint64 frame;
+			quint32 parent;
+			quint32 total; // samples passed through node
+			quint32 self;  // samples ended on node
+		};
+		static const quint32 root = 0;
+
+		StackTrie(size_t maxNodes = 1 << 16);
+
+		/** add one sample, frames ordered from outermost to innermost */
+		void add(const quint64* frames, size_t count);
+		const std::vector<Node>& nodes() const;
+		quint32 samples() const;
+		/** samples whose stacks were cut because trie is full */
+		quint32 truncated() const;
+
+	protected:
+		/** find or create child of parent, returns root when trie is full */
+		quint32 child(quint32 parent, quint64 frame);
+
+	protected:
+		const size_t m_maxNodes;
+		std::vector<Node> m_nodes;
+		std::vector<quint32> m_table; // open addressing: (parent, frame) -> node
+		quint32 m_truncated = 0;
+	};
+
+	////////////////////////////////////////////////////////////////////////////////
+
+	/** symbolized result of a profiling session */
+	struct Profile
+	{
+		struct Frame
+		{
+			QString name;
+			quint32 parent;
+			quint32 total;
+			quint32 self;
+		};
+		QString title;
+		std::vector<Frame> frames; // frames[0] is root
+		quint32 truncated = 0;
+		double elapsed = 0.; // seconds
+		double overhead = 0.; // share of thread time spent stopped by sampler, 0.05 is the budget
+
+		/** brendan gregg's folded stacks format: "a;b;c count" */
+		void writeFolded(QTextStream&) const;
+	};
+	using pProfile = std::shared_ptr<const Profile>;
+
+	////////////////////////////////////////////////////////////////////////////////
+
+	/** stack sampler of a foreign process */
+	class StackSampler
+	{
+	public:
+		struct Options
+		{
+			int rate = 49;        // samples per second
+			int duration = 10000; // milliseconds
+			int maxDepth = 128;
+			size_t maxNodes = 1 << 16;
+		};
+
+		StackSampler(int pid, const Options&);
+		~StackSampler();
+
+		/** blocking. samples all threads of the process until duration passes or cancelled */
+		Profile run(const std::atomic_bool& cancel);
+
+	protected:
+		/** walk stacks of every thread once, each stack goes to trie */
+		void sample();
+		/** module+offset (or symbol name where available) of address */
+		QString symbol(quint64);
+
+	protected:
+		struct impl;
+		const int m_pid;
+		const Options m_options;
+		StackTrie m_trie;
+		std::unique_ptr<impl> m_impl;
+		std::chrono::nanoseconds m_stopped{ 0 }; // summed over threads, suspend to resume
+		quint64 m_stops = 0;
+		quint64 m_ticks = 0;
+	};
+
+	////////////////////////////////////////////////////////////////////////////////
+
+	/** runs StackSampler on thread pool */
+	class ProfileTask : public QObject, public QRunnable
+	{
+		Q_OBJECT
+	public:
+		ProfileTask(int pid, const StackSampler::Options&, const QString& name, std::shared_ptr<std::atomic_bool> cancel);
+		void run() override;
+
+	signals:
+		void finished(int pid, tool::pProfile);
+		void failed(int pid, const QString&);
+
+	protected:
+		const int m_pid;
+		const StackSampler::Options m_options;
+		const QString m_name;
+		std::shared_ptr<std::atomic_bool> m_cancel;
+	};
+
+	////////////////////////////////////////////////////////////////////////////////
+} /* namespace tool */
+
+Q_DECLARE_METATYPE(tool::pProfile);
@@ -1,22 +1,23 @@
 #include "ui_serviceframe.h"
 #include "service.h"
+#include "event_log.h"
+#include "service_poller.h"
+#include "service_registry.h"
 
+#include <QEvent>
 #include <QMetaObject>
 #include <QMetaMethod>
 #include <QFileIconProvider>
-#include <QRegularExpression>
-#include <QTimer>
-#include <chrono>
-#include <thread>
 
 #include <QDebug>
 
 ////////////////////////////////////////////////////////////////////////////////
 
-ServiceManager::ServiceManager(const QString& sn, QWidget* parent)
+ServiceManager::ServiceManager(const QString& sn, int interval, QWidget* parent)
 	: QFrame(parent)
 	, m_serviceName{ sn }
 	, m_ui(new Ui::MainServiceFrame)
+	, m_poller{ ServicePoller::instance() }
 {
 	m_ui->setupUi(this);
 	// m_ui->label->setText(sh);
@@ -26,24 +27,39 @@ ServiceManager::ServiceManager(const QString& sn, QWidget* parent)
 		SLOT(onTooltipChange(const QString&)), Qt::QueuedConnection);
 	QObject::connect(this, SIGNAL(executablePath(const QString&)),
 		SLOT(onExecutablePath(const QString&)), Qt::QueuedConnection);
+	QObject::connect(this, SIGNAL(serviceResolved(const QString&)),
+		SLOT(onServiceResolved(const QString&)), Qt::QueuedConnection);
 	QObject::connect(m_ui->label, SIGNAL(clicked()),
 		this, SLOT(toggleService()));
-
-	QTimer::singleShot(std::chrono::milliseconds(10),
-		[&]() { m_thread = std::thread(&ServiceManager::notifierThread, this); });
+	m_ui->label->installEventFilter(this);
+
+	// callbacks come from poller thread, signals are queued to own slots
+	m_subscription = m_poller->subscribe(
+		m_serviceName, interval,
+		[this](WmiService::State state) { emit stateChanged(static_cast<int>(state)); },
+		[this](ServiceRegistry::Handle entry) {
+			if (!entry)
+				return;
+			const QString regPath = QString{ entry->pathName }.replace("\"", "").replace('\\', '/');
+			emit tooltipChange(QString{ "%1\n%2\n%3\n%4" }
+								   .arg(entry->displayName.isEmpty() ? QString{ "no display name available" } : entry->displayName)
+								   .arg(entry->description.isEmpty() ? QString{ "no description available" } : entry->description)
+								   .arg(m_serviceName)
+								   .arg(regPath));
+			emit executablePath(entry->service()->path());
+			emit serviceResolved(entry->name);
+		});
 }
 
 ServiceManager::~ServiceManager()
 {
-	m_lock.lock();
-	m_stopThread = true;
-	m_lock.unlock();
-	if (m_thread.joinable())
-		m_thread.join();
+	m_poller->unsubscribe(m_subscription);
 }
 
 void ServiceManager::onStateChanged(int s)
 {
+	// settled state may bring new latency sample
+	updateTooltip();
 	if (m_ui->label->getState() == s)
 		return;
 	m_ui->label->setProperty("state", s);
@@ -51,128 +67,46 @@ void ServiceManager::onStateChanged(int s)
 
 void ServiceManager::onTooltipChange(const QString& tool)
 {
-	m_ui->label->setToolTip(tool);
+	m_tooltip = tool;
+	updateTooltip();
 }
 
-void ServiceManager::onExecutablePath(const QString& e)
+void ServiceManager::onServiceResolved(const QString& name)
 {
-	QFileIconProvider pro;
-	QIcon ico = pro.icon(QFileInfo{ e });
-	m_ui->label->setPixmap(ico.pixmap(QSize{ 16, 16 }));
+	m_stats = ServiceStatistics::instance()->service(name);
+	m_entity = EventLog::instance()->entity(EventLog::Service, name);
+	updateTooltip();
 }
 
-void ServiceManager::toggleService()
+void ServiceManager::updateTooltip()
 {
-	auto lock = std::lock_guard{ m_lock };
-	m_serviceToggle = true;
+	QStringList parts{ m_tooltip };
+	const QString uptime = m_entity >= 0 ? EventLog::instance()->summary(static_cast<quint32>(m_entity)) : QString{};
+	if (!uptime.isEmpty())
+		parts.push_back(uptime);
+	const QString latency = m_stats != nullptr ? ServiceStatistics::summary(*m_stats) : QString{};
+	if (!latency.isEmpty())
+		parts.push_back(latency);
+	m_ui->label->setToolTip(parts.join("\n\n"));
 }
 
-void ServiceManager::enumerateServices()
+bool ServiceManager::eventFilter(QObject* watched, QEvent* event)
 {
-	auto lock = std::lock_guard{ m_lock };
-	try
-	{
-		auto services = tool::WmiObject::objects("service");
-		for (const auto& service : services)
-		{
-			const QRegularExpression re{ m_serviceName };
-			const QString serviceName{ service.property("Name").toString() };
-			if (serviceName == m_serviceName || re.match(serviceName).hasMatch())
-			{
-				m_service = std::make_unique<WmiService>(service);
-
-				int state = m_service->property("State").toInt();
-				const QString
-					regPath = m_service->property("PathName").toString().replace("\"", "").replace('\\', '/'),
-					displayName = m_service->property("DisplayName").toString(),
-					description = m_service->property("Description").toString();
-
-				emit tooltipChange(QString{ "%1\n%2\n%3\n%4" }
-									   .arg(displayName.isEmpty() ? QString{ "no display name available" } : displayName)
-									   .arg(description.isEmpty() ? QString{ "no description available" } : description)
-									   .arg(m_serviceName)
-									   .arg(regPath));
-				emit stateChanged(state);
-				emit executablePath(m_service->path());
-				break;
-			}
-		}
-		if (m_service.get() == nullptr)
-			emit stateChanged(0);
-	}
-	catch (const std::exception& e)
-	{
-		qDebug() << e.what();
-	}
+	if (watched == m_ui->label && event->type() == QEvent::ToolTip)
+		updateTooltip();
+	return QFrame::eventFilter(watched, event);
 }
 
-void ServiceManager::onToggleService(WmiService::State state)
+void ServiceManager::onExecutablePath(const QString& e)
 {
-	try
-	{
-		m_serviceToggle = false;
-
-		switch (state)
-		{
-		case WmiService::Stopped:
-			m_service->start();
-			break;
-		case WmiService::Running:
-			m_service->stop();
-			break;
-		case WmiService::Paused:
-			m_service->resume();
-			break;
-		case WmiService::Unknown:
-		case WmiService::StartPending:
-		case WmiService::StopPending:
-		case WmiService::ContinuePending:
-		case WmiService::PausePending:
-			throw std::runtime_error("invalid service toggling state");
-		}
-	}
-	catch (const std::exception& e)
-	{
-		qDebug() << "toggle " << e.what();
-	}
-	catch (...)
-	{
-		qDebug() << "unknown exception!";
-	}
+	QFileIconProvider pro;
+	QIcon ico = pro.icon(QFileInfo{ e });
+	m_ui->label->setPixmap(ico.pixmap(QSize{ 16, 16 }));
 }
 
-void ServiceManager::notifierThread()
+void ServiceManager::toggleService()
 {
-	WmiService::State lastState = static_cast<WmiService::State>(-1); // -V1016
-	enumerateServices();
-	while (true)
-	{
-		{
-			auto lock = std::lock_guard{ m_lock };
-			if (m_stopThread || !m_service)
-				break;
-			try
-			{
-				auto state = m_service->state();
-
-				if (m_serviceToggle)
-					onToggleService(state);
-				else if (state != lastState)
-				{
-					emit stateChanged(static_cast<int>(state));
-					lastState = state;
-				}
-			}
-			catch (const std::exception& e)
-			{
-				QTextStream out{ stdout };
-				out << "notifierThread: " << e.what() << endl;
-				m_stopThread = true;
-				continue;
-			}
-		}
-		std::this_thread::sleep_for(std::chrono::milliseconds(100));
-	}
+	m_poller->request(m_subscription, ServicePoller::Toggle);
 }
 
 ////////////////////////////////////////////////////////////////////////////////
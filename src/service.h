@@ -1,13 +1,14 @@
 #pragma once
+#include "service_stats.h"
 #include "wmi_service.h"
 
 #include <QFrame>
 #include <QTextStream>
 
-#include <mutex>
-#include <thread>
+#include <memory>
 
 class Settings;
+class ServicePoller;
 namespace Ui
 {
 	class MainServiceFrame;
@@ -21,32 +22,37 @@ class ServiceManager
 	Q_OBJECT
 
 public:
-	ServiceManager(const QString& serviceName, QWidget*);
+	/** interval of state polling, ms */
+	ServiceManager(const QString& serviceName, int interval, QWidget*);
 	~ServiceManager();
 
 signals:
 	void stateChanged(int);
 	void tooltipChange(const QString&);
 	void executablePath(const QString&);
+	void serviceResolved(const QString&);
 public slots:
 	void onStateChanged(int);
 	void onTooltipChange(const QString&);
 	void onExecutablePath(const QString&);
+	void onServiceResolved(const QString&);
 
 	void toggleService();
 
 protected:
-	void enumerateServices();
-	void notifierThread();
-	void onToggleService(WmiService::State);
+	/** description with uptime and transition latencies */
+	void updateTooltip();
+	/** uptime is recomputed when tooltip is about to show */
+	bool eventFilter(QObject*, QEvent*) override;
 
 protected:
 	const QString m_serviceName;
 	Ui::MainServiceFrame* m_ui = nullptr;
-	std::mutex m_lock;
-	std::thread m_thread;
-	bool m_stopThread = false, m_serviceToggle = false;
-	std::unique_ptr<WmiService> m_service{ nullptr };
+	std::shared_ptr<ServicePoller> m_poller;
+	int m_subscription = -1;
+	QString m_tooltip;
+	const ServiceStatistics::Histograms* m_stats = nullptr;
+	qint64 m_entity = -1;
 };
 
 ////////////////////////////////////////////////////////////////////////////////
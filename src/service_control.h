@@ -0,0 +1,40 @@
+#pragma once
+#include <QMetaType>
+#include <QString>
+
+#include <memory>
+
+////////////////////////////////////////////////////////////////////////////////
+
+/** control of one service whatever runs it: windows SCM (WmiService) or built-in supervisor (LocalService) */
+class ServiceControl
+{
+public:
+	enum State
+	{
+		Unknown,
+		Stopped,
+		Running,
+		Paused,
+		StartPending,
+		StopPending,
+		ContinuePending,
+		PausePending,
+	};
+
+	virtual ~ServiceControl() = default;
+
+	virtual const QString name() const = 0;
+	/** executable, used for icon */
+	virtual const QString path() const = 0;
+	virtual State state() = 0;
+
+	virtual int start() = 0;
+	virtual int stop() = 0;
+	virtual int resume() = 0;
+};
+
+using pServiceControl = std::shared_ptr<ServiceControl>;
+
+////////////////////////////////////////////////////////////////////////////////
+Q_DECLARE_METATYPE(pServiceControl);
@@ -0,0 +1,206 @@
+#include "service_events.h"
+#include "settings.h"
+
+#include <QDir>
+#include <QFile>
+
+#include <map>
+#include <mutex>
+#include <set>
+#include <stdexcept>
+#include <thread>
+
+#ifdef Q_OS_LINUX
+#include <cerrno>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+#include <QDebug>
+
+////////////////////////////////////////////////////////////////////////////////
+
+namespace
+{
+#ifdef Q_OS_WIN
+	/** WMI polls services itself (WITHIN), we get only changed instances */
+	class WmiServiceEvents : public ServiceEventSource
+	{
+	public:
+		WmiServiceEvents(Callback callback, double within)
+			: m_callback(std::move(callback))
+			, m_within(within)
+		{}
+
+		void watch(const QStringList& names) override
+		{
+			m_notification.reset();
+			if (names.isEmpty())
+				return;
+			QStringList conditions;
+			for (auto name : names)
+				conditions.push_back(QString{ "TargetInstance.Name = '%1'" }.arg(name.replace('\\', "\\\\").replace('\'', "\\'")));
+			const QString wql = QString{ "SELECT * FROM __InstanceModificationEvent WITHIN %1 "
+										 "WHERE TargetInstance ISA 'Win32_Service' AND (%2)" }
+									.arg(m_within)
+									.arg(conditions.join(" OR "));
+			const Callback callback = m_callback;
+			m_notification = std::make_unique<tool::WmiNotification>(wql, [callback](const tool::WmiObject::PropertyList& p) {
+				const auto name = p.find("Name"), state = p.find("State");
+				if (name != p.end() && state != p.end())
+					callback(name->second.toString(), WmiService::parseState(state->second.toString()));
+			});
+		}
+
+	protected:
+		const Callback m_callback;
+		const double m_within;
+		std::unique_ptr<tool::WmiNotification> m_notification;
+	};
+#endif
+
+#ifdef Q_OS_LINUX
+	/** external supervisor (not LocalSupervisor, it reports to poller directly) keeps one file
+		per service with its state ("running", "stopped", ...). missing file or unknown text
+		isnt state, poller keeps polling such service */
+	class StateFileEvents : public ServiceEventSource
+	{
+	public:
+		StateFileEvents(Callback callback, const QString& directory)
+			: m_callback(std::move(callback))
+			, m_directory(directory)
+		{
+			QDir{}.mkpath(m_directory);
+			m_inotify = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+			m_stop = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+			if (m_inotify < 0 || m_stop < 0
+				|| inotify_add_watch(m_inotify, QFile::encodeName(m_directory).constData(), IN_CLOSE_WRITE | IN_MOVED_TO | IN_DELETE) < 0)
+			{
+				close();
+				throw std::runtime_error("inotify setup failed");
+			}
+			m_thread = std::thread(&StateFileEvents::run, this);
+		}
+
+		~StateFileEvents()
+		{
+			const uint64_t one = 1;
+			if (::write(m_stop, &one, sizeof(one)) < 0)
+				qDebug() << "state file watcher: stop failed";
+			if (m_thread.joinable())
+				m_thread.join();
+			close();
+		}
+
+		void watch(const QStringList& names) override
+		{
+			{
+				auto lock = std::lock_guard{ m_lock };
+				m_names = std::set<QString>(names.begin(), names.end());
+			}
+			// files written before watch started
+			for (const auto& name : names)
+				notify(name);
+		}
+
+	protected:
+		void close()
+		{
+			if (m_inotify >= 0)
+				::close(m_inotify);
+			if (m_stop >= 0)
+				::close(m_stop);
+			m_inotify = m_stop = -1;
+		}
+
+		void run()
+		{
+			alignas(inotify_event) char buffer[4096];
+			pollfd fds[2]{ { m_inotify, POLLIN, 0 }, { m_stop, POLLIN, 0 } };
+			while (true)
+			{
+				if (::poll(fds, 2, -1) < 0)
+				{
+					if (errno == EINTR)
+						continue;
+					break;
+				}
+				if (fds[1].revents != 0)
+					break;
+				if ((fds[0].revents & POLLIN) == 0)
+					continue;
+				ssize_t size;
+				while ((size = ::read(m_inotify, buffer, sizeof(buffer))) > 0)
+					for (char* p = buffer; p < buffer + size;)
+					{
+						const auto* e = reinterpret_cast<const inotify_event*>(p);
+						if (e->len != 0)
+							notify(QFile::decodeName(e->name));
+						p += sizeof(inotify_event) + e->len;
+					}
+			}
+		}
+
+		void notify(const QString& name)
+		{
+			{
+				auto lock = std::lock_guard{ m_lock };
+				if (m_names.count(name) == 0)
+					return;
+			}
+			QFile file{ QDir{ m_directory }.filePath(name) };
+			if (!file.open(QIODevice::ReadOnly))
+				return;
+			const QString text = QString::fromUtf8(file.read(64)).trimmed().toLower();
+			static const std::map<QString, WmiService::State> states{
+				{ "stopped", WmiService::Stopped },
+				{ "running", WmiService::Running },
+				{ "paused", WmiService::Paused },
+				{ "starting", WmiService::StartPending },
+				{ "start pending", WmiService::StartPending },
+				{ "stopping", WmiService::StopPending },
+				{ "stop pending", WmiService::StopPending },
+			};
+			const auto it = states.find(text);
+			if (it != states.end())
+				m_callback(name, it->second);
+		}
+
+	protected:
+		const Callback m_callback;
+		const QString m_directory;
+		int m_inotify = -1, m_stop = -1;
+		std::mutex m_lock;
+		std::set<QString> m_names;
+		std::thread m_thread;
+	};
+#endif
+} // namespace
+
+////////////////////////////////////////////////////////////////////////////////
+
+std::unique_ptr<ServiceEventSource> ServiceEventSource::create(Callback callback)
+{
+	Settings* setup = Settings::setup();
+	if (!setup->get("service_events", true).toBool())
+		return nullptr;
+	try
+	{
+#if defined(Q_OS_WIN)
+		return std::make_unique<WmiServiceEvents>(std::move(callback), setup->get("service_event_within", 1.).toDouble());
+#elif defined(Q_OS_LINUX)
+		return std::make_unique<StateFileEvents>(std::move(callback), setup->get("service_state_dir", QString{ "/run/qt_chooser" }).toString());
+#else
+		Q_UNUSED(callback);
+#endif
+	}
+	catch (const std::exception& e)
+	{
+		qDebug() << "service events unavailable:" << e.what();
+	}
+	return nullptr;
+}
+
+////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,28 @@
+#pragma once
+#include "wmi_service.h"
+
+#include <QStringList>
+
+#include <functional>
+#include <memory>
+
+////////////////////////////////////////////////////////////////////////////////
+
+/** pushes service state transitions, so services need only slow safety polling */
+class ServiceEventSource
+{
+public:
+	/** invoked on backend thread */
+	using Callback = std::function<void(const QString& serviceName, WmiService::State)>;
+
+	virtual ~ServiceEventSource() = default;
+	/** replaces set of watched services, must not be called under lock taken by callback */
+	virtual void watch(const QStringList&) = 0;
+
+	/** backend of platform ("service_events" in qt_chooser.json), nullptr if disabled or unavailable:
+		windows - __InstanceModificationEvent of Win32_Service,
+		others - inotify on state files written by external supervisor ("service_state_dir") */
+	static std::unique_ptr<ServiceEventSource> create(Callback);
+};
+
+////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,309 @@
+#include "ui_serviceframe.h"
+#include "service_group.h"
+#include "service.h"
+#include "service_poller.h"
+#include "settings.h"
+
+#include <QHash>
+#include <QJsonArray>
+#include <QJsonObject>
+#include <QTextStream>
+#include <QTimer>
+
+#include <deque>
+#include <stdexcept>
+
+#include <QDebug>
+
+////////////////////////////////////////////////////////////////////////////////
+
+namespace
+{
+	double msSince(ServiceGroupManager::Clock::time_point t)
+	{
+		return std::chrono::duration<double, std::milli>(ServiceGroupManager::Clock::now() - t).count();
+	}
+} // namespace
+
+////////////////////////////////////////////////////////////////////////////////
+
+ServiceGroupManager::ServiceGroupManager(const QJsonObject& config, QWidget* parent)
+	: QFrame(parent)
+	, m_name{ config.value("name").toString() }
+	, m_ui(new Ui::MainServiceFrame)
+	, m_poller{ ServicePoller::instance() }
+	, m_watchdog(new QTimer(this))
+{
+	if (m_name.isEmpty())
+		throw std::runtime_error("service group requires name");
+	m_timeout = config.value("timeout").toInt(m_timeout);
+
+	// "services": [ "name", { "name": "...", "after": [ "name", ... ] } ]
+	const QJsonArray services = config.value("services").toArray();
+	QHash<QString, size_t> index;
+	for (const auto& value : services)
+	{
+		Member m;
+		m.name = value.isObject() ? value.toObject().value("name").toString() : value.toString();
+		if (m.name.isEmpty() || index.contains(m.name))
+			throw std::runtime_error("service group member must have unique name");
+		index.insert(m.name, m_members.size());
+		m_members.push_back(m);
+	}
+	for (size_t i = 0; i < m_members.size(); ++i)
+		for (const auto& dep : services[static_cast<int>(i)].toObject().value("after").toArray())
+		{
+			const auto it = index.find(dep.toString());
+			if (it == index.end())
+				throw std::runtime_error("service group dependency is not a member of group");
+			m_members[i].after.push_back(it.value());
+			m_members[it.value()].before.push_back(i);
+		}
+
+	// Kahn's walk, everything left unvisited is on a cycle
+	std::vector<size_t> indegree;
+	std::deque<size_t> ready;
+	for (size_t i = 0; i < m_members.size(); ++i)
+	{
+		indegree.push_back(m_members[i].after.size());
+		if (indegree.back() == 0)
+			ready.push_back(i);
+	}
+	size_t visited = 0;
+	for (; !ready.empty(); ++visited)
+	{
+		const size_t i = ready.front();
+		ready.pop_front();
+		for (const size_t next : m_members[i].before)
+			if (--indegree[next] == 0)
+				ready.push_back(next);
+	}
+	if (visited != m_members.size())
+		throw std::runtime_error("service group has dependency cycle");
+
+	m_ui->setupUi(this);
+	m_ui->label->setText(m_name.left(1).toUpper());
+	QObject::connect(this, SIGNAL(memberStateChanged(int, int)),
+		SLOT(onMemberStateChanged(int, int)), Qt::QueuedConnection);
+	QObject::connect(m_ui->label, SIGNAL(clicked()),
+		this, SLOT(toggleGroup()));
+	QObject::connect(m_watchdog, SIGNAL(timeout()),
+		this, SLOT(onTimeout()));
+	m_watchdog->setInterval(250);
+
+	const int interval = Settings::setup()->get("service_poll_interval", 100).toInt();
+	for (size_t i = 0; i < m_members.size(); ++i)
+		m_members[i].subscription = m_poller->subscribe(m_members[i].name, interval,
+			[this, i](WmiService::State state) { emit memberStateChanged(static_cast<int>(i), static_cast<int>(state)); });
+	updateView();
+}
+
+ServiceGroupManager::~ServiceGroupManager()
+{
+	for (const auto& m : m_members)
+		m_poller->unsubscribe(m.subscription);
+}
+
+WmiService::State ServiceGroupManager::state() const
+{
+	if (m_operation == Starting)
+		return WmiService::StartPending;
+	if (m_operation == Stopping)
+		return WmiService::StopPending;
+	size_t running = 0, known = 0;
+	for (const auto& m : m_members)
+	{
+		running += (m.state == WmiService::Running);
+		known += (m.state != WmiService::Unknown);
+	}
+	if (known == 0)
+		return WmiService::Unknown;
+	if (running == 0)
+		return WmiService::Stopped;
+	return running == m_members.size() ? WmiService::Running : WmiService::Paused;
+}
+
+QString ServiceGroupManager::report() const
+{
+	if (m_lastOperation == Idle)
+		return QString{};
+	QString result;
+	QTextStream out{ &result };
+	out << (m_lastOperation == Starting ? "start" : "stop") << ": " << qRound(m_total) << " ms total";
+	for (const auto& m : m_members)
+	{
+		out << "\n  " << m.name << ": ";
+		if (!m.issued)
+			out << "skipped";
+		else if (m.failed)
+			out << "failed after " << qRound(m.elapsed) << " ms";
+		else
+			out << qRound(m.elapsed) << " ms";
+	}
+	out.flush();
+	return result;
+}
+
+void ServiceGroupManager::start()
+{
+	begin(Starting);
+}
+
+void ServiceGroupManager::stop()
+{
+	begin(Stopping);
+}
+
+void ServiceGroupManager::toggleGroup()
+{
+	if (m_operation != Idle)
+		return;
+	if (state() == WmiService::Stopped)
+		start();
+	else if (state() != WmiService::Unknown)
+		stop();
+}
+
+void ServiceGroupManager::begin(Operation operation)
+{
+	if (m_operation != Idle)
+		return;
+	for (auto& m : m_members)
+	{
+		m.issued = m.pending = m.done = m.failed = m.deferred = false;
+		m.elapsed = 0.;
+	}
+	m_operation = operation;
+	m_begin = Clock::now();
+	m_watchdog->start();
+	advance();
+	updateView();
+}
+
+void ServiceGroupManager::advance()
+{
+	if (m_operation == Idle)
+		return;
+	const auto target = (m_operation == Starting ? WmiService::Running : WmiService::Stopped);
+	bool inFlight = false;
+	for (bool changed = true; changed;)
+	{
+		changed = false;
+		inFlight = false;
+		for (auto& m : m_members)
+		{
+			if (m.done)
+				continue;
+			if (m.issued)
+			{
+				inFlight = true;
+				continue;
+			}
+			// start waits for dependencies, stop waits for dependents
+			bool ready = true, blocked = false;
+			for (const size_t d : (m_operation == Starting ? m.after : m.before))
+			{
+				ready = ready && m_members[d].done;
+				blocked = blocked || m_members[d].failed;
+			}
+			if (blocked)
+			{ // skipped, failure propagates down the graph
+				m.done = m.failed = changed = true;
+				continue;
+			}
+			if (!ready)
+				continue;
+			m.issued = true;
+			m.issuedAt = Clock::now();
+			if (m.state == target || m.state == WmiService::Unknown)
+			{
+				complete(m, m.state != target);
+				changed = true;
+				continue;
+			}
+			issue(m);
+			inFlight = true;
+		}
+	}
+	if (inFlight)
+		return;
+
+	m_total = msSince(m_begin);
+	m_lastOperation = m_operation;
+	m_operation = Idle;
+	m_watchdog->stop();
+	qInfo().noquote() << "service group" << m_name << report();
+	emit finished(report());
+}
+
+void ServiceGroupManager::issue(Member& m)
+{
+	// start and stop are no-ops for pending states, stop of starting service would
+	// otherwise wait for timeout. it is sent once service settles
+	const bool towards = (m_operation == Starting
+			? m.state == WmiService::StartPending || m.state == WmiService::ContinuePending
+			: m.state == WmiService::StopPending);
+	m.deferred = (m.state >= WmiService::StartPending && !towards);
+	if (m.deferred)
+		return;
+	m_poller->request(m.subscription, m_operation == Starting ? ServicePoller::Start : ServicePoller::Stop);
+}
+
+void ServiceGroupManager::complete(Member& m, bool failed)
+{
+	m.done = true;
+	m.failed = failed;
+	m.elapsed = msSince(m.issuedAt);
+}
+
+void ServiceGroupManager::onMemberStateChanged(int member, int state)
+{
+	Member& m = m_members[static_cast<size_t>(member)];
+	m.state = static_cast<WmiService::State>(state);
+	if (m_operation != Idle && m.issued && !m.done)
+	{
+		const auto target = (m_operation == Starting ? WmiService::Running : WmiService::Stopped);
+		if (m.state == target)
+			complete(m, false);
+		else if (m.deferred)
+		{ // queued command goes once member leaves opposite transition, timeout counts from issue
+			if (m.state == WmiService::Unknown)
+				complete(m, true);
+			else
+				issue(m);
+		}
+		else if (m.state >= WmiService::StartPending)
+			m.pending = true;
+		else if (m.pending)
+			complete(m, true); // settled in wrong state
+		advance();
+	}
+	updateView();
+}
+
+void ServiceGroupManager::onTimeout()
+{
+	for (auto& m : m_members)
+		if (m.issued && !m.done && msSince(m.issuedAt) > m_timeout)
+			complete(m, true);
+	advance();
+	updateView();
+}
+
+void ServiceGroupManager::updateView()
+{
+	m_ui->label->setState(static_cast<int>(state()));
+
+	QString tooltip;
+	QTextStream out{ &tooltip };
+	out << m_name;
+	for (const auto& m : m_members)
+		out << "\n" << m.name << ": " << m.state;
+	const QString last = report();
+	if (!last.isEmpty())
+		out << "\n\n" << last;
+	out.flush();
+	m_ui->label->setToolTip(tooltip);
+}
+
+////////////////////////////////////////////////////////////////////////////////
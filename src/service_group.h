@@ -0,0 +1,95 @@
+#pragma once
+#include "wmi_service.h"
+
+#include <QFrame>
+
+#include <chrono>
+#include <memory>
+#include <vector>
+
+class QJsonObject;
+class QTimer;
+class ServicePoller;
+namespace Ui
+{
+	class MainServiceFrame;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+/** named set of services ("service_groups" in qt_chooser.json), started and stopped
+	along declared dependencies. independent branches run concurrently, each service
+	is issued as soon as services it depends on have reached target state */
+class ServiceGroupManager
+	: public QFrame
+{
+	Q_OBJECT
+
+public:
+	using Clock = std::chrono::steady_clock;
+
+	struct Member
+	{
+		QString name;
+		std::vector<size_t> after; // services this one depends on
+		std::vector<size_t> before; // services depending on this one
+		int subscription = -1;
+		WmiService::State state = WmiService::Unknown;
+
+		// current operation
+		bool issued = false, pending = false, done = false, failed = false;
+		bool deferred = false; // command waits until opposite transition settles
+		Clock::time_point issuedAt;
+		double elapsed = 0.; // ms, issue -> target state
+	};
+
+	ServiceGroupManager(const QJsonObject&, QWidget*);
+	~ServiceGroupManager();
+
+	/** stopped or running when all members are, paused when group is partially running */
+	WmiService::State state() const;
+	/** per service and total wall clock times of last start/stop */
+	QString report() const;
+
+signals:
+	void memberStateChanged(int member, int state);
+	void finished(const QString& report);
+
+public slots:
+	void start();
+	void stop();
+	void toggleGroup();
+
+protected slots:
+	void onMemberStateChanged(int member, int state);
+	void onTimeout();
+
+protected:
+	enum Operation
+	{
+		Idle,
+		Starting,
+		Stopping,
+	};
+	void begin(Operation);
+	/** issues every member whose dependencies are satisfied, finishes operation when nothing is left */
+	void advance();
+	void complete(Member&, bool failed);
+	/** requests target state, or defers it while member is in transition the other way */
+	void issue(Member&);
+	void updateView();
+
+protected:
+	const QString m_name;
+	Ui::MainServiceFrame* m_ui = nullptr;
+	std::shared_ptr<ServicePoller> m_poller;
+	std::vector<Member> m_members;
+	int m_timeout = 60000; // ms per service
+	QTimer* m_watchdog = nullptr;
+
+	Operation m_operation = Idle, m_lastOperation = Idle;
+	Clock::time_point m_begin;
+	double m_total = 0.; // ms
+};
+
+////////////////////////////////////////////////////////////////////////////////
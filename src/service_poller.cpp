@@ -0,0 +1,395 @@
+#include "service_poller.h"
+#include "event_log.h"
+#include "local_supervisor.h"
+#include "settings.h"
+
+#include <QStringList>
+
+#include <algorithm>
+#include <stdexcept>
+
+#include <QDebug>
+
+////////////////////////////////////////////////////////////////////////////////
+
+std::shared_ptr<ServicePoller> ServicePoller::instance()
+{
+	// accessed from gui thread only
+	static std::weak_ptr<ServicePoller> instance;
+	auto result = instance.lock();
+	if (!result)
+	{
+		result.reset(new ServicePoller);
+		instance = result;
+	}
+	return result;
+}
+
+ServicePoller::ServicePoller()
+	: m_tick{ std::max(10, Settings::setup()->get("service_poll_tick", 100).toInt()) }
+{
+	m_events = ServiceEventSource::create([this](const QString& name, WmiService::State state) { onEvent(name, state); });
+	// local supervisor reports its transitions itself
+	m_localListener = LocalSupervisor::instance()->listen([this](const QString& name, ServiceControl::State state) { onEvent(name, state); });
+	m_thread = std::thread(&ServicePoller::run, this);
+}
+
+ServicePoller::~ServicePoller()
+{
+	{
+		auto lock = std::lock_guard{ m_lock };
+		m_stop = true;
+	}
+	m_wake.notify_all();
+	if (m_thread.joinable())
+		m_thread.join();
+	LocalSupervisor::instance()->unlisten(m_localListener);
+	m_events.reset();
+}
+
+int ServicePoller::subscribe(const QString& serviceName, int interval, StateCallback onState, ResolveCallback onResolve)
+{
+	auto lock = std::lock_guard{ m_lock };
+	const int id = m_nextId++;
+	Subscription& s = m_subscriptions[id];
+	s.name = serviceName;
+	if (m_events)
+		interval = std::max(interval, Settings::setup()->get("service_safety_poll", 30000).toInt());
+	s.ticks = static_cast<unsigned>(std::max<qint64>(1, (interval + m_tick.count() - 1) / m_tick.count()));
+	s.onState = std::move(onState);
+	s.onResolve = std::move(onResolve);
+	// new subscription is resolved on next wakeup, not after whole interval
+	m_urgent = true;
+	m_wake.notify_all();
+	return id;
+}
+
+void ServicePoller::unsubscribe(int id)
+{
+	// tick runs under the same lock, so callbacks cant be in flight here
+	auto lock = std::lock_guard{ m_lock };
+	m_subscriptions.erase(id);
+	m_watchDirty = true;
+}
+
+void ServicePoller::request(int id, Command command)
+{
+	auto lock = std::lock_guard{ m_lock };
+	const auto it = m_subscriptions.find(id);
+	if (it == m_subscriptions.end())
+		return;
+	it->second.commands.push_back(command);
+	m_urgent = true;
+	m_wake.notify_all();
+}
+
+void ServicePoller::schedule(int id, unsigned ticks, bool once)
+{
+	ticks = std::max(1u, ticks);
+	m_wheel[(m_cursor + ticks) % wheelSize].push_back(WheelEntry{ id, (ticks - 1) / wheelSize, once });
+}
+
+void ServicePoller::run()
+{
+	auto next = std::chrono::steady_clock::now() + m_tick;
+	auto lock = std::unique_lock{ m_lock };
+	while (!m_stop)
+	{
+		const bool timeout = !m_wake.wait_until(lock, next, [this]() { return m_stop || m_urgent; });
+		if (m_stop)
+			break;
+		m_urgent = false;
+		tick(lock, timeout);
+		if (timeout)
+			next += m_tick;
+		if (m_events && m_watchDirty)
+		{ // event callback takes our lock, so subscription is replaced without it
+			m_watchDirty = false;
+			QStringList names;
+			for (const auto& [id, s] : m_subscriptions)
+				names.push_back(s.serviceName.isEmpty() ? s.name : s.serviceName);
+			names.removeDuplicates();
+			lock.unlock();
+			m_events->watch(names);
+			lock.lock();
+		}
+	}
+}
+
+void ServicePoller::tick(std::unique_lock<std::mutex>& lock, bool advance)
+{
+	std::vector<int> due;
+	resolve(lock, due);
+	if (advance)
+	{
+		m_cursor = (m_cursor + 1) % wheelSize;
+		std::vector<WheelEntry> slot;
+		slot.swap(m_wheel[m_cursor]);
+		for (auto& e : slot)
+		{
+			const auto it = m_subscriptions.find(e.id);
+			if (it == m_subscriptions.end())
+				continue; // unsubscribed, dropped lazily
+			if (e.rounds != 0)
+			{
+				--e.rounds;
+				m_wheel[m_cursor].push_back(e);
+				continue;
+			}
+			due.push_back(e.id);
+			if (e.once)
+				it->second.followUp = false;
+			else
+				schedule(e.id, it->second.ticks);
+		}
+	}
+	std::vector<Work> work;
+	for (auto& [id, s] : m_subscriptions)
+		if (!s.commands.empty())
+		{
+			work.push_back(Work{ id, s.service, {} });
+			work.back().commands.swap(s.commands);
+			due.push_back(id);
+		}
+	std::sort(due.begin(), due.end());
+	due.erase(std::unique(due.begin(), due.end()), due.end());
+	if (due.empty())
+		return;
+	std::vector<Polled> polled;
+	for (const int id : due)
+	{
+		const auto it = m_subscriptions.find(id);
+		if (it != m_subscriptions.end())
+			polled.push_back(Polled{ id, it->second.service, it->second.serviceName });
+	}
+
+	// service manager calls take long, gui thread must be able to subscribe and request meanwhile
+	lock.unlock();
+	for (auto& w : work)
+		execute(w);
+	const auto states = refresh(polled);
+	lock.lock();
+
+	for (const auto& w : work)
+	{
+		const auto it = m_subscriptions.find(w.id);
+		if (it == m_subscriptions.end() || (w.pendingSince == std::chrono::steady_clock::time_point{} && !w.failed))
+			continue;
+		it->second.pendingSince = w.pendingSince;
+		it->second.pendingState = w.pendingState;
+	}
+	for (const auto& [id, state] : states)
+	{ // unsubscribed meanwhile ones are skipped, their callbacks mustnt run anymore
+		const auto it = m_subscriptions.find(id);
+		if (it != m_subscriptions.end())
+			update(id, it->second, state);
+	}
+}
+
+void ServicePoller::resolve(std::unique_lock<std::mutex>& lock, std::vector<int>& due)
+{
+	std::map<int, QString> pending;
+	for (const auto& [id, s] : m_subscriptions)
+		if (!s.resolved)
+			pending[id] = s.name;
+	if (pending.empty())
+		return;
+
+	// first lookup enumerates all services, subscribers must not wait for it
+	std::map<int, ServiceRegistry::Handle> entries;
+	std::map<int, quint32> entities;
+	lock.unlock();
+	for (const auto& [id, name] : pending)
+	{
+		auto& entry = entries[id];
+		try
+		{
+			entry = ServiceRegistry::instance()->find(name);
+			if (entry)
+				entities[id] = EventLog::instance()->entity(EventLog::Service, entry->name);
+		}
+		catch (const std::exception& e)
+		{
+			qDebug() << "resolve" << name << e.what();
+		}
+	}
+	lock.lock();
+
+	for (const auto& [id, entry] : entries)
+	{
+		const auto it = m_subscriptions.find(id);
+		if (it == m_subscriptions.end())
+			continue;
+		Subscription& s = it->second;
+		s.resolved = true;
+		m_watchDirty = true;
+		if (entry)
+		{
+			s.service = entry->service();
+			s.serviceName = s.service ? s.service->name() : entry->name;
+			s.stats = ServiceStatistics::instance()->service(entry->name);
+			s.entity = entities[id];
+			schedule(id, s.ticks);
+		}
+		if (s.onResolve)
+			s.onResolve(entry);
+		due.push_back(id);
+	}
+}
+
+void ServicePoller::execute(Work& w)
+{
+	if (!w.service)
+		return;
+	for (const Command command : w.commands)
+	{
+		try
+		{
+			const auto state = w.service->state();
+			// latency is measured from our own request, not from first observed pending state
+			const auto requested = std::chrono::steady_clock::now();
+			bool issued = true;
+			switch (command)
+			{
+			case Toggle:
+				switch (state)
+				{
+				case WmiService::Stopped:
+					w.service->start();
+					break;
+				case WmiService::Running:
+					w.service->stop();
+					break;
+				case WmiService::Paused:
+					w.service->resume();
+					break;
+				case WmiService::Unknown:
+				case WmiService::StartPending:
+				case WmiService::StopPending:
+				case WmiService::ContinuePending:
+				case WmiService::PausePending:
+					throw std::runtime_error("invalid service toggling state");
+				}
+				break;
+			case Start:
+				if (state == WmiService::Paused)
+					w.service->resume();
+				else if (state == WmiService::Stopped)
+					w.service->start();
+				else
+					issued = false;
+				break;
+			case Stop:
+				if (state == WmiService::Running || state == WmiService::Paused)
+					w.service->stop();
+				else
+					issued = false;
+				break;
+			}
+			if (!issued)
+				continue;
+			w.pendingSince = requested;
+			w.pendingState = (command == Stop || (command == Toggle && state == WmiService::Running) ? WmiService::StopPending
+				: state == WmiService::Paused ? WmiService::ContinuePending
+				: WmiService::StartPending);
+			w.failed = false;
+		}
+		catch (const std::exception& e)
+		{
+			qDebug() << "command" << w.service->name() << e.what();
+			w.pendingSince = std::chrono::steady_clock::time_point{};
+			w.pendingState = WmiService::Unknown;
+			w.failed = true;
+		}
+	}
+}
+
+std::map<int, WmiService::State> ServicePoller::refresh(const std::vector<Polled>& polled)
+{
+	QStringList conditions;
+	for (const auto& [id, service, name] : polled)
+	{
+		if (dynamic_cast<WmiService*>(service.get()) != nullptr)
+			conditions.push_back(QString{ "Name = '%1'" }.arg(QString{ name }.replace('\\', "\\\\").replace('\'', "\\'")));
+	}
+	conditions.removeDuplicates();
+
+	std::map<QString, WmiService::State> states;
+#ifdef Q_OS_WIN
+	if (!conditions.isEmpty())
+	{
+		try
+		{
+			for (const auto& row : tool::WmiObject::select(QString{ "SELECT Name, State FROM Win32_Service WHERE %1" }.arg(conditions.join(" OR "))))
+			{
+				const auto name = row.find("Name"), state = row.find("State");
+				if (name != row.end() && state != row.end())
+					states[name->second.toString()] = WmiService::parseState(state->second.toString());
+			}
+		}
+		catch (const std::exception& e)
+		{
+			qDebug() << "service poll" << e.what();
+			return {};
+		}
+	}
+#endif
+
+	std::map<int, WmiService::State> result;
+	for (const auto& [id, service, name] : polled)
+	{
+		auto state = WmiService::Unknown;
+		if (dynamic_cast<WmiService*>(service.get()) != nullptr)
+		{ // service missing from result was removed from system
+			const auto it = states.find(name);
+			if (it != states.end())
+				state = it->second;
+		}
+		else if (service)
+			state = service->state(); // local one, no query behind it
+		result[id] = state;
+	}
+	return result;
+}
+
+void ServicePoller::onEvent(const QString& serviceName, WmiService::State state)
+{
+	auto lock = std::lock_guard{ m_lock };
+	for (auto& [id, s] : m_subscriptions)
+		if ((s.serviceName.isEmpty() ? s.name : s.serviceName) == serviceName)
+			update(id, s, state);
+}
+
+void ServicePoller::update(int id, Subscription& s, WmiService::State state)
+{
+	if (state >= WmiService::StartPending)
+	{ // pending state is followed on every tick until it settles, events may lag behind (WITHIN).
+		// one follow-up at a time, periodic entry of subscription stays as it was
+		if (!s.followUp)
+		{
+			s.followUp = true;
+			schedule(id, 1, true);
+		}
+		if (s.pendingSince == std::chrono::steady_clock::time_point{})
+			s.pendingSince = std::chrono::steady_clock::now();
+		s.pendingState = state;
+	}
+	else if (s.pendingSince != std::chrono::steady_clock::time_point{})
+	{ // only atomics touched here, no locks or allocations
+		const int transition = ServiceStatistics::transition(s.pendingState, state);
+		if (transition >= 0 && s.stats != nullptr)
+			s.stats->transitions[static_cast<size_t>(transition)].record(static_cast<quint64>(
+				std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - s.pendingSince).count()));
+		s.pendingSince = std::chrono::steady_clock::time_point{};
+	}
+	if (state == s.last)
+		return;
+	// first observation isnt transition, uptime keeps counting from logged start
+	if (s.entity >= 0 && s.last != static_cast<WmiService::State>(-1))
+		EventLog::instance()->append(static_cast<quint32>(s.entity), EventLog::Service, s.last, state);
+	s.last = state;
+	if (s.onState)
+		s.onState(state);
+}
+
+////////////////////////////////////////////////////////////////////////////////
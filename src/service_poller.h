@@ -0,0 +1,127 @@
+#pragma once
+#include "service_events.h"
+#include "service_registry.h"
+#include "service_stats.h"
+#include "wmi_service.h"
+
+#include <array>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+////////////////////////////////////////////////////////////////////////////////
+
+/** one thread polls every watched service: single batched WQL query per tick,
+	per service intervals are kept in a timer wheel. when platform pushes state
+	changes (ServiceEventSource) polling is only slow safety net for missed events */
+class ServicePoller
+{
+public:
+	enum Command
+	{
+		Toggle,
+		Start,
+		Stop,
+	};
+	/** called on poller thread, only when state has changed */
+	using StateCallback = std::function<void(WmiService::State)>;
+	/** called on poller thread once service is looked up, handle is null if it is not installed */
+	using ResolveCallback = std::function<void(ServiceRegistry::Handle)>;
+
+	/** poller lives while someone holds it, thread is joined by the last owner */
+	static std::shared_ptr<ServicePoller> instance();
+	~ServicePoller();
+
+	/** interval is rounded up to poller ticks ("service_poll_tick", ms),
+		with push events it is at least "service_safety_poll" */
+	int subscribe(const QString& serviceName, int interval, StateCallback, ResolveCallback = nullptr);
+	/** after return callbacks of subscription are never called */
+	void unsubscribe(int);
+	/** command is executed by poller thread right away, state is refreshed after it */
+	void request(int, Command);
+
+protected:
+	ServicePoller();
+	void run();
+	void tick(std::unique_lock<std::mutex>&, bool advance);
+	/** once entries fire a single time, others are re-armed with subscription interval */
+	void schedule(int id, unsigned ticks, bool once = false);
+
+	struct Subscription
+	{
+		QString name;
+		unsigned ticks = 1;
+		StateCallback onState;
+		ResolveCallback onResolve;
+		bool resolved = false;
+		pServiceControl service; // touched by poller thread only
+		QString serviceName;     // of service once resolved, matched by events from other threads
+		WmiService::State last = static_cast<WmiService::State>(-1); // -V1016
+		bool followUp = false; // once entry of pending state is in wheel
+		std::deque<Command> commands;
+
+		// transition timing, recorded into stats when pending state settles
+		ServiceStatistics::Histograms* stats = nullptr;
+		WmiService::State pendingState = WmiService::Unknown;
+		std::chrono::steady_clock::time_point pendingSince;
+
+		qint64 entity = -1; // EventLog id, transitions are logged once service is resolved
+	};
+	/** commands of one subscription taken out of it, run without lock */
+	struct Work
+	{
+		int id;
+		pServiceControl service;
+		std::deque<Command> commands;
+		// request time of last command which was issued, copied to subscription once lock is retaken
+		WmiService::State pendingState = WmiService::Unknown;
+		std::chrono::steady_clock::time_point pendingSince;
+		bool failed = false; // last command threw, timing of subscription is dropped
+	};
+	struct Polled
+	{
+		int id;
+		pServiceControl service;
+		QString name;
+	};
+
+	/** looks up new subscriptions, lock is released meanwhile */
+	void resolve(std::unique_lock<std::mutex>&, std::vector<int>& due);
+	/** called without lock, service calls block for as long as service manager takes */
+	static void execute(Work&);
+	/** called without lock, one batched query for all due services. empty if it failed */
+	static std::map<int, WmiService::State> refresh(const std::vector<Polled>&);
+	/** pushed by event source from its thread */
+	void onEvent(const QString& serviceName, WmiService::State);
+	void update(int id, Subscription&, WmiService::State);
+
+	struct WheelEntry
+	{
+		int id;
+		unsigned rounds; // full turns of wheel left before firing
+		bool once;
+	};
+	static constexpr size_t wheelSize = 64;
+
+protected:
+	const std::chrono::milliseconds m_tick;
+	std::mutex m_lock;
+	std::condition_variable m_wake;
+	bool m_stop = false, m_urgent = false;
+	int m_nextId = 0;
+	std::map<int, Subscription> m_subscriptions;
+	std::array<std::vector<WheelEntry>, wheelSize> m_wheel;
+	size_t m_cursor = 0;
+	std::unique_ptr<ServiceEventSource> m_events;
+	int m_localListener = -1;
+	bool m_watchDirty = false;
+	std::thread m_thread;
+};
+
+////////////////////////////////////////////////////////////////////////////////
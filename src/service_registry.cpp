@@ -0,0 +1,117 @@
+#include "service_registry.h"
+#include "local_supervisor.h"
+
+#include <QFileInfo>
+
+#include <QRegularExpression>
+
+#include <QDebug>
+
+////////////////////////////////////////////////////////////////////////////////
+
+pServiceControl ServiceRegistry::Entry::service() const
+{
+	if (local)
+		return local;
+	return std::make_shared<WmiService>(object);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+ServiceRegistry* ServiceRegistry::instance(SingletonPolicy policy)
+{
+	static ServiceRegistry* instance{ nullptr };
+	if (policy == Get && instance == nullptr)
+		instance = new ServiceRegistry;
+	if (policy == Release && instance != nullptr)
+		delete instance, instance = nullptr;
+	return instance;
+}
+
+void ServiceRegistry::enumerate()
+{
+	if (m_enumerated)
+		return;
+	m_services.clear();
+	m_byName.clear();
+	m_byExecutable.clear();
+	// local ones go first, so they shadow system services of the same name
+	for (const auto& local : LocalSupervisor::instance()->services())
+	{
+		const auto* d = LocalSupervisor::instance()->definition(local->name());
+		auto entry = std::make_shared<Entry>(Entry{
+			d->name,
+			d->name,
+			QString{ "local service" },
+			(QStringList{ d->command } + d->arguments).join(' '),
+			QFileInfo{ d->command }.fileName().toLower(),
+			tool::WmiObject{},
+			local });
+		m_services.push_back(entry);
+		m_byName.insert(entry->name, entry);
+		m_byExecutable.insert(entry->executable, entry);
+	}
+#ifdef Q_OS_WIN
+	for (const auto& object : tool::WmiObject::objects("service"))
+	{
+		WmiService service{ object };
+		auto entry = std::make_shared<Entry>(Entry{
+			service.name(),
+			service.property("DisplayName").toString(),
+			service.property("Description").toString(),
+			service.property("PathName").toString(),
+			service.executable().toLower(),
+			object,
+			nullptr });
+		if (m_byName.contains(entry->name))
+			continue;
+		m_services.push_back(entry);
+		m_byName.insert(entry->name, entry);
+		if (!entry->executable.isEmpty())
+			m_byExecutable.insert(entry->executable, entry);
+	}
+#endif
+	m_enumerated = true;
+	qDebug() << "services enumerated:" << m_services.size();
+}
+
+ServiceRegistry::Handle ServiceRegistry::find(const QString& name)
+{
+	auto lock = std::lock_guard{ m_lock };
+	enumerate();
+	const auto it = m_byName.find(name);
+	if (it != m_byName.end())
+		return it.value();
+	const QRegularExpression re{ name };
+	if (!re.isValid())
+		return nullptr;
+	for (const auto& entry : m_services)
+		if (re.match(entry->name).hasMatch())
+			return entry;
+	return nullptr;
+}
+
+ServiceRegistry::List ServiceRegistry::byExecutable(const QString& executable)
+{
+	auto lock = std::lock_guard{ m_lock };
+	enumerate();
+	List result;
+	for (const auto& entry : m_byExecutable.values(executable.toLower()))
+		result.push_back(entry);
+	return result;
+}
+
+ServiceRegistry::List ServiceRegistry::services()
+{
+	auto lock = std::lock_guard{ m_lock };
+	enumerate();
+	return m_services;
+}
+
+void ServiceRegistry::invalidate()
+{
+	auto lock = std::lock_guard{ m_lock };
+	m_enumerated = false;
+}
+
+////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,57 @@
+#pragma once
+#include "settings.h"
+#include "wmi_service.h"
+
+#include <QHash>
+#include <QMultiHash>
+
+#include <deque>
+#include <memory>
+#include <mutex>
+
+////////////////////////////////////////////////////////////////////////////////
+
+/** process-wide snapshot of system and local supervisor services. enumerated once, shared by all subscribers */
+class ServiceRegistry
+{
+public:
+	struct Entry
+	{
+		QString
+			name,
+			displayName,
+			description,
+			pathName,
+			executable;
+		tool::WmiObject object;
+		pServiceControl local; // set for services of local supervisor, object is empty then
+
+		/** own service object of subscriber, so it can be refreshed from any thread */
+		pServiceControl service() const;
+	};
+	using Handle = std::shared_ptr<const Entry>;
+	using List = std::deque<Handle>;
+
+	static ServiceRegistry* instance(SingletonPolicy = Get);
+
+	/** service by exact name, or first one matched by regular expression */
+	Handle find(const QString&);
+	/** services launched by executable (file name, case insensitive) */
+	List byExecutable(const QString&);
+	List services();
+	/** drop snapshot, next lookup enumerates services again */
+	void invalidate();
+
+protected:
+	ServiceRegistry() = default;
+	void enumerate();
+
+protected:
+	std::mutex m_lock;
+	bool m_enumerated = false;
+	List m_services;
+	QHash<QString, Handle> m_byName;
+	QMultiHash<QString, Handle> m_byExecutable;
+};
+
+////////////////////////////////////////////////////////////////////////////////
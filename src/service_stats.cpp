@@ -0,0 +1,120 @@
+#include "service_stats.h"
+
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonDocument>
+#include <QSaveFile>
+#include <QStringList>
+
+#include <QDebug>
+
+////////////////////////////////////////////////////////////////////////////////
+
+namespace
+{
+	const char* transitionNames[ServiceStatistics::TransitionCount]{ "start", "stop", "continue", "pause" };
+
+	QString duration(quint64 ms)
+	{
+		if (ms < 1000)
+			return QString{ "%1 ms" }.arg(ms);
+		return QString{ "%1 s" }.arg(ms / 1000., 0, 'f', ms < 10000 ? 1 : 0);
+	}
+} // namespace
+
+////////////////////////////////////////////////////////////////////////////////
+
+ServiceStatistics* ServiceStatistics::instance(SingletonPolicy policy)
+{
+	static ServiceStatistics* instance{ nullptr };
+	if (policy == Get && instance == nullptr)
+		instance = new ServiceStatistics;
+	if (policy == Release && instance != nullptr)
+		delete instance, instance = nullptr;
+	return instance;
+}
+
+ServiceStatistics::ServiceStatistics()
+	: m_path{ QFileInfo{ Settings::setup()->configPath() }.absoluteDir().absoluteFilePath("service_latency.json") }
+{
+	QFile file{ m_path };
+	if (!file.open(QIODevice::ReadOnly))
+		return;
+	const QJsonObject root = QJsonDocument::fromJson(file.readAll()).object();
+	for (auto it = root.begin(); it != root.end(); ++it)
+	{
+		Histograms* h = service(it.key());
+		const QJsonObject transitions = it.value().toObject();
+		for (int t = 0; t < TransitionCount; ++t)
+			h->transitions[t].merge(transitions.value(transitionNames[t]).toObject());
+	}
+}
+
+ServiceStatistics::~ServiceStatistics()
+{
+	save();
+}
+
+ServiceStatistics::Histograms* ServiceStatistics::service(const QString& name)
+{
+	auto lock = std::lock_guard{ m_lock };
+	auto& h = m_services[name];
+	if (!h)
+		h = std::make_unique<Histograms>();
+	return h.get();
+}
+
+void ServiceStatistics::save()
+{
+	QJsonObject root;
+	{
+		auto lock = std::lock_guard{ m_lock };
+		for (const auto& [name, h] : m_services)
+		{
+			QJsonObject transitions;
+			for (int t = 0; t < TransitionCount; ++t)
+				if (h->transitions[t].count() != 0)
+					transitions.insert(transitionNames[t], h->transitions[t].toJson());
+			if (!transitions.isEmpty())
+				root.insert(name, transitions);
+		}
+	}
+	QSaveFile file{ m_path };
+	if (!file.open(QIODevice::WriteOnly) || file.write(QJsonDocument{ root }.toJson()) < 0 || !file.commit())
+		qDebug() << "cant save" << m_path;
+}
+
+int ServiceStatistics::transition(WmiService::State pending, WmiService::State settled)
+{
+	if (pending == WmiService::StartPending && settled == WmiService::Running)
+		return Start;
+	if (pending == WmiService::StopPending && settled == WmiService::Stopped)
+		return Stop;
+	if (pending == WmiService::ContinuePending && settled == WmiService::Running)
+		return Continue;
+	if (pending == WmiService::PausePending && settled == WmiService::Paused)
+		return Pause;
+	return -1;
+}
+
+QString ServiceStatistics::summary(const Histograms& h)
+{
+	QStringList lines;
+	for (int t = 0; t < TransitionCount; ++t)
+	{
+		const auto& histogram = h.transitions[t];
+		const quint64 n = histogram.count();
+		if (n == 0)
+			continue;
+		lines.push_back(QString{ "%1: p50 %2, p95 %3, max %4 (%5)" }
+							.arg(transitionNames[t])
+							.arg(duration(histogram.percentile(50)))
+							.arg(duration(histogram.percentile(95)))
+							.arg(duration(histogram.max()))
+							.arg(n));
+	}
+	return lines.join('\n');
+}
+
+////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,51 @@
+#pragma once
+#include "histogram.h"
+#include "settings.h"
+#include "wmi_service.h"
+
+#include <array>
+#include <map>
+#include <memory>
+#include <mutex>
+
+////////////////////////////////////////////////////////////////////////////////
+
+/** per service histograms of state transition latencies (ms), kept across runs in service_latency.json */
+class ServiceStatistics
+{
+public:
+	enum Transition
+	{
+		Start,    // StartPending -> Running
+		Stop,     // StopPending -> Stopped
+		Continue, // ContinuePending -> Running
+		Pause,    // PausePending -> Paused
+		TransitionCount
+	};
+	struct Histograms
+	{
+		std::array<tool::LatencyHistogram, TransitionCount> transitions;
+	};
+
+	static ServiceStatistics* instance(SingletonPolicy = Get);
+	~ServiceStatistics();
+
+	/** created on first request, address stays valid until release */
+	Histograms* service(const QString&);
+	void save();
+
+	/** transition completed by settling in state, -1 if it doesnt complete pending one */
+	static int transition(WmiService::State pending, WmiService::State settled);
+	/** p50/p95/max lines for tooltip, empty if nothing recorded */
+	static QString summary(const Histograms&);
+
+protected:
+	ServiceStatistics();
+
+protected:
+	const QString m_path;
+	std::mutex m_lock;
+	std::map<QString, std::unique_ptr<Histograms>> m_services;
+};
+
+////////////////////////////////////////////////////////////////////////////////
@@ -79,7 +79,9 @@ struct Log
 		else
 		{
 			std::cout << "\n\n\n\n\n\nFUCK!!! EVERYTHING IS FUCKED UP! SHIT! DAMNT!" << std::endl;
+#ifdef Q_CC_MSVC
 			__asm { int 3 }
+#endif
 			throw std::runtime_error{ "fuckdup!" };
 		}
 	}
@@ -0,0 +1,213 @@
+#include "suggestion_index.h"
+
+#include <algorithm>
+#include <tuple>
+
+namespace tool
+{
+	////////////////////////////////////////////////////////////////////////////////
+
+	namespace
+	{
+		/** trigram similarity below which names arent suggested, pg_trgm default */
+		const double similarityLimit = 0.3;
+
+		quint32 pack(const std::string& s, size_t at)
+		{
+			return (static_cast<quint32>(static_cast<unsigned char>(s[at])) << 16)
+				| (static_cast<quint32>(static_cast<unsigned char>(s[at + 1])) << 8)
+				| static_cast<unsigned char>(s[at + 2]);
+		}
+
+		std::string key(const QString& name)
+		{
+			return name.toLower().toStdString();
+		}
+	} // namespace
+
+	////////////////////////////////////////////////////////////////////////////////
+
+	SuggestionIndex::SuggestionIndex(const QStringList& names)
+	{
+		std::unordered_map<std::string, int> known;
+		for (const auto& name : names)
+		{
+			std::string k = key(name);
+			if (k.empty() || !known.emplace(k, static_cast<int>(m_keys.size())).second)
+				continue;
+			const int id = static_cast<int>(m_keys.size());
+			m_names.push_back(name);
+			m_keys.push_back(std::move(k));
+
+			const std::vector<quint32> padded = trigrams(m_keys.back(), true);
+			m_trigramCounts.push_back(static_cast<int>(padded.size()));
+			std::vector<quint32> all = trigrams(m_keys.back(), false);
+			all.insert(all.end(), padded.begin(), padded.end());
+			std::sort(all.begin(), all.end());
+			all.erase(std::unique(all.begin(), all.end()), all.end());
+			for (const quint32 t : all)
+				m_postings[t].push_back(id);
+
+			if (m_tree.empty())
+			{
+				m_tree.push_back(Node{ id, {} });
+				continue;
+			}
+			for (size_t node = 0;;)
+			{
+				const int d = distance(m_keys[static_cast<size_t>(m_tree[node].name)], m_keys.back());
+				auto& children = m_tree[node].children;
+				const auto child = std::find_if(children.begin(), children.end(), [d](const auto& c) { return c.first == d; });
+				if (child != children.end())
+				{
+					node = static_cast<size_t>(child->second);
+					continue;
+				}
+				children.emplace_back(d, static_cast<int>(m_tree.size()));
+				m_tree.push_back(Node{ id, {} });
+				break;
+			}
+		}
+	}
+
+	int SuggestionIndex::size() const
+	{
+		return m_names.size();
+	}
+
+	int SuggestionIndex::distance(const std::string& a, const std::string& b)
+	{
+		// levenshtein, single row
+		std::vector<int> row(b.size() + 1);
+		for (size_t j = 0; j <= b.size(); ++j)
+			row[j] = static_cast<int>(j);
+		for (size_t i = 1; i <= a.size(); ++i)
+		{
+			int diagonal = row[0];
+			row[0] = static_cast<int>(i);
+			for (size_t j = 1; j <= b.size(); ++j)
+			{
+				const int up = row[j];
+				row[j] = std::min({ row[j] + 1, row[j - 1] + 1, diagonal + (a[i - 1] == b[j - 1] ? 0 : 1) });
+				diagonal = up;
+			}
+		}
+		return row[b.size()];
+	}
+
+	std::vector<quint32> SuggestionIndex::trigrams(const std::string& s, bool padded)
+	{
+		const std::string text = padded ? "  " + s + " " : s;
+		std::vector<quint32> result;
+		for (size_t i = 0; i + 3 <= text.size(); ++i)
+			result.push_back(pack(text, i));
+		std::sort(result.begin(), result.end());
+		result.erase(std::unique(result.begin(), result.end()), result.end());
+		return result;
+	}
+
+	std::vector<int> SuggestionIndex::shared(const std::vector<quint32>& query) const
+	{
+		std::vector<int> result(m_keys.size(), 0);
+		for (const quint32 t : query)
+		{
+			const auto it = m_postings.find(t);
+			if (it != m_postings.end())
+				for (const int id : it->second)
+					++result[static_cast<size_t>(id)];
+		}
+		return result;
+	}
+
+	QStringList SuggestionIndex::suggest(const QString& query, int k) const
+	{
+		const std::string q = key(query);
+		if (q.empty() || m_tree.empty() || k <= 0)
+			return {};
+
+		// names within few edits, bk-tree prunes by triangle inequality
+		const int tolerance = std::clamp(static_cast<int>(q.size()) / 3, 1, 3);
+		std::vector<int> distances(m_keys.size(), -1);
+		std::vector<size_t> stack{ 0 };
+		while (!stack.empty())
+		{
+			const Node& node = m_tree[stack.back()];
+			stack.pop_back();
+			const int d = distance(m_keys[static_cast<size_t>(node.name)], q);
+			distances[static_cast<size_t>(node.name)] = d;
+			for (const auto& [edge, child] : node.children)
+				if (edge >= d - tolerance && edge <= d + tolerance)
+					stack.push_back(static_cast<size_t>(child));
+		}
+
+		// names sharing enough of query, even when edits are many (reordered words)
+		const std::vector<quint32> padded = trigrams(q, true);
+		const std::vector<int> hits = shared(padded);
+		std::vector<std::tuple<int, double, int>> ranked; // distance, -similarity, name
+		for (size_t id = 0; id < m_keys.size(); ++id)
+		{
+			const double similarity = hits[id] == 0
+				? 0
+				: hits[id] / static_cast<double>(static_cast<int>(padded.size()) + m_trigramCounts[id] - hits[id]);
+			const bool near = distances[id] >= 0 && distances[id] <= tolerance;
+			if (!near && similarity < similarityLimit)
+				continue;
+			const int d = distances[id] >= 0 ? distances[id] : distance(m_keys[id], q);
+			ranked.emplace_back(d, -similarity, static_cast<int>(id));
+		}
+		const size_t count = std::min(ranked.size(), static_cast<size_t>(k));
+		std::partial_sort(ranked.begin(), ranked.begin() + static_cast<long>(count), ranked.end());
+		QStringList result;
+		for (size_t i = 0; i < count; ++i)
+			result.push_back(m_names[std::get<2>(ranked[i])]);
+		return result;
+	}
+
+	QStringList SuggestionIndex::search(const QString& query, int k) const
+	{
+		const std::string q = key(query);
+		std::vector<std::tuple<size_t, size_t, int>> found; // position, length, name
+		if (q.size() >= 3)
+		{ // substring holds every plain trigram of query
+			const std::vector<quint32> plain = trigrams(q, false);
+			const std::vector<int> hits = shared(plain);
+			for (size_t id = 0; id < m_keys.size(); ++id)
+			{
+				if (hits[id] != static_cast<int>(plain.size()))
+					continue;
+				const size_t at = m_keys[id].find(q);
+				if (at != std::string::npos)
+					found.emplace_back(at, m_keys[id].size(), static_cast<int>(id));
+			}
+		}
+		else
+		{ // too short for trigrams, few hundred names are scanned
+			for (size_t id = 0; id < m_keys.size(); ++id)
+			{
+				const size_t at = m_keys[id].find(q);
+				if (at != std::string::npos)
+					found.emplace_back(at, m_keys[id].size(), static_cast<int>(id));
+			}
+		}
+		std::sort(found.begin(), found.end());
+
+		QStringList result;
+		for (const auto& f : found)
+		{
+			if (result.size() >= k)
+				return result;
+			result.push_back(m_names[std::get<2>(f)]);
+		}
+		for (const auto& name : suggest(query, k))
+		{
+			if (result.size() >= k)
+				break;
+			if (!result.contains(name))
+				result.push_back(name);
+		}
+		return result;
+	}
+
+	////////////////////////////////////////////////////////////////////////////////
+
+} /* namespace tool */
@@ -0,0 +1,50 @@
+#pragma once
+#include <QStringList>
+
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace tool
+{
+	////////////////////////////////////////////////////////////////////////////////
+
+	/** fuzzy lookup over fixed set of names, built once. trigram index ranks names sharing
+		pieces of query and finds substrings, bk-tree finds names within few edits of it.
+		names are compared case insensitively, duplicates keep first spelling */
+	class SuggestionIndex
+	{
+	public:
+		explicit SuggestionIndex(const QStringList& names);
+
+		/** closest names by edit distance, then by shared trigrams, at most k */
+		QStringList suggest(const QString& query, int k) const;
+		/** names holding query, prefixes first, then suggestions, at most k */
+		QStringList search(const QString& query, int k) const;
+		int size() const;
+
+	protected:
+		struct Node
+		{
+			int name;
+			std::vector<std::pair<int, int>> children; // distance, node
+		};
+
+		static int distance(const std::string&, const std::string&);
+		/** distinct trigrams, padded as pg_trgm does ("  name ") or not */
+		static std::vector<quint32> trigrams(const std::string&, bool padded);
+		/** shared trigram count per name */
+		std::vector<int> shared(const std::vector<quint32>&) const;
+
+	protected:
+		QStringList m_names;
+		std::vector<std::string> m_keys; // lower case utf-8
+		std::vector<int> m_trigramCounts;  // padded trigrams per name
+		std::unordered_map<quint32, std::vector<int>> m_postings; // padded and plain trigrams
+		std::vector<Node> m_tree;
+	};
+
+	////////////////////////////////////////////////////////////////////////////////
+
+} /* namespace tool */
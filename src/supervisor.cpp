@@ -0,0 +1,192 @@
+#include "supervisor.h"
+
+#include <QJsonArray>
+#include <QJsonObject>
+#include <QProcess>
+#include <QTimer>
+
+#include <algorithm>
+#include <stdexcept>
+
+#ifdef Q_OS_WIN
+#	define VC_EXTRALEAN
+#	define WIN32_LEAN_AND_MEAN
+#	include <windows.h>
+#else
+#	include <cerrno>
+#	include <signal.h>
+#endif
+
+#include <QDebug>
+
+////////////////////////////////////////////////////////////////////////////////
+
+namespace
+{
+	/** process started by restart hasnt exited yet */
+	bool running(qint64 pid)
+	{
+#ifdef Q_OS_WIN
+		HANDLE process = ::OpenProcess(SYNCHRONIZE, FALSE, static_cast<DWORD>(pid));
+		if (process == nullptr)
+			return ::GetLastError() == ERROR_ACCESS_DENIED;
+		const bool result = ::WaitForSingleObject(process, 0) == WAIT_TIMEOUT;
+		::CloseHandle(process);
+		return result;
+#else
+		return ::kill(static_cast<pid_t>(pid), 0) == 0 || errno == EPERM;
+#endif
+	}
+} // namespace
+
+////////////////////////////////////////////////////////////////////////////////
+
+ProcessSupervisor::ProcessSupervisor(const QJsonArray& config, QObject* parent)
+	: QObject(parent)
+{
+	for (const auto& value : config)
+	{
+		if (!value.isObject())
+			throw std::runtime_error("supervise entry must be object");
+		const QJsonObject o = value.toObject();
+		Policy p;
+		p.pattern = QRegularExpression{ o.value("pattern").toString() };
+		p.command = o.value("command").toString();
+		p.directory = o.value("directory").toString();
+		for (const auto& arg : o.value("arguments").toArray())
+			p.arguments.push_back(arg.toString());
+		p.maxRestarts = o.value("maxRestarts").toInt(p.maxRestarts);
+		p.window = o.value("window").toInt(p.window);
+		p.backoff = o.value("backoff").toInt(p.backoff);
+		p.maxBackoff = o.value("maxBackoff").toInt(p.maxBackoff);
+		if (!p.pattern.isValid() || p.pattern.pattern().isEmpty() || p.command.isEmpty())
+			throw std::runtime_error("supervise entry requires pattern and command");
+		m_policies.emplace_back(std::move(p));
+	}
+}
+
+QStringList ProcessSupervisor::patterns() const
+{
+	QStringList result;
+	for (const auto& p : m_policies)
+		result.push_back(p.pattern.pattern());
+	return result;
+}
+
+ProcessSupervisor::Policy* ProcessSupervisor::policy(const QString& processName)
+{
+	for (auto& p : m_policies)
+		if (p.pattern.match(processName).hasMatch())
+			return &p;
+	return nullptr;
+}
+
+const ProcessSupervisor::Policy* ProcessSupervisor::policy(const QString& processName) const
+{
+	return const_cast<ProcessSupervisor*>(this)->policy(processName);
+}
+
+QString ProcessSupervisor::status(const QString& processName) const
+{
+	const Policy* p = policy(processName);
+	if (p == nullptr)
+		return QString{};
+	if (p->crashLoop)
+		return QString{ "crash loop" };
+	if (p->total == 0)
+		return QString{ "supervised" };
+	return QString{ "↻%1 last %2ms avg %3ms max %4ms" }
+		.arg(p->total)
+		.arg(p->lastLatency, 0, 'f', 0)
+		.arg(p->sumLatency / p->total, 0, 'f', 0)
+		.arg(p->maxLatency, 0, 'f', 0);
+}
+
+void ProcessSupervisor::ignoreDeath(int pid)
+{
+	m_ignored.insert(pid);
+}
+
+void ProcessSupervisor::processDied(int pid, const QString& processName)
+{
+	if (m_ignored.erase(pid) != 0)
+		return;
+	Policy* p = policy(processName);
+	if (p == nullptr || p->pending || p->crashLoop)
+		return;
+
+	const auto now = Clock::now();
+	while (!p->restarts.empty() && now - p->restarts.front() > std::chrono::milliseconds(p->window))
+		p->restarts.pop_front();
+	if (p->restarts.size() >= static_cast<size_t>(p->maxRestarts))
+	{
+		p->crashLoop = true;
+		qWarning() << "crash loop detected:" << processName << p->restarts.size() << "restarts in" << p->window << "ms";
+		emit crashLoopDetected(processName);
+		return;
+	}
+
+	p->diedAt = now;
+	p->pending = true;
+	// first restart goes immediately, following ones are backed off exponentially
+	const size_t attempt = p->restarts.size();
+	if (attempt == 0)
+		return launch(*p, processName);
+	const int delay = static_cast<int>(std::min<qint64>(p->maxBackoff,
+		static_cast<qint64>(p->backoff) << std::min<size_t>(attempt - 1, 20)));
+	const QString name = processName;
+	QTimer::singleShot(delay, this, [this, name]() {
+		if (Policy* p = policy(name))
+			launch(*p, name);
+	});
+}
+
+void ProcessSupervisor::processAppeared(int, const QString& processName)
+{
+	Policy* p = policy(processName);
+	if (p != nullptr && p->crashLoop)
+	{ // started by hand, supervision starts over
+		p->crashLoop = false;
+		p->restarts.clear();
+	}
+	if (p == nullptr || !p->pending)
+		return;
+	p->pending = false;
+	const double latency = std::chrono::duration<double, std::milli>(Clock::now() - p->diedAt).count();
+	++p->total;
+	p->lastLatency = latency;
+	p->sumLatency += latency;
+	p->maxLatency = std::max(p->maxLatency, latency);
+}
+
+void ProcessSupervisor::launch(Policy& p, const QString& processName)
+{
+	const auto launched = Clock::now();
+	p.restarts.push_back(launched);
+	qint64 pid = 0;
+	if (!QProcess::startDetached(p.command, p.arguments, p.directory, &pid))
+	{
+		qWarning() << "supervised restart failed:" << p.command;
+		p.pending = false;
+		return;
+	}
+	qInfo() << "supervised restart:" << p.command << "pid" << pid;
+	emit restarted(processName);
+
+	// process may die before monitor ever sees it, that is a death too. launched pid is
+	// followed until monitor reports the process, however long it takes to start
+	auto watchdog = new QTimer{ this };
+	QObject::connect(watchdog, &QTimer::timeout, this, [this, watchdog, processName, launched, pid]() {
+		Policy* p = policy(processName);
+		if (p == nullptr || !p->pending || p->restarts.empty() || p->restarts.back() != launched)
+			return watchdog->deleteLater();
+		if (running(pid))
+			return;
+		watchdog->deleteLater();
+		p->pending = false;
+		processDied(-1, processName);
+	});
+	watchdog->start(500);
+}
+
+////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,68 @@
+#pragma once
+#include <QObject>
+#include <QRegularExpression>
+#include <QStringList>
+
+#include <chrono>
+#include <deque>
+#include <set>
+
+class QJsonArray;
+
+////////////////////////////////////////////////////////////////////////////////
+
+/** opt-in restart of watched processes ("supervise" in qt_chooser.json) */
+class ProcessSupervisor : public QObject
+{
+	Q_OBJECT
+public:
+	using Clock = std::chrono::steady_clock;
+
+	struct Policy
+	{
+		QRegularExpression pattern;
+		QString command, directory;
+		QStringList arguments;
+		int maxRestarts = 5;     // restarts allowed inside window
+		int window = 60000;      // ms
+		int backoff = 500;       // ms, delay of second restart, doubles afterwards
+		int maxBackoff = 30000;  // ms
+
+		// runtime state
+		std::deque<Clock::time_point> restarts;
+		Clock::time_point diedAt;
+		bool pending = false, crashLoop = false;
+		unsigned total = 0;
+		double lastLatency = 0., sumLatency = 0., maxLatency = 0.; // ms, death -> new process observed
+	};
+
+	ProcessSupervisor(const QJsonArray&, QObject* = nullptr);
+
+	/** patterns that must be watched by process manager */
+	QStringList patterns() const;
+	/** supervision summary for a process row, empty if process isnt supervised */
+	QString status(const QString& processName) const;
+
+public slots:
+	/** watched process died. restart is launched right away or after backoff */
+	void processDied(int pid, const QString& processName);
+	/** watched process appeared, completes restart latency measurement */
+	void processAppeared(int pid, const QString& processName);
+	/** process is killed by user, its death must not trigger restart */
+	void ignoreDeath(int pid);
+
+signals:
+	void restarted(const QString& processName);
+	void crashLoopDetected(const QString& processName);
+
+protected:
+	Policy* policy(const QString& processName);
+	const Policy* policy(const QString& processName) const;
+	void launch(Policy&, const QString& processName);
+
+protected:
+	std::deque<Policy> m_policies;
+	std::set<int> m_ignored;
+};
+
+////////////////////////////////////////////////////////////////////////////////
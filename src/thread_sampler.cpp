@@ -0,0 +1,209 @@
+#include "thread_sampler.h"
+
+#include <QFile>
+
+#include <algorithm>
+#include <stdexcept>
+
+#ifdef Q_OS_WIN
+#	include "wmi.h"
+#else
+#	include <dirent.h>
+#	include <unistd.h>
+#endif
+
+namespace tool
+{
+	////////////////////////////////////////////////////////////////////////////////
+
+	ThreadSampler::ThreadSampler(int pid)
+		: m_pid(pid)
+	{}
+
+	int ThreadSampler::pid() const
+	{
+		return m_pid;
+	}
+
+	void ThreadSampler::reset()
+	{
+		m_previous.clear();
+	}
+
+	ThreadSampler::List ThreadSampler::sample()
+	{
+		const auto now = std::chrono::steady_clock::now();
+		Samples current = read();
+		std::sort(current.begin(), current.end(),
+			[](const Sample& l, const Sample& r) { return l.tid < r.tid; });
+
+		const double elapsed = m_previous.empty()
+			? 0.
+			: std::chrono::duration<double, std::micro>(now - m_timestamp).count();
+
+		List result;
+		result.reserve(current.size());
+		// both arrays are sorted by tid, so deltas are a single merge pass
+		auto prev = m_previous.cbegin();
+		for (const auto& s : current)
+		{
+			while (prev != m_previous.cend() && prev->tid < s.tid)
+				++prev;
+			Thread t{ s.tid, stateName(s.state), 0., s.switches < 0 ? -1. : 0. };
+			if (prev != m_previous.cend() && prev->tid == s.tid && elapsed > 0.)
+			{
+				if (s.cpuTime >= prev->cpuTime)
+					t.cpu = 100. * static_cast<double>(s.cpuTime - prev->cpuTime) / elapsed;
+				if (s.switches >= 0 && prev->switches >= 0 && s.switches >= prev->switches)
+					t.switchRate = 1e6 * static_cast<double>(s.switches - prev->switches) / elapsed;
+			}
+			result.push_back(t);
+		}
+
+		m_previous.swap(current);
+		m_timestamp = now;
+		return result;
+	}
+
+	QString ThreadSampler::stateName(char s)
+	{
+		switch (s)
+		{
+		case 'R': return QString{ "running" };
+		case 'S': return QString{ "sleeping" };
+		case 'D': return QString{ "disk wait" };
+		case 'Z': return QString{ "zombie" };
+		case 'T': return QString{ "stopped" };
+		case 't': return QString{ "traced" };
+		case 'I': return QString{ "idle" };
+		case 'W': return QString{ "waiting" };
+		case 'Y': return QString{ "ready" };
+		case 'B': return QString{ "standby" };
+		case 'N': return QString{ "initialized" };
+		case 'X': return QString{ "terminated" };
+		default: break;
+		}
+		return QString{ "unknown" };
+	}
+
+#ifdef Q_OS_WIN
+	ThreadSampler::Samples ThreadSampler::read() const
+	{
+		// Win32_Thread.ThreadState values
+		static const char states[] = { 'N', 'Y', 'R', 'B', 'X', 'W', 'W', '?' };
+		Samples result;
+		const auto threads = WmiObject::select(
+			QString{ "SELECT Handle, ThreadState, UserModeTime, KernelModeTime "
+					 "FROM Win32_Thread WHERE ProcessHandle = '%1'" }
+				.arg(m_pid));
+		result.reserve(threads.size());
+		for (const auto& thread : threads)
+		{
+			const auto value = [&thread](const char* name) {
+				const auto it = thread.find(name);
+				return (it == thread.end() ? QVariant{} : it->second.value);
+			};
+			const auto state = value("ThreadState").toUInt();
+			result.push_back(Sample{
+				value("Handle").toULongLong(),
+				// Win32_Thread reports times in milliseconds
+				(value("UserModeTime").toULongLong() + value("KernelModeTime").toULongLong()) * 1000,
+				-1,
+				states[state < sizeof(states) ? state : sizeof(states) - 1] });
+		}
+
+		// context switches are exposed by performance counters only
+		const auto counters = WmiObject::select(
+			QString{ "SELECT IDThread, ContextSwitchesPersec "
+					 "FROM Win32_PerfRawData_PerfProc_Thread WHERE IDProcess = %1" }
+				.arg(m_pid));
+		std::sort(result.begin(), result.end(),
+			[](const Sample& l, const Sample& r) { return l.tid < r.tid; });
+		for (const auto& counter : counters)
+		{
+			const auto idIt = counter.find("IDThread"),
+					   csIt = counter.find("ContextSwitchesPersec");
+			if (idIt == counter.end() || csIt == counter.end())
+				continue;
+			const quint64 tid = idIt->second.value.toULongLong();
+			auto it = std::lower_bound(result.begin(), result.end(), tid,
+				[](const Sample& s, quint64 id) { return s.tid < id; });
+			if (it != result.end() && it->tid == tid)
+				it->switches = csIt->second.value.toLongLong();
+		}
+		return result;
+	}
+#else
+	ThreadSampler::Samples ThreadSampler::read() const
+	{
+		static const long ticks = ::sysconf(_SC_CLK_TCK);
+		Samples result;
+		const QByteArray taskDir = QString{ "/proc/%1/task" }.arg(m_pid).toLocal8Bit();
+		DIR* dir = ::opendir(taskDir.constData());
+		if (dir == nullptr)
+			throw std::runtime_error{ "cannot open process task directory" };
+
+		while (dirent* entry = ::readdir(dir))
+		{
+			if (entry->d_name[0] < '0' || entry->d_name[0] > '9')
+				continue;
+			const QString base = QString{ "%1/%2" }.arg(QString::fromLocal8Bit(taskDir)).arg(entry->d_name);
+
+			QFile stat{ base + "/stat" };
+			if (!stat.open(QIODevice::ReadOnly))
+				continue; // thread is gone already
+			const QByteArray line = stat.readAll();
+			stat.close();
+			// comm may contain spaces and parens, fields start after the last ')'
+			const int commEnd = line.lastIndexOf(')');
+			if (commEnd < 0)
+				continue;
+			const QList<QByteArray> fields = line.mid(commEnd + 2).split(' ');
+			if (fields.size() < 13)
+				continue;
+
+			Sample s{ QByteArray{ entry->d_name }.toULongLong(), 0, -1, fields[0].isEmpty() ? '?' : fields[0].at(0) };
+			// utime and stime are fields 14 and 15 of stat
+			s.cpuTime = (fields[11].toULongLong() + fields[12].toULongLong()) * 1000000ull / static_cast<quint64>(ticks);
+
+			QFile status{ base + "/status" };
+			if (status.open(QIODevice::ReadOnly | QIODevice::Text))
+			{
+				while (!status.atEnd())
+				{
+					const QByteArray l = status.readLine();
+					if (l.startsWith("voluntary_ctxt_switches:") || l.startsWith("nonvoluntary_ctxt_switches:"))
+						s.switches = (s.switches < 0 ? 0 : s.switches) + l.mid(l.indexOf(':') + 1).trimmed().toLongLong();
+				}
+				status.close();
+			}
+			result.push_back(s);
+		}
+		::closedir(dir);
+		return result;
+	}
+#endif
+
+	////////////////////////////////////////////////////////////////////////////////
+
+	ThreadSampleTask::ThreadSampleTask(std::shared_ptr<ThreadSampler> sampler, bool reset)
+		: m_sampler(std::move(sampler))
+		, m_reset(reset)
+	{}
+
+	void ThreadSampleTask::run()
+	{
+		try
+		{
+			if (m_reset)
+				m_sampler->reset();
+			emit sampled(m_sampler->sample());
+		}
+		catch (const std::exception& e)
+		{
+			emit failed(QString{ e.what() });
+		}
+	}
+
+	////////////////////////////////////////////////////////////////////////////////
+} /* namespace tool */
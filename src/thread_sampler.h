@@ -0,0 +1,81 @@
+#pragma once
+#include <QMetaType>
+#include <QObject>
+#include <QRunnable>
+#include <QString>
+
+#include <chrono>
+#include <memory>
+#include <vector>
+
+namespace tool
+{
+	////////////////////////////////////////////////////////////////////////////////
+
+	/** per-thread cpu usage sampler of a single process */
+	class ThreadSampler
+	{
+	public:
+		struct Thread
+		{
+			quint64 tid;
+			QString state;
+			/** cpu usage since previous sample, percents of one core */
+			double cpu;
+			/** context switches per second since previous sample, < 0 if unavailable */
+			double switchRate;
+		};
+		using List = std::vector<Thread>;
+
+		ThreadSampler(int pid);
+
+		int pid() const;
+		/** take a new sample and compute deltas against the previous one */
+		List sample();
+		/** forget previous sample (next sample() reports zero deltas) */
+		void reset();
+
+	protected:
+		/** raw counters, kept sorted by tid */
+		struct Sample
+		{
+			quint64 tid;
+			quint64 cpuTime; // microseconds
+			qint64 switches; // total context switches, -1 if unavailable
+			char state;
+		};
+		using Samples = std::vector<Sample>;
+
+		Samples read() const;
+		static QString stateName(char);
+
+	protected:
+		const int m_pid;
+		Samples m_previous;
+		std::chrono::steady_clock::time_point m_timestamp;
+	};
+
+	////////////////////////////////////////////////////////////////////////////////
+
+	/** one sample() off gui thread, wmi queries take tens of ms. caller keeps at most one
+		task per sampler running, so sampler needs no lock */
+	class ThreadSampleTask : public QObject, public QRunnable
+	{
+		Q_OBJECT
+	public:
+		ThreadSampleTask(std::shared_ptr<ThreadSampler>, bool reset);
+		void run() override;
+
+	signals:
+		void sampled(const tool::ThreadSampler::List&);
+		void failed(const QString&);
+
+	protected:
+		const std::shared_ptr<ThreadSampler> m_sampler;
+		const bool m_reset;
+	};
+
+	////////////////////////////////////////////////////////////////////////////////
+} /* namespace tool */
+
+Q_DECLARE_METATYPE(tool::ThreadSampler::List);
@@ -1,10 +1,15 @@
 #include "tooling.h"
-#define WIN32_LEAN_AND_MEAN
-#include <windows.h>
-#include <winioctl.h> // DeviceIoControl
 
+#include <QFile>
 #include <QFileInfo>
 
+#include <stdexcept>
+
+#ifdef Q_OS_WIN
+#	define WIN32_LEAN_AND_MEAN
+#	include <windows.h>
+#	include <winioctl.h> // DeviceIoControl
+
 ////////////////////////////////////////////////////////////////////////////////
 /* #include <ntifs.h> */
 
@@ -38,6 +43,7 @@ typedef struct _REPARSE_DATA_BUFFER
 		} GenericReparseBuffer;
 	} DUMMYUNIONNAME;
 } REPARSE_DATA_BUFFER, *PREPARSE_DATA_BUFFER;
+#endif
 
 ////////////////////////////////////////////////////////////////////////////////
 namespace tool
@@ -52,6 +58,12 @@ namespace tool
 	{
 		if (m_mountPoint.isEmpty())
 			throw std::runtime_error("empty mount point");
+#ifndef Q_OS_WIN
+		const QString result = QFileInfo{ m_mountPoint }.symLinkTarget();
+		if (result.isEmpty())
+			throw std::runtime_error("invalid mounting point");
+		return result;
+#else
 		HANDLE handle = CreateFileW(
 			reinterpret_cast<const wchar_t*>(m_mountPoint.utf16()), 0,
 			FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr, OPEN_EXISTING,
@@ -101,21 +113,32 @@ namespace tool
 		::CloseHandle(handle);
 		delete[] buffer, buffer = nullptr;
 		return result;
+#endif
 	}
 
 	void symlink::link(const QString& target)
 	{
+#ifdef Q_OS_WIN
 		::CreateSymbolicLinkW(
 			reinterpret_cast<const wchar_t*>(m_mountPoint.utf16()),
 			reinterpret_cast<const wchar_t*>(target.utf16()),
 			SYMBOLIC_LINK_FLAG_DIRECTORY);
+#else
+		QFile::link(target, m_mountPoint);
+#endif
 	}
 
 	void symlink::unlink()
 	{
+#ifdef Q_OS_WIN
 		if (QFileInfo(m_mountPoint).exists())
 			::RemoveDirectoryW(
 				reinterpret_cast<const wchar_t*>(m_mountPoint.utf16()));
+#else
+		// link itself is removed, never directory it points to
+		if (QFileInfo(m_mountPoint).isSymLink())
+			QFile::remove(m_mountPoint);
+#endif
 	}
 
 	////////////////////////////////////////////////////////////////////////////////
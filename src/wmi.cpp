@@ -1,16 +1,19 @@
 #include "wmi.h"
 #include <stdexcept>
 #include <utility>
-#define _WIN32_DCOM
-#include <comdef.h>
-#include <Wbemidl.h>
+#ifdef Q_OS_WIN
+#	define _WIN32_DCOM
+#	include <comdef.h>
+#	include <Wbemidl.h>
 
-#pragma comment(lib, "wbemuuid.lib")
+#	pragma comment(lib, "wbemuuid.lib")
 
-#include <ActiveQt/qaxtypes.h>
-#include <private/qmetaobjectbuilder_p.h>
+#	include <ActiveQt/qaxtypes.h>
+#	include <private/qmetaobjectbuilder_p.h>
+#endif
 
 #include <atomic>
+#include <mutex>
 
 // debug includes
 #include <iostream>
@@ -22,6 +25,18 @@ namespace tool
 
 	////////////////////////////////////////////////////////////////////////////////
 
+	WmiProperty::operator QVariant() const { return value; }
+
+	QVariant::Type WmiProperty::type() const { return value.type(); }
+
+	QString WmiProperty::toString() const { return value.toString(); }
+
+	const ushort* WmiProperty::utf16() const { return name.utf16(); }
+
+	////////////////////////////////////////////////////////////////////////////////
+
+#ifdef Q_OS_WIN
+
 	QVariant::Type cim2qvariant(const CIMTYPE ct)
 	{
 		CIMTYPE_ENUMERATION ce = static_cast<CIMTYPE_ENUMERATION>(ct);
@@ -356,16 +371,6 @@ namespace tool
 
 	////////////////////////////////////////////////////////////////////////////////
 
-	WmiProperty::operator QVariant() const { return value; }
-
-	QVariant::Type WmiProperty::type() const { return value.type(); }
-
-	QString WmiProperty::toString() const { return value.toString(); }
-
-	const ushort* WmiProperty::utf16() const { return name.utf16(); }
-
-	////////////////////////////////////////////////////////////////////////////////
-
 	WmiObject::WmiObject()
 	{
 		setObjectName("WmiObject");
@@ -668,6 +673,36 @@ namespace tool
 		return result;
 	}
 
+	const std::deque<WmiObject::PropertyList> WmiObject::select(const QString& wql)
+	{
+		bstr_wrapper
+			language{ QString{ "WQL" } },
+			request{ wql };
+		IEnumWbemClassObject* pEnumerator = NULL;
+
+		COMP(&IWbemServices::ExecQuery, CoInitialize::services(), language, request,
+			WBEM_FLAG_RETURN_IMMEDIATELY | WBEM_FLAG_FORWARD_ONLY,
+			NULL,
+			&pEnumerator);
+
+		IWbemClassObject* obj = NULL;
+		ULONG uReturn = 0;
+
+		std::deque<PropertyList> result;
+		while (pEnumerator)
+		{
+			COMP(&IEnumWbemClassObject::Next, pEnumerator,
+				WBEM_INFINITE, 1, &obj, &uReturn);
+			if (0 == uReturn)
+				break;
+			result.emplace_back(properties(obj));
+			obj->Release();
+		}
+		if (pEnumerator != nullptr)
+			pEnumerator->Release();
+		return result;
+	}
+
 	WmiObject WmiObject::object(const QString& name)
 	{
 		bstr_wrapper objectName{ QString{ "Win32_%1" }.arg(name) };
@@ -890,15 +925,18 @@ namespace tool
 
 	struct WmiNotification::impl : public IWbemObjectSink
 	{
-		std::atomic_int m_refCount;
+		std::atomic_ulong m_refCount{ 1 };
+		std::mutex m_lock;
+		Callback m_callback;
+
 		virtual ULONG STDMETHODCALLTYPE AddRef() override
 		{
-			return m_refCount++;
+			return ++m_refCount;
 		}
 
 		virtual ULONG STDMETHODCALLTYPE Release() override
 		{
-			auto result = (m_refCount--);
+			const auto result = --m_refCount;
 			if (result == 0)
 				delete this;
 			return result;
@@ -920,9 +958,30 @@ namespace tool
 			/* [in] */ LONG lObjectCount,
 			/* [size_is][in] */ IWbemClassObject __RPC_FAR* __RPC_FAR* apObjArray) override
 		{
-			qDebug() << "indicate!";
-			Q_UNUSED(lObjectCount);
-			Q_UNUSED(apObjArray);
+			auto lock = std::lock_guard{ m_lock };
+			if (!m_callback)
+				return WBEM_S_NO_ERROR;
+			for (LONG i = 0; i < lObjectCount; ++i)
+			{
+				try
+				{
+					IWbemClassObject* event = apObjArray[i];
+					IWbemClassObject* target = nullptr;
+					VARIANT vtTarget;
+					VariantInit(&vtTarget);
+					if (SUCCEEDED(event->Get(L"TargetInstance", 0, &vtTarget, nullptr, nullptr))
+						&& vtTarget.vt == VT_UNKNOWN && vtTarget.punkVal != nullptr)
+						vtTarget.punkVal->QueryInterface(IID_IWbemClassObject, reinterpret_cast<void**>(&target));
+					VariantClear(&vtTarget);
+					m_callback(WmiObject::properties(target != nullptr ? target : event));
+					if (target != nullptr)
+						target->Release();
+				}
+				catch (const std::exception& e)
+				{
+					qDebug() << "indicate" << e.what();
+				}
+			}
 			return WBEM_S_NO_ERROR;
 		}
 
@@ -932,9 +991,9 @@ namespace tool
 			/* [in] */ BSTR strParam,
 			/* [in] */ IWbemClassObject __RPC_FAR* pObjParam) override
 		{
-			qDebug() << "set status";
-			Q_UNUSED(lFlags);
-			Q_UNUSED(hResult);
+			// WBEM_STATUS_COMPLETE arrives after cancel or when query has failed
+			if (lFlags == WBEM_STATUS_COMPLETE && FAILED(hResult) && hResult != WBEM_E_CALL_CANCELLED)
+				qDebug() << "notification failed 0x" << QString::number(static_cast<quint32>(hResult), 16);
 			Q_UNUSED(strParam);
 			Q_UNUSED(pObjParam);
 			return WBEM_S_NO_ERROR;
@@ -943,14 +1002,176 @@ namespace tool
 
 	////////////////////////////////////////////////////////////////////////////////
 
-	WmiNotification::WmiNotification()
-		: m_impl{ std::make_shared<impl>() }
+	WmiNotification::WmiNotification(const QString& wql, Callback callback)
+		: m_impl{ new impl, [](impl* sink) { sink->Release(); } }
 	{
-		qDebug() << "hello world";
+		m_impl->m_callback = std::move(callback);
+		bstr_wrapper
+			language{ QString{ "WQL" } },
+			request{ wql };
+		COMP(&IWbemServices::ExecNotificationQueryAsync, CoInitialize::services(),
+			language, request, WBEM_FLAG_SEND_STATUS, nullptr, m_impl.get());
 	}
 
 	WmiNotification::~WmiNotification()
-	{}
+	{
+		{ // waits for callback in flight
+			auto lock = std::lock_guard{ m_impl->m_lock };
+			m_impl->m_callback = nullptr;
+		}
+		CoInitialize::services()->CancelAsyncCall(m_impl.get());
+	}
+
+#else
+	// no wmi: objects carry no instance, queries find nothing, calls and subscriptions throw
+
+	CoInitialize::CoInitialize() {}
+
+	CoInitialize::~CoInitialize() {}
+
+	IWbemLocator* CoInitialize::locator(SingletonPolicy)
+	{
+		return nullptr;
+	}
+
+	IWbemServices* CoInitialize::services(SingletonPolicy)
+	{
+		return nullptr;
+	}
+
+	WmiObject::WmiObject()
+	{
+		setObjectName("WmiObject");
+	}
+
+	WmiObject::WmiObject(IWbemClassObject*, const QString&)
+	{
+		throw std::runtime_error("wmi is available on windows only");
+	}
+
+	WmiObject::WmiObject(const WmiObject& o)
+		: m_properties(o.m_properties)
+		, m_methods(o.m_methods)
+	{
+		setObjectName("WmiObject");
+	}
+
+	WmiObject::~WmiObject() {}
+
+	IWbemClassObject* WmiObject::object() const
+	{
+		return m_object;
+	}
+
+	WmiObject::operator QVariant() const
+	{
+		return QVariant::fromValue((void*)this);
+	}
+
+	void WmiObject::updateObject() {}
+
+	WmiObject WmiObject::spawnInstance() const
+	{
+		throw std::runtime_error("wmi is available on windows only");
+	}
+
+	int WmiObject::method(const QByteArray&, const QVariantList&, Qt::ConnectionType) const
+	{
+		throw std::runtime_error("wmi is available on windows only");
+	}
+
+	WmiObject& WmiObject::operator=(const WmiObject& o)
+	{
+		m_properties = o.m_properties;
+		m_methods = o.m_methods;
+		return *this;
+	}
+
+	WmiObject& WmiObject::operator=(WmiObject&& o)
+	{
+		m_properties = std::move(o.m_properties);
+		m_methods = std::move(o.m_methods);
+		return *this;
+	}
+
+	void WmiObject::execMethod(const MethodDefinition&, void**)
+	{
+		throw std::runtime_error("wmi is available on windows only");
+	}
+
+	const WmiObject::List WmiObject::objects(const QString&)
+	{
+		return List{};
+	}
+
+	const std::deque<WmiObject::PropertyList> WmiObject::select(const QString&)
+	{
+		return std::deque<PropertyList>{};
+	}
+
+	WmiObject WmiObject::object(const QString&)
+	{
+		throw std::runtime_error("wmi is available on windows only");
+	}
+
+	const std::deque<std::pair<QString, QVariant>> WmiObject::qualifiers(IWbemClassObject*)
+	{
+		return {};
+	}
+
+	const WmiObject::PropertyList WmiObject::properties(IWbemClassObject*, bool)
+	{
+		return PropertyList{};
+	}
+
+	const WmiObject::MethodList WmiObject::methods(IWbemClassObject*)
+	{
+		return MethodList{};
+	}
+
+	const QString WmiObject::getObjectText(IWbemClassObject*)
+	{
+		return QString{};
+	}
+
+	QString WmiObject::createSignature(const MethodDefinition& md)
+	{
+		return md.first;
+	}
+
+	QList<QByteArray> WmiObject::getParameterNames(const MethodDefinition&)
+	{
+		return QList<QByteArray>{};
+	}
+
+	const QMetaObject* WmiObject::metaObject() const
+	{
+		return QObject::metaObject();
+	}
+
+	int WmiObject::qt_metacall(QMetaObject::Call c, int id, void** arg)
+	{
+		return QObject::qt_metacall(c, id, arg);
+	}
+
+	void* WmiObject::qt_metacast(const char* name)
+	{
+		return QObject::qt_metacast(name);
+	}
+
+	void WmiObject::qt_static_metacall(QObject*, QMetaObject::Call, int, void**) {}
+
+	struct WmiNotification::impl
+	{
+	};
+
+	WmiNotification::WmiNotification(const QString&, Callback)
+	{
+		throw std::runtime_error("wmi is available on windows only");
+	}
+
+	WmiNotification::~WmiNotification() {}
+#endif
 
 	////////////////////////////////////////////////////////////////////////////////
 } /* namespace tool */
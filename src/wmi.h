@@ -3,6 +3,8 @@
 #include <QVariant>
 
 #include <deque>
+#include <functional>
+#include <memory>
 #include <set>
 
 struct IWbemLocator;
@@ -77,7 +79,8 @@ namespace tool
 		~WmiObject();
 		IWbemClassObject* object() const;
 		operator QVariant() const;
-		void updateObject();
+		/** refetch instance by its __PATH */
+		virtual void updateObject();
 		WmiObject spawnInstance() const;
 		int method(const QByteArray&, const QVariantList& = QVariantList{}, Qt::ConnectionType = Qt::DirectConnection) const;
 
@@ -86,8 +89,11 @@ namespace tool
 
 		static const List objects(const QString&);
 		static WmiObject object(const QString&);
+		/** run WQL query, returns only property values (no dynamic metaobject built) */
+		static const std::deque<PropertyList> select(const QString&);
 
 	protected:
+		friend class WmiNotification;
 		WmiObject(IWbemClassObject*, const QString& = QString{});
 		static QString createSignature(const MethodDefinition&);
 		static QList<QByteArray> getParameterNames(const MethodDefinition&);
@@ -107,11 +113,18 @@ namespace tool
 
 	////////////////////////////////////////////////////////////////////////////////
 
+	/** asynchronous WQL event subscription (ExecNotificationQueryAsync) */
 	class WmiNotification
 	{
 	public:
-		WmiNotification();
+		/** invoked on COM thread with TargetInstance of event (or event itself if it has none) */
+		using Callback = std::function<void(const WmiObject::PropertyList&)>;
+
+		WmiNotification(const QString& wql, Callback);
+		/** cancels subscription, callback is never invoked after return */
 		~WmiNotification();
+		WmiNotification(const WmiNotification&) = delete;
+		WmiNotification& operator=(const WmiNotification&) = delete;
 
 	protected:
 		struct impl;
@@ -27,6 +27,11 @@ QString WmiProcess::commandLine() const
 	return property("CommandLine").toString();
 }
 
+tool::CommandLine WmiProcess::arguments() const
+{
+	return tool::CommandLine{ commandLine(), tool::CommandLine::Windows };
+}
+
 int WmiProcess::processID() const
 {
 	return property("ProcessId").toInt();
@@ -1,4 +1,5 @@
 #pragma once
+#include "command_line.h"
 #include "wmi.h"
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -63,6 +64,8 @@ public:
 	QString caption() const;
 	/** Command line used to start a specific process, if applicable. */
 	QString commandLine() const;
+	/** CommandLine property split by windows rules */
+	tool::CommandLine arguments() const;
 	/** Numeric identifier used to distinguish one process from another. */
 	int processID() const;
 	/** Name of the executable file responsible for the process, equivalent to the Image Name property in Task Manager */
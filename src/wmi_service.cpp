@@ -1,5 +1,4 @@
 #include "wmi_service.h"
-#include <QRegularExpression>
 
 ////////////////////////////////////////////////////////////////////////////////
 
@@ -8,34 +7,24 @@ WmiService::WmiService(const tool::WmiObject& o)
 {
 }
 
+void WmiService::updateObject()
+{
+	const QString pathName = property("PathName").toString();
+	tool::WmiObject::updateObject();
+	if (property("PathName").toString() != pathName)
+		m_commandLine.reset();
+}
+
+const tool::CommandLine& WmiService::commandLine() const
+{
+	if (!m_commandLine)
+		m_commandLine = std::make_shared<const tool::CommandLine>(property("PathName").toString(), tool::CommandLine::Windows);
+	return *m_commandLine;
+}
+
 const QString WmiService::executableKeyData(const QString& key)
 {
-	const auto extractKeyData = [&key](const QStringList& args) {
-		QStringList result;
-		bool skip = false, push = false;
-		for (const auto& arg : args)
-		{
-			if (arg.startsWith('"'))
-				skip = true;
-			if (arg.endsWith('"'))
-				skip = false;
-			if (push)
-			{
-				result.push_back(arg);
-				if (!skip)
-					break;
-			}
-			if (skip)
-				continue;
-			if (arg == key)
-				push = true;
-		}
-		const auto path = result.join(' ');
-		if (path.startsWith('"') && path.endsWith('"'))
-			return path.mid(1, path.size() - 2);
-		return result.join(" ");
-	};
-	return extractKeyData(fullPath().split(' '));
+	return commandLine().value(key).replace('\\', '/');
 }
 
 const QString WmiService::fullPath() const
@@ -48,27 +37,17 @@ const QString WmiService::fullPath() const
 
 const QString WmiService::path() const
 {
-	static const QRegularExpression startWithQuotes{ "^\"([^\"]+).*$" },
-		plainRun{ "^(.+\\.(exe|dll|sys)).*$" };
-	const QString p = property("PathName").toString();
-	return (p.startsWith('\"')
-			? startWithQuotes.match(p).captured(1)
-			: plainRun.match(p).captured(1))
-		.replace('\\', '/');
+	return commandLine().program();
 }
 
 const QString WmiService::executable() const
 {
-	static const QRegularExpression exec{ "^.+/(.+\\.(exe|dll|sys))" };
-	const QString path{ this->path() };
-	return exec.match(path).captured(1);
+	return commandLine().programName();
 }
 
 const QString WmiService::executableDirectory() const
 {
-	static const QRegularExpression exec{ "^(.+/)(.+\\.(exe|dll|sys))" };
-	const QString path{ this->path() };
-	return exec.match(path).captured(1);
+	return commandLine().programDirectory();
 }
 
 const QString WmiService::name() const
@@ -77,6 +56,12 @@ const QString WmiService::name() const
 }
 
 WmiService::State WmiService::state()
+{
+	updateObject();
+	return parseState(this->property("State").toString());
+}
+
+WmiService::State WmiService::parseState(const QString& stateString)
 {
 	static const std::map<QString, State> serviceStatuses{
 		{ "Stopped", Stopped },
@@ -88,9 +73,6 @@ WmiService::State WmiService::state()
 		{ "Paused", Paused },
 		{ "Unknown", Unknown },
 	};
-	updateObject();
-
-	const auto stateString = this->property("State").toString();
 	const auto s = serviceStatuses.find(stateString);
 	if (s == serviceStatuses.end())
 		throw std::runtime_error("no statuse found");
@@ -1,23 +1,14 @@
 #pragma once
+#include "command_line.h"
+#include "service_control.h"
 #include "wmi.h"
 #include <memory>
 
 ////////////////////////////////////////////////////////////////////////////////
 
-class WmiService : public tool::WmiObject
+class WmiService : public tool::WmiObject, public ServiceControl
 {
 public:
-	enum State
-	{
-		Unknown,
-		Stopped,
-		Running,
-		Paused,
-		StartPending,
-		StopPending,
-		ContinuePending,
-		PausePending,
-	};
 	enum StartMode
 	{
 		Boot,
@@ -28,20 +19,29 @@ public:
 	};
 
 	WmiService(const tool::WmiObject&);
+	void updateObject() override;
+	/** PathName parsed once, parsed again only if update brings another PathName */
+	const tool::CommandLine& commandLine() const;
 	const QString executableKeyData(const QString&);
 	const QString fullPath() const;
-	const QString path() const;
+	const QString path() const override;
 	const QString executable() const;
 	const QString executableDirectory() const;
-	const QString name() const;
-	State state();
+	const QString name() const override;
+	State state() override;
 	StartMode startMode() const;
 
+	/** Win32_Service.State string to enum */
+	static State parseState(const QString&);
+
 public slots:
 
-	int start();
-	int stop();
-	int resume();
+	int start() override;
+	int stop() override;
+	int resume() override;
+
+protected:
+	mutable std::shared_ptr<const tool::CommandLine> m_commandLine;
 };
 
 using pWmiService = std::shared_ptr<WmiService>;
@@ -0,0 +1,22 @@
+# vi: fenc=utf8
+TEMPLATE = app
+QT += testlib widgets gui core
+win32: QT += core-private axcontainer
+TARGET = tst_pg_ctl
+
+CONFIG -= debug_and_release debug_and_release_target
+CONFIG += release c++17 testcase
+
+DEFINES += QT_DEPRECATED_WARNINGS
+
+# whole application but its main, ClusterControl reaches settings, statistics and versions
+INCLUDEPATH += ../../src
+SOURCES += \
+			$$files(../../src/*.cpp) \
+			tst_pg_ctl.cpp
+SOURCES -= ../../src/main.cpp
+
+HEADERS += \
+			$$files(../../src/*.h)
+
+FORMS += $$files(../../ui/*.ui)
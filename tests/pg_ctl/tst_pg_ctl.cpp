@@ -0,0 +1,179 @@
+#include "pg_ctl.h"
+#include "pg_pid_file.h"
+#include "settings.h"
+
+#include <QFile>
+#include <QSignalSpy>
+#include <QStandardPaths>
+#include <QTemporaryDir>
+#include <QtTest>
+
+////////////////////////////////////////////////////////////////////////////////
+
+namespace
+{
+	/** stand-in pg_ctl. mode comes from PG_CTL_STANDIN: ready writes starting and then
+		ready postmaster.pid, late does the same after half a second, fail exits with error,
+		hang writes starting pid file and sleeps. stop removes pid file */
+	const char* const standIn = R"(#!/bin/sh
+cmd="$1"
+while [ $# -gt 0 ]; do
+	if [ "$1" = "-D" ]; then dir="$2"; fi
+	shift
+done
+pid="$dir/postmaster.pid"
+write() {
+	printf '%s\n%s\n%s\n5432\n/tmp\n*\n  5432001 0\n%s\n' $$ "$dir" "$(date +%s)" "$1" > "$pid"
+}
+case "$PG_CTL_STANDIN:$cmd" in
+late:start)
+	sleep 0.5
+	write starting
+	sleep 0.2
+	write ready
+	echo "server started"
+	;;
+ready:start)
+	write starting
+	sleep 0.2
+	write ready
+	echo "server started"
+	;;
+fail:start)
+	echo "could not start server"
+	exit 1
+	;;
+hang:start)
+	write starting
+	exec sleep 30
+	;;
+*:stop)
+	sleep 0.2
+	rm -f "$pid"
+	echo "server stopped"
+	;;
+esac
+)";
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+class ClusterControlTest : public QObject
+{
+	Q_OBJECT
+private slots:
+	void initTestCase();
+	void cleanupTestCase();
+	void init();
+
+	void startReady();
+	void startFailed();
+	void startTimeout();
+	void startOverStale();
+	void stop();
+
+private:
+	/** runs operation to its finished signal, returns its arguments, empty if it didnt finish once */
+	QList<QVariant> run(const QString& mode, bool start);
+
+	QTemporaryDir m_dir;
+	QString m_cluster;
+	QString m_program;
+};
+
+void ClusterControlTest::initTestCase()
+{
+	QStandardPaths::setTestModeEnabled(true);
+	QVERIFY(m_dir.isValid());
+	m_cluster = m_dir.filePath("cluster");
+	QVERIFY(QDir{ m_dir.path() }.mkpath("cluster"));
+	m_program = m_dir.filePath("pg_ctl");
+	QFile script{ m_program };
+	QVERIFY(script.open(QIODevice::WriteOnly));
+	script.write(standIn);
+	script.close();
+	QVERIFY(script.setPermissions(QFile::ReadOwner | QFile::WriteOwner | QFile::ExeOwner));
+	Settings::setup()->set("pg_ctl_timeout", 2000);
+	Settings::setup()->set("pg_ctl_log", "");
+}
+
+void ClusterControlTest::cleanupTestCase()
+{
+	Settings::setup(Release);
+}
+
+void ClusterControlTest::init()
+{
+	QFile::remove(QDir{ m_cluster }.filePath("postmaster.pid"));
+}
+
+QList<QVariant> ClusterControlTest::run(const QString& mode, bool start)
+{
+	qputenv("PG_CTL_STANDIN", mode.toLocal8Bit());
+	pg::ClusterControl control{ pg::PGVersion{}, m_cluster };
+	control.setProgram(m_program);
+	QSignalSpy finished{ &control, &pg::ClusterControl::finished };
+	start ? control.start(5432) : control.stop();
+	if (!finished.wait(10000) || finished.size() != 1 || control.busy())
+		return QList<QVariant>{};
+	return finished.takeFirst();
+}
+
+void ClusterControlTest::startReady()
+{
+	const QList<QVariant> result = run("ready", true);
+	QCOMPARE(result.size(), 4);
+	QCOMPARE(result[0].toInt(), static_cast<int>(pg::ClusterControl::Start));
+	QVERIFY2(result[1].toBool(), qPrintable(result[3].toString()));
+	QVERIFY(result[2].toLongLong() >= 200);
+	QCOMPARE(pg::PidFile{ QDir{ m_cluster }.filePath("postmaster.pid") }.status, pg::PidFile::Ready);
+}
+
+void ClusterControlTest::startFailed()
+{
+	const QList<QVariant> result = run("fail", true);
+	QCOMPARE(result.size(), 4);
+	QVERIFY(!result[1].toBool());
+	QVERIFY(result[3].toString().contains("could not start server"));
+	QVERIFY(result[3].toString().contains("exited with code 1"));
+}
+
+void ClusterControlTest::startTimeout()
+{
+	const QList<QVariant> result = run("hang", true);
+	QCOMPARE(result.size(), 4);
+	QVERIFY(!result[1].toBool());
+	QVERIFY(result[2].toLongLong() >= 2000);
+	QVERIFY(result[3].toString().contains("no result in 2000 ms"));
+}
+
+void ClusterControlTest::startOverStale()
+{
+	// crashed server leaves its pid file saying ready
+	const QString path = QDir{ m_cluster }.filePath("postmaster.pid");
+	QFile stale{ path };
+	QVERIFY(stale.open(QIODevice::WriteOnly));
+	stale.write(QString{ "999999\n%1\n0\n5432\n/tmp\n*\n  5432001 0\nready\n" }.arg(m_cluster).toLocal8Bit());
+	stale.close();
+
+	const QList<QVariant> result = run("late", true);
+	QCOMPARE(result.size(), 4);
+	QVERIFY2(result[1].toBool(), qPrintable(result[3].toString()));
+	QVERIFY(result[2].toLongLong() >= 700);
+	const pg::PidFile pid{ path };
+	QCOMPARE(pid.status, pg::PidFile::Ready);
+	QVERIFY(pid.pid != 999999);
+}
+
+void ClusterControlTest::stop()
+{
+	QCOMPARE(run("ready", true).value(1).toBool(), true);
+	const QList<QVariant> result = run("ready", false);
+	QCOMPARE(result.size(), 4);
+	QCOMPARE(result[0].toInt(), static_cast<int>(pg::ClusterControl::Stop));
+	QVERIFY2(result[1].toBool(), qPrintable(result[3].toString()));
+	QVERIFY(!QFile::exists(QDir{ m_cluster }.filePath("postmaster.pid")));
+}
+
+QTEST_GUILESS_MAIN(ClusterControlTest)
+#include "tst_pg_ctl.moc"
@@ -0,0 +1,4 @@
+# vi: fenc=utf8
+# qmake tests/tests.pro && make check
+TEMPLATE = subdirs
+SUBDIRS = pg_ctl